@@ -0,0 +1,48 @@
+#include "binary_io.h"
+#include <string.h>
+
+uint32_t bin_read_u32(BinReader *r) {
+  uint32_t v = 0;
+  if ((size_t)(r->end - r->p) < sizeof(v)) {
+    r->failed = 1;
+    return 0;
+  }
+  memcpy(&v, r->p, sizeof(v));
+  r->p += sizeof(v);
+  return v;
+}
+
+uint64_t bin_read_u64(BinReader *r) {
+  uint64_t v = 0;
+  if ((size_t)(r->end - r->p) < sizeof(v)) {
+    r->failed = 1;
+    return 0;
+  }
+  memcpy(&v, r->p, sizeof(v));
+  r->p += sizeof(v);
+  return v;
+}
+
+const char *bin_read_span(BinReader *r, uint64_t len, int nul) {
+  uint64_t need = len + (nul ? 1 : 0);
+  if (r->failed || need < len || (uint64_t)(r->end - r->p) < need ||
+      (nul && r->p[len] != '\0')) {
+    r->failed = 1;
+    return NULL;
+  }
+  const char *span = (const char *)r->p;
+  r->p += need;
+  return span;
+}
+
+int bin_write_u32(FILE *out, uint32_t v) {
+  return fwrite(&v, sizeof(v), 1, out) == 1 ? 0 : -1;
+}
+
+int bin_write_u64(FILE *out, uint64_t v) {
+  return fwrite(&v, sizeof(v), 1, out) == 1 ? 0 : -1;
+}
+
+int bin_write_bytes(FILE *out, const void *data, size_t len) {
+  return len == 0 || fwrite(data, 1, len, out) == len ? 0 : -1;
+}
@@ -0,0 +1,33 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Integers and byte runs of the binary files NoIntl writes for itself
+   (the snapshot, partial reports, the result cache).  Host byte order:
+   they are read back by the same kind of machine.                    */
+
+/* Bounded reader over a file loaded or mapped in memory.  Reading past
+   end sets failed and yields zeros, so a run of reads is checked once
+   at the end.                                                         */
+typedef struct {
+  const unsigned char *p;
+  const unsigned char *end;
+  int failed;
+} BinReader;
+
+uint32_t bin_read_u32(BinReader *r);
+uint64_t bin_read_u64(BinReader *r);
+
+/* Returns the next len bytes in place, or NULL (and failed) if there
+   are fewer.  With nul set they must be followed by a NUL, which is
+   skipped too.                                                       */
+const char *bin_read_span(BinReader *r, uint64_t len, int nul);
+
+/* Each returns 0, or -1 if the write failed */
+int bin_write_u32(FILE *out, uint32_t v);
+int bin_write_u64(FILE *out, uint64_t v);
+int bin_write_bytes(FILE *out, const void *data, size_t len);
+
+#endif /* BINARY_IO_H */
@@ -0,0 +1,193 @@
+#include "byte_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BYTE_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static const char CLASS_BYTES[BS_CLASS_COUNT] = {'\n', '"', '\'', '`',
+                                                 '<',  '>', '{',  '}'};
+
+/* =====================================================================
+   KERNELS - each fills the masks of exactly 64 bytes
+   ===================================================================== */
+
+static void scan_block_c(const char *p, uint64_t *masks) {
+  for (int c = 0; c < BS_CLASS_COUNT; c++) {
+    uint64_t m = 0;
+    for (int i = 0; i < 64; i++)
+      m |= (uint64_t)(p[i] == CLASS_BYTES[c]) << i;
+    masks[c] = m;
+  }
+}
+
+#ifdef BYTE_SCAN_X86
+__attribute__((target("sse2"))) static void scan_block_sse2(const char *p,
+                                                            uint64_t *masks) {
+  __m128i v[4];
+  for (int k = 0; k < 4; k++)
+    v[k] = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+  for (int c = 0; c < BS_CLASS_COUNT; c++) {
+    __m128i needle = _mm_set1_epi8(CLASS_BYTES[c]);
+    uint64_t m = 0;
+    for (int k = 0; k < 4; k++)
+      m |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v[k], needle))
+           << (16 * k);
+    masks[c] = m;
+  }
+}
+
+__attribute__((target("avx2"))) static void scan_block_avx2(const char *p,
+                                                            uint64_t *masks) {
+  __m256i lo = _mm256_loadu_si256((const __m256i *)p);
+  __m256i hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+  for (int c = 0; c < BS_CLASS_COUNT; c++) {
+    __m256i needle = _mm256_set1_epi8(CLASS_BYTES[c]);
+    uint32_t m_lo =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle));
+    uint32_t m_hi =
+        (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle));
+    masks[c] = (uint64_t)m_hi << 32 | m_lo;
+  }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+scan_block_avx512(const char *p, uint64_t *masks) {
+  __m512i v = _mm512_loadu_si512((const void *)p);
+  for (int c = 0; c < BS_CLASS_COUNT; c++)
+    masks[c] = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(CLASS_BYTES[c]));
+}
+#endif
+
+/* =====================================================================
+   DISPATCH
+   ===================================================================== */
+
+typedef void (*BlockKernel)(const char *p, uint64_t *masks);
+
+static BlockKernel kernel = NULL;
+static const char *kernel_name = "c";
+
+/* Picks the widest kernel the CPU runs.  Racing threads all pick the
+   same one, so the first call needs no lock - only atomic accesses,
+   with kernel_name published before kernel.                         */
+static BlockKernel pick_kernel(void) {
+  BlockKernel picked = __atomic_load_n(&kernel, __ATOMIC_ACQUIRE);
+  if (picked)
+    return picked;
+  BlockKernel chosen = scan_block_c;
+  const char *name = "c";
+#ifdef BYTE_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw")) {
+    chosen = scan_block_avx512;
+    name = "avx512";
+  } else if (__builtin_cpu_supports("avx2")) {
+    chosen = scan_block_avx2;
+    name = "avx2";
+  } else if (__builtin_cpu_supports("sse2")) {
+    chosen = scan_block_sse2;
+    name = "sse2";
+  }
+#endif
+  __atomic_store_n(&kernel_name, name, __ATOMIC_RELAXED);
+  __atomic_store_n(&kernel, chosen, __ATOMIC_RELEASE);
+  return chosen;
+}
+
+const char *byte_scan_kernel(void) {
+  pick_kernel();
+  return __atomic_load_n(&kernel_name, __ATOMIC_RELAXED);
+}
+
+void byte_scan_block(const char *p, size_t len,
+                     uint64_t masks[BS_CLASS_COUNT]) {
+  BlockKernel run = pick_kernel();
+  if (len >= 64) {
+    run(p, masks);
+    return;
+  }
+  /* Short tail: pad with NULs, which belong to no class */
+  char block[64] = {0};
+  memcpy(block, p, len);
+  run(block, masks);
+}
+
+/* =====================================================================
+   BUFFER INDEX
+   ===================================================================== */
+
+int byte_index_build(ByteIndex *index, const char *p, size_t len,
+                     unsigned classes) {
+  /* Step 1: Size one bitmap per wanted class */
+  size_t words = (len + 63) / 64;
+  if (words > index->capacity || classes != index->classes) {
+    size_t cap = words > index->capacity ? words : index->capacity;
+    for (int c = 0; c < BS_CLASS_COUNT; c++) {
+      free(index->bits[c]);
+      index->bits[c] = NULL;
+      if (!(classes & (1u << c)))
+        continue;
+      index->bits[c] = malloc((cap ? cap : 1) * sizeof(uint64_t));
+      if (!index->bits[c]) {
+        fprintf(stderr, "Error: malloc failed for ByteIndex\n");
+        byte_index_free(index);
+        return -1;
+      }
+    }
+    index->capacity = cap;
+    index->classes = classes;
+  }
+  index->words = words;
+
+  /* Step 2: One kernel call per 64-byte block */
+  uint64_t masks[BS_CLASS_COUNT];
+  for (size_t w = 0; w < words; w++) {
+    size_t off = w * 64;
+    byte_scan_block(p + off, len - off, masks);
+    for (int c = 0; c < BS_CLASS_COUNT; c++) {
+      if (index->bits[c])
+        index->bits[c][w] = masks[c];
+    }
+  }
+  return 0;
+}
+
+size_t byte_index_next(const ByteIndex *index, int c, size_t from, size_t to) {
+  if (from >= to)
+    return to;
+  const uint64_t *bits = index->bits[c];
+  size_t w = from / 64;
+  uint64_t word = bits[w] & (~0ULL << (from % 64));
+  for (;;) {
+    if (word) {
+      size_t pos = w * 64 + (size_t)__builtin_ctzll(word);
+      return pos < to ? pos : to;
+    }
+    if (++w * 64 >= to)
+      return to;
+    word = bits[w];
+  }
+}
+
+size_t byte_index_count(const ByteIndex *index, int c) {
+  size_t count = 0;
+  for (size_t w = 0; w < index->words; w++)
+    count += (size_t)__builtin_popcountll(index->bits[c][w]);
+  return count;
+}
+
+void byte_index_free(ByteIndex *index) {
+  if (!index)
+    return;
+  for (int c = 0; c < BS_CLASS_COUNT; c++) {
+    free(index->bits[c]);
+    index->bits[c] = NULL;
+  }
+  index->words = 0;
+  index->capacity = 0;
+  index->classes = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bytes the parser looks for, one class each */
+enum {
+  BS_NEWLINE,  /* '\n' */
+  BS_DQUOTE,   /* '"'  */
+  BS_SQUOTE,   /* '\'' */
+  BS_BACKTICK, /* '`'  */
+  BS_LT,       /* '<'  */
+  BS_GT,       /* '>'  */
+  BS_LBRACE,   /* '{'  */
+  BS_RBRACE,   /* '}'  */
+  BS_CLASS_COUNT
+};
+
+/* Sets bit i of masks[c] when p[i] is the byte of class c, for the
+   len (at most 64) bytes at p; bits past len stay clear.  The kernel
+   (AVX-512, AVX2, SSE2 or plain C) is picked once from what the CPU
+   supports.                                                          */
+void byte_scan_block(const char *p, size_t len,
+                     uint64_t masks[BS_CLASS_COUNT]);
+
+/* Name of the kernel byte_scan_block() runs ("avx512", "avx2", ...) */
+const char *byte_scan_kernel(void);
+
+/* Bitmaps of some classes over a whole buffer, so a search can skip 64
+   uninteresting bytes per step.  Reused from buffer to buffer.        */
+typedef struct {
+  uint64_t *bits[BS_CLASS_COUNT]; /* NULL for classes not indexed */
+  size_t words;                   /* 64-bit words per bitmap */
+  size_t capacity;                /* Words allocated per bitmap */
+  unsigned classes;               /* Bit c set = class c indexed */
+} ByteIndex;
+
+/* Indexes the classes in classes (1u << BS_... bits) over p[0..len) */
+int byte_index_build(ByteIndex *index, const char *p, size_t len,
+                     unsigned classes);
+
+/* Offset of the first byte of class c (which must be indexed) in
+   [from, to), or to if there is none                                 */
+size_t byte_index_next(const ByteIndex *index, int c, size_t from, size_t to);
+
+/* Number of bytes of class c (which must be indexed) in the buffer */
+size_t byte_index_count(const ByteIndex *index, int c);
+
+void byte_index_free(ByteIndex *index);
+
+#endif /* BYTE_SCAN_H */
@@ -0,0 +1,503 @@
+#define _POSIX_C_SOURCE 200809L
+#include "content_cache.h"
+#include "binary_io.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#define make_dir(path) _mkdir(path)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#define make_dir(path) mkdir(path, 0777)
+#endif
+
+#define CACHE_MAGIC "NOINTLCC"
+#define CACHE_FORMAT 2
+#define CACHE_FILE "results.bin"
+#define CACHE_LOCK "lock"      /* Held by the run using the directory */
+#define CACHE_HEADER 16        /* magic u32 format u32 stamp */
+#define CACHE_RECORD_HEADER 48 /* See CACHE FILE FORMAT below */
+#define CACHE_USED_AT 16       /* Offset of "used" in a record */
+#define CACHE_KEEP_NUM 3       /* Compaction keeps this share of  */
+#define CACHE_KEEP_DEN 4       /* the cap, so it does not rerun soon */
+
+/* =====================================================================
+   CACHE FILE FORMAT
+   "NOINTLCC" u32 format u32 stamp, then records of
+   u64 key u64 size u64 used u32 status u32 count u64 findings_len
+   u64 check findings (packed, see findings_pack).  key is
+   hash_content() of the file seeded by its extension, size its length
+   in bytes, used the last run (seconds since the epoch) that needed
+   it.  check hashes the rest of the record but used, which is
+   restamped in place.  A later record for the same contents replaces
+   an earlier one.  Host byte order, like the snapshot.
+   ===================================================================== */
+
+/* One cached result, from the mapped file or from this run */
+typedef struct {
+  uint64_t key;
+  uint64_t size;
+  uint64_t used;
+  uint32_t status; /* scan_session_file() result: 0 or a ContentKind */
+  uint32_t count;
+  const char *findings; /* Packed; into the map or owned (added ones) */
+  uint64_t findings_len;
+  uint64_t check;   /* record_check() */
+  long long offset; /* Of the record in the file, -1 = not written yet */
+  int touched;      /* Hit by this run */
+} CacheEntry;
+
+struct ContentCache {
+  char *file;       /* dir/CACHE_FILE */
+  int lock_fd;      /* dir/CACHE_LOCK, locked until the cache is closed */
+  uint32_t stamp;
+  size_t max_bytes;
+  FileBuffer *map;  /* The file as it was opened */
+  size_t file_size; /* Bytes of whole records in it (0 = rewrite) */
+
+  /* Entries of the file, looked up through an open-addressing table;
+     fixed once the cache is open, so lookups need no lock           */
+  CacheEntry *entries;
+  size_t entry_count;
+  size_t *slots; /* Index + 1 into entries, 0 = empty */
+  size_t slot_mask;
+
+  /* Results this run added */
+  pthread_mutex_t lock;
+  CacheEntry *added;
+  size_t added_count;
+  size_t added_capacity;
+};
+
+/* Same bytes under another extension lex differently (.ts has no JSX),
+   so the extension seeds the content hash                             */
+static uint64_t content_key(const char *path, const FileBuffer *buffer) {
+  const char *dot = strrchr(path, '.');
+  const char *slash = strrchr(path, '/');
+  uint64_t seed = dot && (!slash || dot > slash) ? hash_string(dot, 0) : 0;
+  return hash_content(buffer->content, buffer->size, seed);
+}
+
+static CacheEntry *cache_find(const ContentCache *cache, uint64_t key,
+                              uint64_t size) {
+  if (!cache->slots)
+    return NULL;
+  for (size_t slot = (size_t)key & cache->slot_mask;;
+       slot = (slot + 1) & cache->slot_mask) {
+    size_t idx = cache->slots[slot];
+    if (idx == 0)
+      return NULL;
+    CacheEntry *e = &cache->entries[idx - 1];
+    if (e->key == key && e->size == size)
+      return e;
+  }
+}
+
+/* Checksum of a record: every field but used, then the findings */
+static uint64_t record_check(const CacheEntry *e) {
+  uint64_t fields[4] = {e->key, e->size,
+                        (uint64_t)e->status << 32 | e->count,
+                        e->findings_len};
+  uint64_t seed = hash_content(fields, sizeof(fields), 0);
+  return hash_content(e->findings, (size_t)e->findings_len, seed);
+}
+
+/* =====================================================================
+   OPENING
+   ===================================================================== */
+
+/* Opens dir/CACHE_LOCK and locks it without waiting.  Returns the fd,
+   or -1 if another run holds the lock or it cannot be taken.        */
+static int lock_dir(const char *dir) {
+  size_t len = strlen(dir) + sizeof(CACHE_LOCK) + 1;
+  char *path = malloc(len);
+  if (!path)
+    return -1;
+  snprintf(path, len, "%s/%s", dir, CACHE_LOCK);
+#ifdef _WIN32
+  int fd = _open(path, _O_RDWR | _O_CREAT | _O_BINARY, 0666);
+  free(path);
+  if (fd == -1)
+    return -1;
+  OVERLAPPED at = {0};
+  if (!LockFileEx((HANDLE)_get_osfhandle(fd),
+                  LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0,
+                  &at)) {
+    _close(fd);
+    return -1;
+  }
+#else
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  free(path);
+  if (fd == -1)
+    return -1;
+  struct flock lock = {.l_type = F_WRLCK, .l_whence = SEEK_SET};
+  if (fcntl(fd, F_SETLK, &lock) == -1) {
+    close(fd);
+    return -1;
+  }
+#endif
+  return fd;
+}
+
+/* Closing the fd drops the lock */
+static void unlock_dir(int fd) {
+#ifdef _WIN32
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
+
+/* Indexes the records of the mapped file.  A torn or corrupt tail ends
+   the index there; the file is then rewritten on close.             */
+static int cache_index(ContentCache *cache) {
+  const unsigned char *data = (const unsigned char *)cache->map->content;
+  size_t size = cache->map->size;
+  BinReader r = {.p = data, .end = data + size, .failed = 0};
+  if (size < CACHE_HEADER || memcmp(data, CACHE_MAGIC, 8) != 0)
+    return 0;
+  r.p += 8;
+  if (bin_read_u32(&r) != CACHE_FORMAT || bin_read_u32(&r) != cache->stamp)
+    return 0; /* Other parser version or options - start over */
+
+  /* Step 1: Collect the whole records */
+  size_t capacity = 0;
+  size_t valid = CACHE_HEADER;
+  while (r.p < r.end) {
+    CacheEntry e;
+    e.offset = (long long)(r.p - data);
+    e.key = bin_read_u64(&r);
+    e.size = bin_read_u64(&r);
+    e.used = bin_read_u64(&r);
+    e.status = bin_read_u32(&r);
+    e.count = bin_read_u32(&r);
+    e.findings_len = bin_read_u64(&r);
+    e.check = bin_read_u64(&r);
+    e.findings = bin_read_span(&r, e.findings_len, 0);
+    if (r.failed || e.check != record_check(&e))
+      break;
+    e.touched = 0;
+    valid = (size_t)(r.p - data);
+
+    if (cache->entry_count == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      CacheEntry *bigger =
+          realloc(cache->entries, capacity * sizeof(CacheEntry));
+      if (!bigger)
+        return -1;
+      cache->entries = bigger;
+    }
+    cache->entries[cache->entry_count++] = e;
+  }
+
+  /* Step 2: The lookup table, later records replacing earlier ones */
+  size_t slot_count = 16;
+  while (slot_count < cache->entry_count * 2)
+    slot_count *= 2;
+  cache->slots = calloc(slot_count, sizeof(size_t));
+  if (!cache->slots)
+    return -1;
+  cache->slot_mask = slot_count - 1;
+  for (size_t i = 0; i < cache->entry_count; i++) {
+    const CacheEntry *e = &cache->entries[i];
+    size_t slot = (size_t)e->key & cache->slot_mask;
+    while (cache->slots[slot] != 0) {
+      const CacheEntry *old = &cache->entries[cache->slots[slot] - 1];
+      if (old->key == e->key && old->size == e->size)
+        break;
+      slot = (slot + 1) & cache->slot_mask;
+    }
+    cache->slots[slot] = i + 1;
+  }
+  cache->file_size = valid == size ? size : 0;
+  return 0;
+}
+
+ContentCache *cache_open(const char *dir, uint32_t stamp, size_t max_bytes) {
+  /* Step 1: The directory and the file in it */
+  if (!dir)
+    return NULL;
+  if (make_dir(dir) == -1 && errno != EEXIST) {
+    fprintf(stderr, "Error: Cannot create cache directory %s\n", dir);
+    return NULL;
+  }
+  int lock_fd = lock_dir(dir);
+  if (lock_fd == -1) {
+    fprintf(stderr, "Warning: Cache %s is in use by another run, "
+                    "scanning without it\n",
+            dir);
+    return NULL;
+  }
+  ContentCache *cache = calloc(1, sizeof(ContentCache));
+  size_t file_len = strlen(dir) + sizeof(CACHE_FILE) + 1;
+  if (cache) {
+    cache->file = malloc(file_len);
+    cache->map = fb_create(INITIAL_BUFFER_SIZE);
+  }
+  if (!cache || !cache->file || !cache->map) {
+    if (cache) {
+      free(cache->file);
+      fb_free(cache->map);
+    }
+    free(cache);
+    unlock_dir(lock_fd);
+    return NULL;
+  }
+  cache->lock_fd = lock_fd;
+  snprintf(cache->file, file_len, "%s/%s", dir, CACHE_FILE);
+  cache->stamp = stamp;
+  cache->max_bytes = max_bytes;
+  pthread_mutex_init(&cache->lock, NULL);
+
+  /* Step 2: Map and index what earlier runs left (nothing on the first) */
+  struct stat st;
+  if (stat(cache->file, &st) == 0 &&
+      (fb_map_whole(cache->file, cache->map) == -1 ||
+       cache_index(cache) == -1)) {
+    fprintf(stderr, "Warning: Ignoring unreadable cache %s\n", cache->file);
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->entry_count = 0;
+    fb_unmap(cache->map);
+    cache->map->size = 0;
+  }
+  return cache;
+}
+
+/* =====================================================================
+   LOOKUPS
+   ===================================================================== */
+
+int cache_scan_file(ContentCache *cache, ScanSession *session,
+                    const char *path, const FileBuffer *buffer,
+                    FindingList *results) {
+  if (!cache || !buffer || !buffer->content || !results)
+    return scan_session_file(session, path, buffer, results);
+
+  /* Step 1: Seen these bytes before - replay what they gave */
+  uint64_t key = content_key(path, buffer);
+  CacheEntry *hit = cache_find(cache, key, buffer->size);
+  if (hit) {
+    size_t first = results->size;
+    long file = hit->count ? findings_add_path(results, path) : 0;
+    if (file >= 0 &&
+        findings_unpack(results, (uint32_t)file, hit->findings,
+                        (size_t)hit->findings_len, hit->count) == 0) {
+      __atomic_store_n(&hit->touched, 1, __ATOMIC_RELAXED);
+      return (int)hit->status;
+    }
+    results->size = first; /* Bad record: scan after all */
+  }
+
+  /* Step 2: Scan, and keep the result for the next run */
+  size_t first = results->size;
+  int status = scan_session_file(session, path, buffer, results);
+  if (status < 0)
+    return status;
+  size_t len = 0;
+  char *packed = findings_pack(results, first, results->size - first, &len);
+  if (!packed)
+    return status;
+  CacheEntry e = {.key = key,
+                  .size = buffer->size,
+                  .used = (uint64_t)time(NULL),
+                  .status = (uint32_t)status,
+                  .count = (uint32_t)(results->size - first),
+                  .findings = packed,
+                  .findings_len = len,
+                  .offset = -1,
+                  .touched = 1};
+  e.check = record_check(&e);
+  pthread_mutex_lock(&cache->lock);
+  if (cache->added_count == cache->added_capacity) {
+    size_t capacity = cache->added_capacity ? cache->added_capacity * 2 : 64;
+    CacheEntry *bigger = realloc(cache->added, capacity * sizeof(CacheEntry));
+    if (bigger) {
+      cache->added = bigger;
+      cache->added_capacity = capacity;
+    }
+  }
+  if (cache->added_count < cache->added_capacity) {
+    cache->added[cache->added_count++] = e;
+    packed = NULL;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  free(packed);
+  return status;
+}
+
+/* =====================================================================
+   CLOSING
+   ===================================================================== */
+
+static int write_record(FILE *out, const CacheEntry *e) {
+  int err = bin_write_u64(out, e->key);
+  err |= bin_write_u64(out, e->size);
+  err |= bin_write_u64(out, e->used);
+  err |= bin_write_u32(out, e->status);
+  err |= bin_write_u32(out, e->count);
+  err |= bin_write_u64(out, e->findings_len);
+  err |= bin_write_u64(out, e->check);
+  if (e->findings_len > 0 &&
+      fwrite(e->findings, 1, (size_t)e->findings_len, out) != e->findings_len)
+    err = -1;
+  return err;
+}
+
+static size_t record_bytes(const CacheEntry *e) {
+  return CACHE_RECORD_HEADER + (size_t)e->findings_len;
+}
+
+/* Most recently used first; among equals, the later record */
+static int compare_recent_first(const void *a, const void *b) {
+  const CacheEntry *x = *(const CacheEntry *const *)a;
+  const CacheEntry *y = *(const CacheEntry *const *)b;
+  if (x->used != y->used)
+    return x->used > y->used ? -1 : 1;
+  return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+/* Writes the live entries, most recently used first, until keep bytes
+   are used, to a new file that then replaces the old one            */
+static int cache_rewrite(ContentCache *cache, size_t keep) {
+  /* Step 1: Live entries: the ones the table points at, and this run's */
+  size_t total = cache->entry_count + cache->added_count;
+  CacheEntry **order = malloc((total + 1) * sizeof(CacheEntry *));
+  if (!order)
+    return -1;
+  size_t n = 0;
+  for (size_t s = 0; cache->slots && s <= cache->slot_mask; s++) {
+    if (cache->slots[s] != 0)
+      order[n++] = &cache->entries[cache->slots[s] - 1];
+  }
+  for (size_t i = 0; i < cache->added_count; i++)
+    order[n++] = &cache->added[i];
+  qsort(order, n, sizeof(CacheEntry *), compare_recent_first);
+
+  /* Step 2: Write them to a new temporary file next to the cache */
+  size_t tmp_len = strlen(cache->file) + 8;
+  char *tmp = malloc(tmp_len);
+  FILE *out = NULL;
+  if (tmp) {
+    snprintf(tmp, tmp_len, "%s.XXXXXX", cache->file);
+#ifdef _WIN32
+    if (_mktemp_s(tmp, tmp_len) == 0)
+      out = fopen(tmp, "wb");
+#else
+    int fd = mkstemp(tmp);
+    if (fd != -1 && !(out = fdopen(fd, "wb"))) {
+      close(fd);
+      remove(tmp);
+    }
+#endif
+  }
+  if (!out) {
+    free(tmp);
+    free(order);
+    return -1;
+  }
+  int err = fwrite(CACHE_MAGIC, 1, 8, out) == 8 ? 0 : -1;
+  err |= bin_write_u32(out, CACHE_FORMAT);
+  err |= bin_write_u32(out, cache->stamp);
+  size_t used = CACHE_HEADER;
+  for (size_t i = 0; i < n && !err; i++) {
+    if (used + record_bytes(order[i]) > keep)
+      continue; /* Smaller, older entries may still fit */
+    err |= write_record(out, order[i]);
+    used += record_bytes(order[i]);
+  }
+  if (fclose(out) != 0)
+    err = -1;
+
+  /* Step 3: Replace the old file; its map stays valid until freed */
+  if (!err) {
+#ifdef _WIN32
+    fb_unmap(cache->map); /* Windows cannot replace a mapped file */
+    remove(cache->file);
+#endif
+    err = rename(tmp, cache->file);
+  }
+  if (err)
+    remove(tmp);
+  free(tmp);
+  free(order);
+  return err ? -1 : 0;
+}
+
+/* Appends this run's entries and restamps the entries it hit */
+static int cache_append(ContentCache *cache, uint64_t now) {
+  FILE *out = fopen(cache->file, "r+b");
+  if (!out)
+    return -1;
+  int err = 0;
+  for (size_t i = 0; i < cache->entry_count && !err; i++) {
+    const CacheEntry *e = &cache->entries[i];
+    if (!e->touched)
+      continue;
+    if (fseek(out, (long)(e->offset + CACHE_USED_AT), SEEK_SET) != 0)
+      err = -1;
+    else
+      err |= bin_write_u64(out, now);
+  }
+  if (!err && fseek(out, 0, SEEK_END) != 0)
+    err = -1;
+  for (size_t i = 0; i < cache->added_count && !err; i++)
+    err |= write_record(out, &cache->added[i]);
+  if (fclose(out) != 0)
+    err = -1;
+  return err;
+}
+
+int cache_close(ContentCache *cache) {
+  if (!cache)
+    return 0;
+
+  /* Step 1: How big the file gets if the new results are appended */
+  uint64_t now = (uint64_t)time(NULL);
+  size_t grown = cache->file_size;
+  int touched = 0;
+  for (size_t i = 0; i < cache->added_count; i++)
+    grown += record_bytes(&cache->added[i]);
+  for (size_t i = 0; i < cache->entry_count; i++) {
+    if (cache->entries[i].touched) {
+      cache->entries[i].used = now;
+      touched = 1;
+    }
+  }
+
+  /* Step 2: Append in place, or rewrite: new, torn, or over the cap */
+  int err = 0;
+  size_t keep = cache->max_bytes;
+  if (grown > cache->max_bytes)
+    keep = cache->max_bytes / CACHE_KEEP_DEN * CACHE_KEEP_NUM;
+  if (cache->file_size == 0 || grown > cache->max_bytes)
+    err = cache_rewrite(cache, keep);
+  else if (cache->added_count > 0 || touched)
+    err = cache_append(cache, now);
+  if (err)
+    fprintf(stderr, "Warning: Failed to update cache %s\n", cache->file);
+
+  /* Step 3: Free everything */
+  for (size_t i = 0; i < cache->added_count; i++)
+    free((char *)cache->added[i].findings);
+  free(cache->added);
+  free(cache->entries);
+  free(cache->slots);
+  fb_free(cache->map);
+  pthread_mutex_destroy(&cache->lock);
+  free(cache->file);
+  unlock_dir(cache->lock_fd);
+  free(cache);
+  return err ? -1 : 0;
+}
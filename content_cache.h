@@ -0,0 +1,37 @@
+#ifndef CONTENT_CACHE_H
+#define CONTENT_CACHE_H
+
+#include "file_reader.h"
+#include "findings.h"
+#include "text_parser.h"
+#include <stdint.h>
+
+/* Results of earlier runs keyed by file contents, so a file that was
+   checked out again (new mtime, same bytes) is not scanned again.
+   The cache is one append-only file in a directory: it is mapped when
+   opened, new results are appended when it is closed, and it is
+   rewritten without the least recently used entries once it grows past
+   its size cap.  The run using a cache directory holds a lock on it;
+   another run started meanwhile goes without the cache.  Every record
+   carries a checksum, and the index stops at the first bad one.      */
+typedef struct ContentCache ContentCache;
+
+#define CACHE_DEFAULT_SIZE (64 * 1024 * 1024) /* Size cap of the file */
+
+/* Opens the cache in dir (created if missing) and locks it.  Entries
+   written with another stamp (parser version and options) are dropped.
+   Returns NULL if dir cannot be used or another run holds it.        */
+ContentCache *cache_open(const char *dir, uint32_t stamp, size_t max_bytes);
+
+/* Does what scan_session_file() does, but replays the findings saved
+   for the same contents instead when the cache has them.  Safe to call
+   from several threads at once; cache may be NULL.                   */
+int cache_scan_file(ContentCache *cache, ScanSession *session,
+                    const char *path, const FileBuffer *buffer,
+                    FindingList *results);
+
+/* Writes out the new results and which entries were used, compacts
+   the file if it is over its cap, and frees the cache               */
+int cache_close(ContentCache *cache);
+
+#endif /* CONTENT_CACHE_H */
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #define INITIAL_CAPACITY 8
+#define PATH_ARENA_BLOCK (64 * 1024)
 
 /* TODO: We'll implement these functions step by step */
 
@@ -56,6 +57,47 @@ int da_append(DynamicArray *arr, const char *str) {
   return 0; /* Success */
 }
 
+/* Moves every string of src to the end of dest without copying them.
+   On success src is left empty (but still allocated).               */
+int da_merge(DynamicArray *dest, DynamicArray *src) {
+  if (!dest || !src)
+    return -1;
+  if (src->size == 0)
+    return 0;
+
+  /* Step 1: Grow dest once to fit both arrays */
+  size_t needed = dest->size + src->size;
+  if (needed > dest->capacity) {
+    size_t new_capacity = dest->capacity;
+    while (new_capacity < needed)
+      new_capacity *= 2;
+    char **new_strings = realloc(dest->strings, new_capacity * sizeof(char *));
+    if (!new_strings) {
+      return -1; /* Growth failed, both arrays still intact */
+    }
+    dest->strings = new_strings;
+    dest->capacity = new_capacity;
+  }
+
+  /* Step 2: Hand the string pointers over - ownership moves to dest */
+  memcpy(dest->strings + dest->size, src->strings,
+         src->size * sizeof(char *));
+  dest->size = needed;
+  src->size = 0;
+
+  return 0;
+}
+
+/* Frees every string but keeps the pointer array for reuse */
+void da_clear(DynamicArray *arr) {
+  if (!arr)
+    return;
+  for (size_t i = 0; i < arr->size; i++) {
+    free(arr->strings[i]);
+  }
+  arr->size = 0;
+}
+
 void da_free(DynamicArray *arr) {
   if (!arr)
     return;
@@ -88,3 +130,687 @@ void da_print(const DynamicArray *arr) {
     }
   }
 }
+
+/* =====================================================================
+   FILE LIST - walker output: path + size carried to the reader
+   ===================================================================== */
+
+FileList *fl_create(void) {
+  FileList *fl = malloc(sizeof(FileList));
+  if (!fl) {
+    return NULL;
+  }
+
+  fl->files = malloc(INITIAL_CAPACITY * sizeof(TargetFile));
+  fl->arena = arena_create(PATH_ARENA_BLOCK);
+  if (!fl->files || !fl->arena) {
+    free(fl->files);
+    arena_free(fl->arena);
+    free(fl);
+    return NULL;
+  }
+
+  fl->size = 0;
+  fl->capacity = INITIAL_CAPACITY;
+  return fl;
+}
+
+/* Room for a path of len bytes and its NUL, freed with the list.  The
+   walker joins paths straight into it, so no path is copied twice.   */
+char *fl_path_alloc(FileList *list, size_t len) {
+  return arena_alloc(list->arena, len + 1);
+}
+
+/* Appends a record.  path must come from fl_path_alloc on this list
+   (or otherwise outlive it); fl_free does not free it on its own.    */
+int fl_append(FileList *list, char *path, long long size) {
+  TargetFile entry = {
+      .path = path, .size = size, .mtime_ns = 0, .ino = 0, .dev = 0};
+  return fl_append_entry(list, &entry);
+}
+
+int fl_append_entry(FileList *list, const TargetFile *entry) {
+  if (list->size >= list->capacity) {
+    size_t new_capacity = list->capacity * 2;
+    TargetFile *new_files =
+        realloc(list->files, new_capacity * sizeof(TargetFile));
+    if (!new_files) {
+      return -1;
+    }
+    list->files = new_files;
+    list->capacity = new_capacity;
+  }
+
+  list->files[list->size] = *entry;
+  list->size++;
+  return 0;
+}
+
+/* Moves every record of src to the end of dest; src is left empty */
+int fl_merge(FileList *dest, FileList *src) {
+  if (!dest || !src)
+    return -1;
+  if (src->size == 0)
+    return 0;
+
+  size_t needed = dest->size + src->size;
+  if (needed > dest->capacity) {
+    size_t new_capacity = dest->capacity;
+    while (new_capacity < needed)
+      new_capacity *= 2;
+    TargetFile *new_files =
+        realloc(dest->files, new_capacity * sizeof(TargetFile));
+    if (!new_files) {
+      return -1;
+    }
+    dest->files = new_files;
+    dest->capacity = new_capacity;
+  }
+
+  /* The paths move with their blocks, so no string is copied */
+  memcpy(dest->files + dest->size, src->files,
+         src->size * sizeof(TargetFile));
+  arena_adopt(dest->arena, src->arena);
+  dest->size = needed;
+  src->size = 0;
+  return 0;
+}
+
+static int compare_paths(const void *a, const void *b) {
+  return strcmp(((const TargetFile *)a)->path, ((const TargetFile *)b)->path);
+}
+
+void fl_sort(FileList *list) {
+  if (list && list->size > 1)
+    qsort(list->files, list->size, sizeof(TargetFile), compare_paths);
+}
+
+/* Restores the heap property below slot i: heap holds run numbers,
+   ordered by the path each run has next                          */
+static void run_heap_down(size_t *heap, size_t size, FileList *const *runs,
+                          const size_t *next, size_t i) {
+  for (;;) {
+    size_t least = i;
+    for (size_t c = 2 * i + 1; c <= 2 * i + 2 && c < size; c++) {
+      if (strcmp(runs[heap[c]]->files[next[heap[c]]].path,
+                 runs[heap[least]]->files[next[heap[least]]].path) < 0)
+        least = c;
+    }
+    if (least == i)
+      return;
+    size_t tmp = heap[i];
+    heap[i] = heap[least];
+    heap[least] = tmp;
+    i = least;
+  }
+}
+
+/* Moves the records of runs[0, count), each already sorted by path,
+   to the end of dest in path order (a k-way merge: one comparison
+   per record and level of the heap, never a sort of everything).
+   The runs are left empty; their paths move with their arenas.     */
+int fl_merge_sorted(FileList *dest, FileList *const *runs, size_t count) {
+  if (!dest || !runs)
+    return -1;
+
+  /* Step 1: Grow dest once to fit every run */
+  size_t needed = dest->size;
+  for (size_t r = 0; r < count; r++)
+    needed += runs[r]->size;
+  if (needed > dest->capacity) {
+    size_t new_capacity = dest->capacity;
+    while (new_capacity < needed)
+      new_capacity *= 2;
+    TargetFile *new_files =
+        realloc(dest->files, new_capacity * sizeof(TargetFile));
+    if (!new_files)
+      return -1;
+    dest->files = new_files;
+    dest->capacity = new_capacity;
+  }
+
+  /* Step 2: A heap of the runs that still have records */
+  size_t *heap = malloc((count + 1) * sizeof(size_t));
+  size_t *next = calloc(count + 1, sizeof(size_t));
+  if (!heap || !next) {
+    free(heap);
+    free(next);
+    return -1;
+  }
+  size_t live = 0;
+  for (size_t r = 0; r < count; r++) {
+    if (runs[r]->size > 0)
+      heap[live++] = r;
+  }
+  for (size_t i = live / 2; i-- > 0;)
+    run_heap_down(heap, live, runs, next, i);
+
+  /* Step 3: Take the smallest next path until every run is drained */
+  while (live > 0) {
+    size_t r = heap[0];
+    dest->files[dest->size++] = runs[r]->files[next[r]++];
+    if (next[r] == runs[r]->size)
+      heap[0] = heap[--live];
+    run_heap_down(heap, live, runs, next, 0);
+  }
+
+  for (size_t r = 0; r < count; r++) {
+    arena_adopt(dest->arena, runs[r]->arena);
+    runs[r]->size = 0;
+  }
+  free(heap);
+  free(next);
+  return 0;
+}
+
+void fl_free(FileList *list) {
+  if (!list)
+    return;
+  arena_free(list->arena);
+  free(list->files);
+  free(list);
+}
+
+/* =====================================================================
+   HASH MAP - string keys, linear probing
+   ===================================================================== */
+
+/* FNV-1a; seed lets callers chain several strings into one hash */
+uint32_t hash_string(const char *str, uint32_t seed) {
+  uint32_t h = seed ? seed : 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* Same hash over len bytes, which need no NUL terminator */
+uint32_t hash_bytes(const char *str, size_t len, uint32_t seed) {
+  uint32_t h = seed ? seed : 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)str; len > 0;
+       p++, len--) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* XXH64: a 64-bit hash of file contents, four lanes of 8 bytes at a
+   time - fast enough to run over every file read and wide enough to
+   key results by content                                          */
+#define XXH_PRIME1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME3 0x165667B19E3779F9ULL
+#define XXH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t load64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input) {
+  acc += input * XXH_PRIME2;
+  return rotl64(acc, 31) * XXH_PRIME1;
+}
+
+static uint64_t xxh_merge(uint64_t acc, uint64_t lane) {
+  acc ^= xxh_round(0, lane);
+  return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+uint64_t hash_content(const void *data, size_t len, uint64_t seed) {
+  const unsigned char *p = data;
+  const unsigned char *end = p + len;
+  uint64_t h;
+
+  /* Step 1: 32-byte stripes over four accumulators */
+  if (len >= 32) {
+    uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+    uint64_t v2 = seed + XXH_PRIME2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - XXH_PRIME1;
+    for (; end - p >= 32; p += 32) {
+      v1 = xxh_round(v1, load64(p));
+      v2 = xxh_round(v2, load64(p + 8));
+      v3 = xxh_round(v3, load64(p + 16));
+      v4 = xxh_round(v4, load64(p + 24));
+    }
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = xxh_merge(xxh_merge(xxh_merge(xxh_merge(h, v1), v2), v3), v4);
+  } else {
+    h = seed + XXH_PRIME5;
+  }
+  h += (uint64_t)len;
+
+  /* Step 2: The tail, 8, 4 and 1 bytes at a time */
+  for (; end - p >= 8; p += 8)
+    h = rotl64(h ^ xxh_round(0, load64(p)), 27) * XXH_PRIME1 + XXH_PRIME4;
+  if (end - p >= 4) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    h = rotl64(h ^ (uint64_t)v * XXH_PRIME1, 23) * XXH_PRIME2 + XXH_PRIME3;
+    p += 4;
+  }
+  for (; p < end; p++)
+    h = rotl64(h ^ *p * XXH_PRIME5, 11) * XXH_PRIME1;
+
+  /* Step 3: Avalanche */
+  h ^= h >> 33;
+  h *= XXH_PRIME2;
+  h ^= h >> 29;
+  h *= XXH_PRIME3;
+  h ^= h >> 32;
+  return h;
+}
+
+HashMap *hm_create(size_t expected) {
+  HashMap *map = malloc(sizeof(HashMap));
+  if (!map)
+    return NULL;
+
+  /* Keep the load factor under 1/2 for the expected size */
+  size_t capacity = INITIAL_CAPACITY;
+  while (capacity < expected * 2)
+    capacity *= 2;
+
+  map->keys = calloc(capacity, sizeof(const char *));
+  map->values = malloc(capacity * sizeof(size_t));
+  if (!map->keys || !map->values) {
+    free(map->keys);
+    free(map->values);
+    free(map);
+    return NULL;
+  }
+  map->size = 0;
+  map->capacity = capacity;
+  return map;
+}
+
+static int hm_grow(HashMap *map) {
+  size_t new_capacity = map->capacity * 2;
+  const char **keys = calloc(new_capacity, sizeof(const char *));
+  size_t *values = malloc(new_capacity * sizeof(size_t));
+  if (!keys || !values) {
+    free(keys);
+    free(values);
+    return -1;
+  }
+
+  /* Re-insert every key into the bigger table */
+  for (size_t i = 0; i < map->capacity; i++) {
+    if (!map->keys[i])
+      continue;
+    size_t slot = hash_string(map->keys[i], 0) & (new_capacity - 1);
+    while (keys[slot])
+      slot = (slot + 1) & (new_capacity - 1);
+    keys[slot] = map->keys[i];
+    values[slot] = map->values[i];
+  }
+
+  free(map->keys);
+  free(map->values);
+  map->keys = keys;
+  map->values = values;
+  map->capacity = new_capacity;
+  return 0;
+}
+
+/* Inserts key or overwrites its value */
+int hm_put(HashMap *map, const char *key, size_t value) {
+  if ((map->size + 1) * 10 > map->capacity * 7 && hm_grow(map) == -1)
+    return -1;
+
+  size_t slot = hash_string(key, 0) & (map->capacity - 1);
+  while (map->keys[slot] && strcmp(map->keys[slot], key) != 0)
+    slot = (slot + 1) & (map->capacity - 1);
+  if (!map->keys[slot]) {
+    map->keys[slot] = key;
+    map->size++;
+  }
+  map->values[slot] = value;
+  return 0;
+}
+
+/* Returns 1 and fills *value if key is present, 0 otherwise */
+int hm_get(const HashMap *map, const char *key, size_t *value) {
+  if (!map)
+    return 0;
+  size_t slot = hash_string(key, 0) & (map->capacity - 1);
+  while (map->keys[slot]) {
+    if (strcmp(map->keys[slot], key) == 0) {
+      *value = map->values[slot];
+      return 1;
+    }
+    slot = (slot + 1) & (map->capacity - 1);
+  }
+  return 0;
+}
+
+/* hm_get() for the len bytes at key, which need no NUL terminator */
+int hm_get_span(const HashMap *map, const char *key, size_t len,
+                size_t *value) {
+  if (!map)
+    return 0;
+  size_t slot = hash_bytes(key, len, 0) & (map->capacity - 1);
+  while (map->keys[slot]) {
+    if (strncmp(map->keys[slot], key, len) == 0 &&
+        map->keys[slot][len] == '\0') {
+      *value = map->values[slot];
+      return 1;
+    }
+    slot = (slot + 1) & (map->capacity - 1);
+  }
+  return 0;
+}
+
+/* Empties map, keeping its slots */
+void hm_clear(HashMap *map) {
+  if (!map || map->size == 0)
+    return;
+  memset(map->keys, 0, map->capacity * sizeof(const char *));
+  map->size = 0;
+}
+
+void hm_free(HashMap *map) {
+  if (!map)
+    return;
+  free(map->keys);
+  free(map->values);
+  free(map);
+}
+
+/* =====================================================================
+   ARENA - bump allocation in growing blocks
+   ===================================================================== */
+
+Arena *arena_create(size_t block_size) {
+  Arena *arena = malloc(sizeof(Arena));
+  if (!arena)
+    return NULL;
+  arena->head = NULL;
+  arena->block_size = block_size ? block_size : 64 * 1024;
+  arena->total = 0;
+  return arena;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  size = (size + 7) & ~(size_t)7;
+
+  /* Step 1: Open a new block when the current one is full; an
+     allocation bigger than a block gets a block of its own          */
+  ArenaBlock *block = arena->head;
+  if (!block || block->size - block->used < size) {
+    size_t data_size = size > arena->block_size ? size : arena->block_size;
+    block = malloc(sizeof(ArenaBlock) + data_size);
+    if (!block)
+      return NULL;
+    block->size = data_size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+  }
+
+  /* Step 2: Carve from the front */
+  void *p = block->data + block->used;
+  block->used += size;
+  arena->total += size;
+  return p;
+}
+
+/* NUL-terminated copy of len bytes of str */
+char *arena_strndup(Arena *arena, const char *str, size_t len) {
+  char *copy = arena_alloc(arena, len + 1);
+  if (!copy)
+    return NULL;
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  return copy;
+}
+
+void arena_clear(Arena *arena) {
+  if (!arena || !arena->head)
+    return;
+  ArenaBlock *block = arena->head->next;
+  while (block) {
+    ArenaBlock *older = block->next;
+    free(block);
+    block = older;
+  }
+  arena->head->next = NULL;
+  arena->head->used = 0;
+  arena->total = 0;
+}
+
+/* Hands every block of src to dest, behind the block dest is carving,
+   and leaves src empty.  Whatever was allocated from src now lives as
+   long as dest.                                                       */
+void arena_adopt(Arena *dest, Arena *src) {
+  if (!src->head)
+    return;
+  ArenaBlock *tail = src->head;
+  while (tail->next)
+    tail = tail->next;
+  if (dest->head) {
+    tail->next = dest->head->next;
+    dest->head->next = src->head;
+  } else {
+    dest->head = src->head;
+  }
+  dest->total += src->total;
+  src->head = NULL;
+  src->total = 0;
+}
+
+void arena_free(Arena *arena) {
+  if (!arena)
+    return;
+  ArenaBlock *block = arena->head;
+  while (block) {
+    ArenaBlock *older = block->next;
+    free(block);
+    block = older;
+  }
+  free(arena);
+}
+
+/* =====================================================================
+   STRING VECTOR - strings packed into arena blocks
+   ===================================================================== */
+
+StringVec *sv_create(size_t block_size) {
+  StringVec *vec = malloc(sizeof(StringVec));
+  if (!vec)
+    return NULL;
+  vec->strings = malloc(INITIAL_CAPACITY * sizeof(char *));
+  vec->lengths = malloc(INITIAL_CAPACITY * sizeof(size_t));
+  vec->arena = arena_create(block_size);
+  if (!vec->strings || !vec->lengths || !vec->arena) {
+    sv_free(vec);
+    return NULL;
+  }
+  vec->size = 0;
+  vec->capacity = INITIAL_CAPACITY;
+  return vec;
+}
+
+static int sv_reserve(StringVec *vec, size_t needed) {
+  if (needed <= vec->capacity)
+    return 0;
+  size_t new_capacity = vec->capacity;
+  while (new_capacity < needed)
+    new_capacity *= 2;
+  char **new_strings = realloc(vec->strings, new_capacity * sizeof(char *));
+  if (!new_strings)
+    return -1;
+  vec->strings = new_strings;
+  size_t *new_lengths = realloc(vec->lengths, new_capacity * sizeof(size_t));
+  if (!new_lengths)
+    return -1; /* strings[] grew, capacity did not - still consistent */
+  vec->lengths = new_lengths;
+  vec->capacity = new_capacity;
+  return 0;
+}
+
+int sv_append(StringVec *vec, const char *str) {
+  return sv_append_n(vec, str, strlen(str));
+}
+
+/* Appends a NUL-terminated copy of str[0..len) */
+int sv_append_n(StringVec *vec, const char *str, size_t len) {
+  if (sv_reserve(vec, vec->size + 1) == -1)
+    return -1;
+  char *copy = arena_strndup(vec->arena, str, len);
+  if (!copy)
+    return -1;
+  vec->strings[vec->size] = copy;
+  vec->lengths[vec->size] = len;
+  vec->size++;
+  return 0;
+}
+
+/* Moves every string of src to the end of dest along with the blocks
+   holding them.  On success src is left empty (but still allocated). */
+int sv_merge(StringVec *dest, StringVec *src) {
+  if (!dest || !src)
+    return -1;
+  if (src->size == 0)
+    return 0;
+  if (sv_reserve(dest, dest->size + src->size) == -1)
+    return -1;
+  memcpy(dest->strings + dest->size, src->strings,
+         src->size * sizeof(char *));
+  memcpy(dest->lengths + dest->size, src->lengths,
+         src->size * sizeof(size_t));
+  arena_adopt(dest->arena, src->arena);
+  dest->size += src->size;
+  src->size = 0;
+  return 0;
+}
+
+/* Drops every string but keeps the arrays and one block for reuse */
+void sv_clear(StringVec *vec) {
+  if (!vec)
+    return;
+  arena_clear(vec->arena);
+  vec->size = 0;
+}
+
+void sv_free(StringVec *vec) {
+  if (!vec)
+    return;
+  arena_free(vec->arena);
+  free(vec->strings);
+  free(vec->lengths);
+  free(vec);
+}
+
+/* =====================================================================
+   INODE SET - (dev, ino) pairs, linear probing
+   ===================================================================== */
+
+InodeSet *inode_set_create(void) {
+  InodeSet *set = malloc(sizeof(InodeSet));
+  if (!set)
+    return NULL;
+
+  set->devs = malloc(INITIAL_CAPACITY * sizeof(unsigned long long));
+  set->inos = calloc(INITIAL_CAPACITY, sizeof(unsigned long long));
+  set->values = malloc(INITIAL_CAPACITY * sizeof(size_t));
+  if (!set->devs || !set->inos || !set->values) {
+    free(set->devs);
+    free(set->inos);
+    free(set->values);
+    free(set);
+    return NULL;
+  }
+  set->size = 0;
+  set->capacity = INITIAL_CAPACITY;
+  return set;
+}
+
+static size_t inode_slot(unsigned long long dev, unsigned long long ino,
+                         size_t capacity) {
+  uint64_t h = (ino ^ (dev * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+  return (size_t)(h >> 32) & (capacity - 1);
+}
+
+static int inode_set_grow(InodeSet *set) {
+  size_t new_capacity = set->capacity * 2;
+  unsigned long long *devs = malloc(new_capacity * sizeof(unsigned long long));
+  unsigned long long *inos = calloc(new_capacity, sizeof(unsigned long long));
+  size_t *values = malloc(new_capacity * sizeof(size_t));
+  if (!devs || !inos || !values) {
+    free(devs);
+    free(inos);
+    free(values);
+    return -1;
+  }
+
+  for (size_t i = 0; i < set->capacity; i++) {
+    if (!set->inos[i])
+      continue;
+    size_t slot = inode_slot(set->devs[i], set->inos[i], new_capacity);
+    while (inos[slot])
+      slot = (slot + 1) & (new_capacity - 1);
+    devs[slot] = set->devs[i];
+    inos[slot] = set->inos[i];
+    values[slot] = set->values[i];
+  }
+
+  free(set->devs);
+  free(set->inos);
+  free(set->values);
+  set->devs = devs;
+  set->inos = inos;
+  set->values = values;
+  set->capacity = new_capacity;
+  return 0;
+}
+
+/* Returns 1 if the pair was added, 0 if it was already there */
+int inode_set_insert(InodeSet *set, unsigned long long dev,
+                     unsigned long long ino) {
+  size_t existing;
+  return inode_set_insert_value(set, dev, ino, 0, &existing);
+}
+
+/* Like inode_set_insert(), but stores value with a new pair.  For a
+   pair already there, *existing is set to the value stored with it. */
+int inode_set_insert_value(InodeSet *set, unsigned long long dev,
+                           unsigned long long ino, size_t value,
+                           size_t *existing) {
+  if (ino == 0)
+    return 1; /* Unknown inode - cannot be a duplicate */
+  if ((set->size + 1) * 10 > set->capacity * 7 && inode_set_grow(set) == -1)
+    return -1;
+
+  size_t slot = inode_slot(dev, ino, set->capacity);
+  while (set->inos[slot]) {
+    if (set->inos[slot] == ino && set->devs[slot] == dev) {
+      *existing = set->values[slot];
+      return 0;
+    }
+    slot = (slot + 1) & (set->capacity - 1);
+  }
+  set->devs[slot] = dev;
+  set->inos[slot] = ino;
+  set->values[slot] = value;
+  set->size++;
+  return 1;
+}
+
+void inode_set_free(InodeSet *set) {
+  if (!set)
+    return;
+  free(set->devs);
+  free(set->inos);
+  free(set->values);
+  free(set);
+}
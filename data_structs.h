@@ -1,6 +1,7 @@
 #ifndef DATA_STRUCTS_H
 #define DATA_STRUCTS_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 /* Dynamic String Array - our foundational data structure */
@@ -10,10 +11,118 @@ typedef struct {
   size_t capacity; /* Total allocated space */
 } DynamicArray;
 
+/* A file picked by the directory walker */
+typedef struct {
+  char *path;             /* Full path to the file */
+  long long size;         /* Size in bytes, or -1 if never stat'ed */
+  long long mtime_ns;     /* Modification time in ns, 0 if never stat'ed */
+  unsigned long long ino; /* Inode number, 0 if never stat'ed */
+  unsigned long long dev; /* Device, 0 if never stat'ed */
+} TargetFile;
+
+/* Growable list of TargetFiles.  Paths are carved from the list's
+   arena (fl_path_alloc), so freeing the list costs one free() per
+   block instead of one per file.                                    */
+typedef struct {
+  TargetFile *files;    /* Array of file records */
+  size_t size;          /* Current number of files */
+  size_t capacity;      /* Total allocated space */
+  struct Arena *arena;  /* Every path of files */
+} FileList;
+
+/* String -> index map (open addressing).  Keys are borrowed: they
+   must stay valid for as long as the map is used.                   */
+typedef struct {
+  const char **keys; /* NULL = empty slot */
+  size_t *values;
+  size_t size;       /* Number of keys stored */
+  size_t capacity;   /* Slots, always a power of two */
+} HashMap;
+
+/* Set of (device, inode) pairs - identifies files and directories
+   reached through more than one path (symlinks, hard links)         */
+typedef struct {
+  unsigned long long *devs;
+  unsigned long long *inos; /* 0 = empty slot (no real inode is 0) */
+  size_t *values;           /* See inode_set_insert_value() */
+  size_t size;
+  size_t capacity;          /* Always a power of two */
+} InodeSet;
+
+/* Bump allocator: many small allocations that all die together.  Each
+   block is carved from the front; nothing is freed on its own.       */
+typedef struct ArenaBlock {
+  struct ArenaBlock *next; /* Older block */
+  size_t size;             /* Bytes of data */
+  size_t used;
+  char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+  ArenaBlock *head;  /* Block being carved, NULL before the first alloc */
+  size_t block_size; /* Default size of a new block */
+  size_t total;      /* Bytes handed out since the last clear */
+} Arena;
+
+/* String vector whose strings live in an arena: appending copies into
+   the current block, clearing and freeing cost O(blocks), not
+   O(strings).  strings[] reads like DynamicArray's.                  */
+typedef struct {
+  char **strings;  /* NUL-terminated, in arena */
+  size_t *lengths; /* strlen() of each string */
+  size_t size;
+  size_t capacity;
+  Arena *arena;
+} StringVec;
+
 /* Function declarations */
 DynamicArray *da_create(void);
 int da_append(DynamicArray *arr, const char *str);
+int da_merge(DynamicArray *dest, DynamicArray *src);
+void da_clear(DynamicArray *arr);
 void da_free(DynamicArray *arr);
 void da_print(const DynamicArray *arr);
 
+FileList *fl_create(void);
+char *fl_path_alloc(FileList *list, size_t len); /* len + 1 bytes */
+int fl_append(FileList *list, char *path, long long size);
+int fl_append_entry(FileList *list, const TargetFile *entry);
+int fl_merge(FileList *dest, FileList *src);
+void fl_sort(FileList *list); /* By path, byte order */
+int fl_merge_sorted(FileList *dest, FileList *const *runs, size_t count);
+void fl_free(FileList *list);
+
+HashMap *hm_create(size_t expected);
+int hm_put(HashMap *map, const char *key, size_t value);
+int hm_get(const HashMap *map, const char *key, size_t *value);
+int hm_get_span(const HashMap *map, const char *key, size_t len,
+                size_t *value);
+void hm_clear(HashMap *map);
+void hm_free(HashMap *map);
+uint32_t hash_string(const char *str, uint32_t seed);
+uint32_t hash_bytes(const char *str, size_t len, uint32_t seed);
+uint64_t hash_content(const void *data, size_t len, uint64_t seed);
+
+Arena *arena_create(size_t block_size);
+void *arena_alloc(Arena *arena, size_t size); /* 8-byte aligned */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+void arena_clear(Arena *arena); /* Frees all but the newest block */
+void arena_adopt(Arena *dest, Arena *src); /* Moves src's blocks */
+void arena_free(Arena *arena);
+
+StringVec *sv_create(size_t block_size);
+int sv_append(StringVec *vec, const char *str);
+int sv_append_n(StringVec *vec, const char *str, size_t len);
+int sv_merge(StringVec *dest, StringVec *src);
+void sv_clear(StringVec *vec);
+void sv_free(StringVec *vec);
+
+InodeSet *inode_set_create(void);
+int inode_set_insert(InodeSet *set, unsigned long long dev,
+                     unsigned long long ino); /* 1 = new, 0 = seen */
+int inode_set_insert_value(InodeSet *set, unsigned long long dev,
+                           unsigned long long ino, size_t value,
+                           size_t *existing);
+void inode_set_free(InodeSet *set);
+
 #endif
@@ -1,112 +1,469 @@
+#define _DEFAULT_SOURCE /* d_type / DT_* constants */
+#define _POSIX_C_SOURCE 200809L
 #include "directory.h"
+#include "git_index.h"
 #include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
-#define INITIAL_EXT_CAPACITY 8
+/* =====================================================================
+   PARALLEL WALKER
+   Every worker owns a deque of pending directories.  The owner pushes
+   and pops at the bottom (depth-first, good locality); idle workers
+   steal from the top of someone else's deque (the oldest, shallowest
+   directories, which carry the most remaining work).
+   ===================================================================== */
 
-/* Extension filter management - Step 2A */
-ExtensionFilter *ext_filter_create(void) {
-  ExtensionFilter *filter = malloc(sizeof(ExtensionFilter));
-  if (!filter)
-    return NULL;
+#define INITIAL_DEQUE_CAPACITY 64
+#define MAX_QUEUED_DIR_FDS 256 /* Pre-opened directories waiting in deques */
+#define INITIAL_ENTRY_CAPACITY 64
+#define MAX_IGNORE_FILE_SIZE (1024 * 1024)
 
-  filter->extensions = malloc(INITIAL_EXT_CAPACITY * sizeof(char *));
-  if (!filter->extensions) {
-    free(filter);
-    return NULL;
-  }
+/* Per-directory ignore files, read in this order (later ones win) */
+static const char *IGNORE_FILES[] = {".gitignore", ".nointlignore", NULL};
+
+/* One directory waiting to be read */
+typedef struct {
+  int fd;                   /* Already opened via openat(), or -1 */
+  char *path;               /* Full path, used to build entry paths */
+  int depth;                /* 0 for the base directory */
+  const PathFilter *filter; /* Rules in effect for this directory */
+  uint64_t *state;          /* Filter state after "<rel path>/" */
+  long parent;              /* Directory table index of the directory
+                               that queued it (-1 = none) */
+} DirTask;
+
+/* Entry names of the directory being read, buffered so ignore files
+   are known before anything in the directory is classified          */
+typedef struct {
+  char *names;          /* NUL-separated names */
+  size_t names_len;
+  size_t names_cap;
+  size_t *offsets;      /* Start of each name */
+  unsigned char *types; /* d_type of each name (0 if unknown) */
+  unsigned long long *inos; /* d_ino of each name (0 if unknown) */
+  size_t count;
+  size_t cap;
+} EntryBuffer;
+
+/* Per-worker double-ended queue of DirTasks */
+typedef struct {
+  DirTask *tasks;
+  size_t head; /* Index of the oldest task (steal end) */
+  size_t size;
+  size_t capacity;
+  pthread_mutex_t lock;
+} TaskDeque;
+
+/* One directory claimed while following symlinks */
+typedef struct {
+  const char *path; /* Path it was walked under */
+  const char *best; /* Shortest path that reaches it, smallest of equals */
+  int depth;        /* Components of best below the scan root */
+} WalkDir;
+
+/* Directory parent lists name, which leads to directory child */
+typedef struct {
+  size_t parent;
+  size_t child;
+  const char *name;
+} DirLink;
+
+/* Every directory walked while following symlinks, and every link
+   that reached one                                                 */
+typedef struct {
+  pthread_mutex_t lock; /* Guards everything below */
+  InodeSet *ids;        /* (dev, ino) -> index in dirs */
+  WalkDir *dirs;
+  size_t dir_count;
+  size_t dir_capacity;
+  DirLink *links;
+  size_t link_count;
+  size_t link_capacity;
+  Arena *arena; /* Paths and names */
+} DirTable;
+
+typedef struct Walker Walker;
+
+typedef struct {
+  Walker *walker;
+  int id;
+  TaskDeque deque;
+  EntryBuffer entries; /* Scratch for walk_directory */
+  FileList *found;     /* Worker-local results, merged at the end */
+} WalkWorker;
+
+struct Walker {
+  const ScanConfig *config;
+  WalkWorker *workers;
+  int num_workers;
 
-  filter->count = 0;
-  return filter;
+  pthread_mutex_t lock; /* Guards the counters below */
+  pthread_cond_t wake;  /* Signalled when work appears or the walk ends */
+  size_t queued;        /* Tasks sitting in some deque */
+  size_t pending;       /* Tasks queued or being processed */
+  int open_fds;         /* Directory fds held by queued tasks */
+
+  size_t root_len;         /* strlen(base path): entry paths minus this
+                              prefix are relative to the scan root */
+  PathFilter **filters;    /* Filters extended by ignore files, freed */
+  size_t filter_count;     /* when the walk is over (guarded by lock) */
+  size_t filter_capacity;
+
+  DirTable dirs; /* Only when following symlinks */
+};
+
+int default_thread_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  long n = (long)info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (n < 1)
+    return 1;
+  return n > 64 ? 64 : (int)n;
+}
+
+static int deque_init(TaskDeque *dq) {
+  dq->tasks = malloc(INITIAL_DEQUE_CAPACITY * sizeof(DirTask));
+  if (!dq->tasks)
+    return -1;
+  dq->head = 0;
+  dq->size = 0;
+  dq->capacity = INITIAL_DEQUE_CAPACITY;
+  pthread_mutex_init(&dq->lock, NULL);
+  return 0;
 }
 
-int ext_filter_add(ExtensionFilter *filter, const char *extension) {
-  if (!filter || !extension)
-    return -1; // Handle NULL inputs
+static void deque_destroy(TaskDeque *dq) {
+  free(dq->tasks);
+  pthread_mutex_destroy(&dq->lock);
+}
 
-  // Step 1: Check if we have space (fixed size for now)
-  if (filter->count >= INITIAL_EXT_CAPACITY) {
-    return -1; // No space available
+/* Owner end: push at the bottom */
+static int deque_push(TaskDeque *dq, DirTask task) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->size >= dq->capacity) {
+    /* Grow and unwrap the ring so head starts at 0 again */
+    size_t new_capacity = dq->capacity * 2;
+    DirTask *new_tasks = malloc(new_capacity * sizeof(DirTask));
+    if (!new_tasks) {
+      pthread_mutex_unlock(&dq->lock);
+      return -1;
+    }
+    for (size_t i = 0; i < dq->size; i++)
+      new_tasks[i] = dq->tasks[(dq->head + i) % dq->capacity];
+    free(dq->tasks);
+    dq->tasks = new_tasks;
+    dq->head = 0;
+    dq->capacity = new_capacity;
   }
+  dq->tasks[(dq->head + dq->size) % dq->capacity] = task;
+  dq->size++;
+  pthread_mutex_unlock(&dq->lock);
+  return 0;
+}
 
-  // Step 2: Duplicate the extension string
-  char *ext_copy = malloc(strlen(extension) + 1);
-  if (!ext_copy) {
-    return -1; // Allocation failed
+/* Owner end: pop the most recently pushed task */
+static int deque_pop(TaskDeque *dq, DirTask *out) {
+  int ok = 0;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->size > 0) {
+    dq->size--;
+    *out = dq->tasks[(dq->head + dq->size) % dq->capacity];
+    ok = 1;
   }
-  strcpy(ext_copy, extension);
+  pthread_mutex_unlock(&dq->lock);
+  return ok;
+}
 
-  // Step 3: Add to array and increment count
-  filter->extensions[filter->count] = ext_copy;
-  filter->count++;
+/* Thief end: take the oldest task */
+static int deque_steal(TaskDeque *dq, DirTask *out) {
+  int ok = 0;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->size > 0) {
+    *out = dq->tasks[dq->head];
+    dq->head = (dq->head + 1) % dq->capacity;
+    dq->size--;
+    ok = 1;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return ok;
+}
 
-  return 0; // Success (return 0, not count)
+static void walker_task_done(Walker *wk) {
+  pthread_mutex_lock(&wk->lock);
+  wk->pending--;
+  if (wk->pending == 0)
+    pthread_cond_broadcast(&wk->wake);
+  pthread_mutex_unlock(&wk->lock);
 }
 
-void ext_filter_free(ExtensionFilter *filter) {
-  if (!filter)
-    return;
+/* Queues a subdirectory on the worker's own deque.  The counters go up
+   first: once pushed the task can be stolen, and the thief must never
+   see it before they count it.                                         */
+static void walker_push(WalkWorker *w, DirTask task) {
+  Walker *wk = w->walker;
+  pthread_mutex_lock(&wk->lock);
+  wk->queued++;
+  wk->pending++;
+  pthread_mutex_unlock(&wk->lock);
 
-  /* Step 1: Free each individual extension string */
-  for (size_t i = 0; i < filter->count; i++) {
-    free(filter->extensions[i]);
+  if (deque_push(&w->deque, task) == -1) {
+    pthread_mutex_lock(&wk->lock);
+    wk->queued--;
+    if (task.fd >= 0)
+      wk->open_fds--;
+    pthread_mutex_unlock(&wk->lock);
+    if (task.fd >= 0)
+      close(task.fd);
+    free(task.path);
+    free(task.state);
+    walker_task_done(wk);
+    return;
   }
+  pthread_mutex_lock(&wk->lock);
+  pthread_cond_signal(&wk->wake);
+  pthread_mutex_unlock(&wk->lock);
+}
 
-  /* Step 2: Free the extensions array */
-  free(filter->extensions);
+/* Gets the next task: own deque first, then steal, otherwise sleep until
+   new work shows up.  Returns 0 once the whole tree has been walked.   */
+static int walker_next(WalkWorker *w, DirTask *out) {
+  Walker *wk = w->walker;
+  for (;;) {
+    int got = deque_pop(&w->deque, out);
+    for (int i = 1; !got && i < wk->num_workers; i++) {
+      int victim = (w->id + i) % wk->num_workers;
+      got = deque_steal(&wk->workers[victim].deque, out);
+    }
 
-  /* Step 3: Free the structure itself */
-  free(filter);
+    pthread_mutex_lock(&wk->lock);
+    if (got) {
+      wk->queued--;
+      if (out->fd >= 0)
+        wk->open_fds--;
+      pthread_mutex_unlock(&wk->lock);
+      return 1;
+    }
+    while (wk->queued == 0 && wk->pending > 0)
+      pthread_cond_wait(&wk->wake, &wk->lock);
+    int done = (wk->pending == 0);
+    pthread_mutex_unlock(&wk->lock);
+    if (done)
+      return 0;
+  }
 }
 
-int ext_filter_matches(const ExtensionFilter *filter, const char *filename) {
-  if (!filter || !filename)
-    return -1; /* Null safety - no match */
+/* Opens a subdirectory relative to its parent's fd so the kernel does
+   not resolve the full path again.  Falls back to opening by path later
+   when too many queued fds are already held.                          */
+static int walker_open_child(Walker *wk, int parent_fd, const char *name) {
+#ifdef _WIN32
+  (void)wk;
+  (void)parent_fd;
+  (void)name;
+  return -1;
+#else
+  pthread_mutex_lock(&wk->lock);
+  int allowed = wk->open_fds < MAX_QUEUED_DIR_FDS;
+  if (allowed)
+    wk->open_fds++;
+  pthread_mutex_unlock(&wk->lock);
+  if (!allowed)
+    return -1;
 
-  size_t filelen = strlen(filename);
+  int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    pthread_mutex_lock(&wk->lock);
+    wk->open_fds--;
+    pthread_mutex_unlock(&wk->lock);
+  }
+  return fd;
+#endif
+}
 
-  /* Check each extension in the filter */
-  for (size_t i = 0; i < filter->count; i++) {
-    size_t extlen = strlen(filter->extensions[i]);
+/* Joins a directory path and an entry name into a new heap string */
+static char *join_path(const char *dir, size_t dir_len, const char *name) {
+  size_t name_len = strlen(name);
+  char *full = malloc(dir_len + 1 + name_len + 1);
+  if (!full)
+    return NULL;
+  memcpy(full, dir, dir_len);
+  full[dir_len] = '/';
+  memcpy(full + dir_len + 1, name, name_len + 1);
+  return full;
+}
 
-    /* Extension can't be longer than filename */
-    if (filelen < extlen)
-      continue;
+/* Modification time of a stat result, in nanoseconds */
+static long long stat_mtime_ns(const struct stat *st) {
+#ifdef _WIN32
+  return (long long)st->st_mtime * 1000000000LL;
+#else
+  return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
 
-    /* Get the last N characters of filename */
-    const char *file_end = filename + filelen - extlen;
+static void stamp_from_stat(TargetFile *target, const struct stat *st) {
+  target->size = (long long)st->st_size;
+  target->mtime_ns = stat_mtime_ns(st);
+  target->ino = (unsigned long long)st->st_ino;
+  target->dev = (unsigned long long)st->st_dev;
+}
 
-    /* Compare strings */
-    if (strcmp(file_end, filter->extensions[i]) == 0) {
-      return (int)i; /* Return the index of matching extension */
-    }
-  }
+int stat_target_file(TargetFile *target) {
+  struct stat file_stat;
+  if (!target || stat(target->path, &file_stat) == -1)
+    return -1;
+  stamp_from_stat(target, &file_stat);
+  return 0;
+}
 
-  return -1; /* No match found */
+/* stat() of an entry of the open directory, relative to its fd.
+   Symlinks are resolved only when follow is set.                    */
+static int stat_entry(int dir_fd, const char *dir_path, size_t path_len,
+                      const char *name, int follow, struct stat *st) {
+#ifdef _WIN32
+  (void)dir_fd;
+  (void)follow;
+  char *entry_path = join_path(dir_path, path_len, name);
+  int status = entry_path ? stat(entry_path, st) : -1;
+  free(entry_path);
+  return status;
+#else
+  (void)dir_path;
+  (void)path_len;
+  return fstatat(dir_fd, name, st, follow ? 0 : AT_SYMLINK_NOFOLLOW);
+#endif
 }
 
-#include <dirent.h>
-#include <limits.h>
+enum { ENTRY_OTHER, ENTRY_FILE, ENTRY_DIR };
 
-int scan_directory_recursive(const char *path, const ScanConfig *config,
-                             DynamicArray *results) {
-  if (!path || !config || !results)
-    return -1;
+/* Decides whether a directory entry is a regular file or a directory.
+   d_type answers for free on most filesystems; only DT_UNKNOWN (and
+   followed symlinks, whose target decides) fall back to fstatat() on
+   the open directory fd.  *stated is set when st was filled.         */
+static int classify_entry(int dir_fd, const char *dir_path, size_t path_len,
+                          const char *name, unsigned char d_type, int follow,
+                          struct stat *st, int *stated) {
+  *stated = 0;
+#ifdef _DIRENT_HAVE_D_TYPE
+  if (d_type == DT_REG)
+    return ENTRY_FILE;
+  if (d_type == DT_DIR)
+    return ENTRY_DIR;
+  if (d_type == DT_LNK && !follow)
+    return ENTRY_OTHER;
+  if (d_type != DT_UNKNOWN && d_type != DT_LNK)
+    return ENTRY_OTHER; /* fifo, socket, device */
+#else
+  (void)d_type;
+#endif
 
-  /* Open directory */
-  DIR *dir = opendir(path);
-  if (!dir) {
-    perror("opendir");
+  if (stat_entry(dir_fd, dir_path, path_len, name, follow, st) == -1)
+    return ENTRY_OTHER;
+  *stated = 1;
+
+  if (S_ISREG(st->st_mode))
+    return ENTRY_FILE;
+  return S_ISDIR(st->st_mode) ? ENTRY_DIR : ENTRY_OTHER;
+}
+
+static int entries_init(EntryBuffer *eb) {
+  eb->names = malloc(INITIAL_ENTRY_CAPACITY * 16);
+  eb->offsets = malloc(INITIAL_ENTRY_CAPACITY * sizeof(size_t));
+  eb->types = malloc(INITIAL_ENTRY_CAPACITY);
+  eb->inos = malloc(INITIAL_ENTRY_CAPACITY * sizeof(unsigned long long));
+  if (!eb->names || !eb->offsets || !eb->types || !eb->inos) {
+    free(eb->names);
+    free(eb->offsets);
+    free(eb->types);
+    free(eb->inos);
     return -1;
   }
+  eb->names_len = 0;
+  eb->names_cap = INITIAL_ENTRY_CAPACITY * 16;
+  eb->count = 0;
+  eb->cap = INITIAL_ENTRY_CAPACITY;
+  return 0;
+}
+
+static void entries_destroy(EntryBuffer *eb) {
+  free(eb->names);
+  free(eb->offsets);
+  free(eb->types);
+  free(eb->inos);
+}
+
+static int entries_add(EntryBuffer *eb, const char *name,
+                       unsigned char d_type, unsigned long long ino) {
+  size_t len = strlen(name) + 1;
+  if (eb->names_len + len > eb->names_cap) {
+    size_t new_cap = eb->names_cap * 2;
+    while (new_cap < eb->names_len + len)
+      new_cap *= 2;
+    char *new_names = realloc(eb->names, new_cap);
+    if (!new_names)
+      return -1;
+    eb->names = new_names;
+    eb->names_cap = new_cap;
+  }
+  if (eb->count >= eb->cap) {
+    size_t new_cap = eb->cap * 2;
+    size_t *new_offsets = realloc(eb->offsets, new_cap * sizeof(size_t));
+    if (!new_offsets)
+      return -1;
+    eb->offsets = new_offsets;
+    unsigned char *new_types = realloc(eb->types, new_cap);
+    if (!new_types)
+      return -1;
+    eb->types = new_types;
+    unsigned long long *new_inos =
+        realloc(eb->inos, new_cap * sizeof(unsigned long long));
+    if (!new_inos)
+      return -1;
+    eb->inos = new_inos;
+    eb->cap = new_cap;
+  }
+  memcpy(eb->names + eb->names_len, name, len);
+  eb->offsets[eb->count] = eb->names_len;
+  eb->types[eb->count] = d_type;
+  eb->inos[eb->count] = ino;
+  eb->names_len += len;
+  eb->count++;
+  return 0;
+}
+
+/* Fills the buffer from a directory listing saved by the last run */
+static void entries_load(EntryBuffer *eb, const SnapDir *cached) {
+  const char *name = cached->names;
+  for (size_t i = 0; i < cached->entry_count; i++) {
+    entries_add(eb, name, cached->types[i], 0);
+    name += strlen(name) + 1;
+  }
+}
 
-  /* Directories to skip entirely (generated / vendor / cache) */
-  static const char *SKIP_DIRS[] = {"node_modules", ".next", "dist",
-                                    "build",        ".git",  ".cache",
-                                    "coverage",     "out",   NULL};
+/* Fills the buffer with readdir().  Returns the open stream (closed by
+   the caller) or NULL.                                               */
+static DIR *entries_read(EntryBuffer *eb, DirTask *task) {
+  DIR *dir;
+#ifdef _WIN32
+  dir = opendir(task->path);
+#else
+  dir = fdopendir(task->fd); /* Takes over task->fd */
+#endif
+  if (!dir)
+    return NULL;
 
   struct dirent *entry;
   while ((entry = readdir(dir)) != NULL) {
@@ -114,51 +471,639 @@ int scan_directory_recursive(const char *path, const ScanConfig *config,
     if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
       continue;
     }
-    /* Construct full path to entry */
-    char full_path[PATH_MAX];
-    int ret =
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
-    if (ret < 0 || ret >= (int)sizeof(full_path)) {
-      continue;
+#ifdef _DIRENT_HAVE_D_TYPE
+    unsigned char d_type = entry->d_type;
+#else
+    unsigned char d_type = 0;
+#endif
+#ifdef _WIN32
+    unsigned long long ino = 0;
+#else
+    unsigned long long ino = (unsigned long long)entry->d_ino;
+#endif
+    entries_add(eb, entry->d_name, d_type, ino);
+  }
+  return dir;
+}
+
+/* Reads a small file (an ignore file) next to the open directory.
+   Returns a heap buffer and its length, or NULL.                    */
+static char *read_small_file(int dir_fd, const char *dir_path,
+                             size_t path_len, const char *name,
+                             size_t *len_out) {
+  FILE *file;
+#ifdef _WIN32
+  (void)dir_fd;
+  char *full = join_path(dir_path, path_len, name);
+  file = full ? fopen(full, "rb") : NULL;
+  free(full);
+#else
+  (void)dir_path;
+  (void)path_len;
+  int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+  file = fd >= 0 ? fdopen(fd, "rb") : NULL;
+  if (!file && fd >= 0)
+    close(fd);
+#endif
+  if (!file)
+    return NULL;
+
+  size_t cap = 4096, len = 0;
+  char *text = malloc(cap);
+  while (text) {
+    len += fread(text + len, 1, cap - len, file);
+    if (len < cap || cap >= MAX_IGNORE_FILE_SIZE)
+      break;
+    char *bigger = realloc(text, cap * 2);
+    if (!bigger) {
+      free(text);
+      text = NULL;
+      break;
     }
+    text = bigger;
+    cap *= 2;
+  }
+  fclose(file);
+  *len_out = len;
+  return text;
+}
 
-    /* Get file information */
-    struct stat file_stat;
-    if (stat(full_path, &file_stat) == -1) {
+/* Keeps a filter built during the walk alive until the walk is over */
+static int walker_keep_filter(Walker *wk, PathFilter *filter) {
+  pthread_mutex_lock(&wk->lock);
+  if (wk->filter_count >= wk->filter_capacity) {
+    size_t new_cap = wk->filter_capacity ? wk->filter_capacity * 2 : 8;
+    PathFilter **grown = realloc(wk->filters, new_cap * sizeof(PathFilter *));
+    if (!grown) {
+      pthread_mutex_unlock(&wk->lock);
+      return -1;
+    }
+    wk->filters = grown;
+    wk->filter_capacity = new_cap;
+  }
+  wk->filters[wk->filter_count++] = filter;
+  pthread_mutex_unlock(&wk->lock);
+  return 0;
+}
+
+/* Builds the filter state of a path from scratch */
+static uint64_t *filter_state_for(const PathFilter *filter, const char *rel,
+                                  size_t rel_len) {
+  size_t words = path_filter_state_words(filter);
+  uint64_t *state = malloc(words * sizeof(uint64_t));
+  if (!state)
+    return NULL;
+  path_filter_start(filter, state);
+  if (rel_len > 0) {
+    path_filter_step(filter, state, rel, rel_len);
+    path_filter_step(filter, state, "/", 1);
+  }
+  return state;
+}
+
+/* Switches task to a filter extended with this directory's ignore
+   files, if it has any.                                             */
+static void apply_ignore_files(WalkWorker *w, DirTask *task, int dir_fd,
+                               size_t path_len, const int *present) {
+  Walker *wk = w->walker;
+  const char *rel = path_len > wk->root_len ? task->path + wk->root_len + 1
+                                             : "";
+  size_t rel_len = strlen(rel);
+
+  for (int i = 0; IGNORE_FILES[i]; i++) {
+    if (!present[i])
+      continue;
+    size_t len = 0;
+    char *text =
+        read_small_file(dir_fd, task->path, path_len, IGNORE_FILES[i], &len);
+    if (!text)
+      continue;
+    PathFilter *extended = path_filter_extend(task->filter, rel, text, len);
+    free(text);
+    if (!extended)
+      continue;
+    uint64_t *state = filter_state_for(extended, rel, rel_len);
+    if (!state || walker_keep_filter(wk, extended) == -1) {
+      free(state);
+      path_filter_free(extended);
       continue;
     }
+    free(task->state);
+    task->filter = extended;
+    task->state = state;
+  }
+}
 
-    /* If regular file: check extension and skip config/test/spec files */
-    if (S_ISREG(file_stat.st_mode)) {
-      /* Skip *.config.*, *.test.*, *.spec.*, and files under messages/ */
-      if (strstr(entry->d_name, ".config.") ||
-          strstr(entry->d_name, ".test.") || strstr(entry->d_name, ".spec.")) {
-        continue;
+/* =====================================================================
+   DIRECTORY TABLE (--follow-symlinks)
+   A directory is claimed by its (dev, ino) before it is read, so it is
+   walked once however many links lead to it, cycles included.  Every
+   link that reached it is recorded; after the walk its files are
+   listed under its shortest path (the smallest of equals), whichever
+   thread claimed it.  Ignore files and --max-depth apply as on the
+   path that claimed it.
+   ===================================================================== */
+
+static int dir_table_init(DirTable *t) {
+  memset(t, 0, sizeof(*t));
+  t->ids = inode_set_create();
+  t->arena = arena_create(64 * 1024);
+  if (!t->ids || !t->arena) {
+    inode_set_free(t->ids);
+    arena_free(t->arena);
+    return -1;
+  }
+  pthread_mutex_init(&t->lock, NULL);
+  return 0;
+}
+
+static void dir_table_destroy(DirTable *t) {
+  inode_set_free(t->ids);
+  arena_free(t->arena);
+  free(t->dirs);
+  free(t->links);
+  pthread_mutex_destroy(&t->lock);
+}
+
+/* Makes room for one more directory and one more link (lock held) */
+static int dir_table_reserve(DirTable *t) {
+  if (t->dir_count >= t->dir_capacity) {
+    size_t new_cap = t->dir_capacity ? t->dir_capacity * 2 : 64;
+    WalkDir *grown = realloc(t->dirs, new_cap * sizeof(WalkDir));
+    if (!grown)
+      return -1;
+    t->dirs = grown;
+    t->dir_capacity = new_cap;
+  }
+  if (t->link_count >= t->link_capacity) {
+    size_t new_cap = t->link_capacity ? t->link_capacity * 2 : 64;
+    DirLink *grown = realloc(t->links, new_cap * sizeof(DirLink));
+    if (!grown)
+      return -1;
+    t->links = grown;
+    t->link_capacity = new_cap;
+  }
+  return 0;
+}
+
+/* Claims directory (dev, ino), reached as path from directory parent
+   (-1 for the root).  Returns its index the first time; -1 once it is
+   claimed already (only the link is recorded) or memory ran out.     */
+static long dir_table_claim(DirTable *t, long parent, const char *path,
+                            int depth, unsigned long long dev,
+                            unsigned long long ino) {
+  const char *slash = strrchr(path, '/');
+  size_t name_at = slash ? (size_t)(slash + 1 - path) : 0;
+
+  pthread_mutex_lock(&t->lock);
+  char *copy = dir_table_reserve(t) == 0
+                   ? arena_strndup(t->arena, path, strlen(path))
+                   : NULL;
+  size_t index = t->dir_count;
+  int status =
+      copy ? inode_set_insert_value(t->ids, dev, ino, index, &index) : -1;
+  if (status == 1) {
+    WalkDir *dir = &t->dirs[t->dir_count++];
+    dir->path = copy;
+    dir->best = copy;
+    dir->depth = depth;
+  }
+  if (status >= 0 && parent >= 0) {
+    DirLink *link = &t->links[t->link_count++];
+    link->parent = (size_t)parent;
+    link->child = index;
+    link->name = copy + name_at;
+  }
+  pthread_mutex_unlock(&t->lock);
+  return status == 1 ? (long)index : -1;
+}
+
+/* Orders paths component by component: '/' sorts before every other
+   byte, so "a/b" < "a-b" and appending a name keeps the order       */
+static int path_order(const char *a, const char *b) {
+  for (;; a++, b++) {
+    int ca = *a == '/' ? 1 : (unsigned char)*a;
+    int cb = *b == '/' ? 1 : (unsigned char)*b;
+    if (ca != cb || ca == 0)
+      return ca - cb;
+  }
+}
+
+/* Works out every directory's best path: its parent's best path plus
+   the link name, whenever that is shorter, or as short and smaller.
+   Rounds repeat until nothing improves.  Returns the number of
+   directories not walked under their best path, or -1.              */
+static long dir_table_resolve(DirTable *t) {
+  char *candidate = NULL;
+  size_t capacity = 0;
+  for (int changed = 1; changed;) {
+    changed = 0;
+    for (size_t i = 0; i < t->link_count; i++) {
+      const DirLink *link = &t->links[i];
+      const WalkDir *parent = &t->dirs[link->parent];
+      WalkDir *child = &t->dirs[link->child];
+      if (parent->depth + 1 > child->depth)
+        continue; /* Longer - including every way around a cycle */
+
+      size_t parent_len = strlen(parent->best);
+      size_t name_len = strlen(link->name);
+      size_t len = parent_len + 1 + name_len;
+      if (len + 1 > capacity) {
+        char *grown = realloc(candidate, len + 1);
+        if (!grown) {
+          free(candidate);
+          return -1;
+        }
+        candidate = grown;
+        capacity = len + 1;
       }
-      if (ext_filter_matches(config->filter, entry->d_name) >= 0) {
-        da_append(results, full_path);
+      memcpy(candidate, parent->best, parent_len);
+      candidate[parent_len] = '/';
+      memcpy(candidate + parent_len + 1, link->name, name_len + 1);
+      if (parent->depth + 1 == child->depth &&
+          path_order(candidate, child->best) >= 0)
+        continue;
+
+      char *best = arena_strndup(t->arena, candidate, len);
+      if (!best) {
+        free(candidate);
+        return -1;
       }
+      child->best = best;
+      child->depth = parent->depth + 1;
+      changed = 1;
+    }
+  }
+  free(candidate);
+
+  long moved = 0;
+  for (size_t i = 0; i < t->dir_count; i++)
+    moved += t->dirs[i].best != t->dirs[i].path;
+  return moved;
+}
+
+/* Moves the files from first on that were found in a directory walked
+   under another path than its best one, then sorts them again        */
+static int dir_table_rename(const DirTable *t, FileList *files,
+                            size_t first) {
+  HashMap *walked = hm_create(t->dir_count);
+  if (!walked)
+    return -1;
+  for (size_t i = 0; i < t->dir_count; i++) {
+    if (t->dirs[i].best != t->dirs[i].path &&
+        hm_put(walked, t->dirs[i].path, i) == -1) {
+      hm_free(walked);
+      return -1;
+    }
+  }
+
+  for (size_t i = first; i < files->size; i++) {
+    TargetFile *file = &files->files[i];
+    const char *slash = strrchr(file->path, '/');
+    size_t dir;
+    if (!slash ||
+        !hm_get_span(walked, file->path, (size_t)(slash - file->path), &dir))
+      continue;
+    size_t best_len = strlen(t->dirs[dir].best);
+    size_t rest_len = strlen(slash);
+    char *path = fl_path_alloc(files, best_len + rest_len);
+    if (!path) {
+      hm_free(walked);
+      return -1;
     }
-    /* If directory: skip known framework/build dirs, otherwise recurse */
-    else if (S_ISDIR(file_stat.st_mode)) {
-      int skip = 0;
-      for (int di = 0; SKIP_DIRS[di]; di++) {
-        if (strcmp(entry->d_name, SKIP_DIRS[di]) == 0) {
-          skip = 1;
-          break;
+    memcpy(path, t->dirs[dir].best, best_len);
+    memcpy(path + best_len, slash, rest_len + 1);
+    file->path = path;
+  }
+  hm_free(walked);
+
+  /* Only this walk's part of the list */
+  FileList part = *files;
+  part.files += first;
+  part.size -= first;
+  fl_sort(&part);
+  return 0;
+}
+
+/* Reads one directory: keeps matching files, queues subdirectories */
+static void walk_directory(WalkWorker *w, DirTask *task) {
+  const ScanConfig *config = w->walker->config;
+  size_t root_len = w->walker->root_len;
+  size_t path_len = strlen(task->path);
+  const char *rel = path_len > root_len ? task->path + root_len + 1 : "";
+
+  /* Step 1: Open the directory */
+#ifdef _WIN32
+  int dir_fd = -1;
+#else
+  if (task->fd == -1)
+    task->fd = open(task->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (task->fd == -1) {
+    perror("opendir");
+    return;
+  }
+  int dir_fd = task->fd;
+#endif
+
+  /* Step 2: When following symlinks, a directory is claimed before it
+     is read.  One claimed already - reached through another link or a
+     cycle - is not read again.                                       */
+  long long dir_mtime = -1;
+  unsigned long long dir_dev = 0;
+  long dir_id = -1;
+  if (config->next || config->follow_symlinks) {
+    struct stat dir_stat;
+#ifdef _WIN32
+    int stat_status = stat(task->path, &dir_stat);
+#else
+    int stat_status = fstat(dir_fd, &dir_stat);
+#endif
+    if (stat_status == 0) {
+      dir_mtime = stat_mtime_ns(&dir_stat);
+      dir_dev = (unsigned long long)dir_stat.st_dev;
+      if (config->follow_symlinks && dir_stat.st_ino != 0) {
+        dir_id = dir_table_claim(&w->walker->dirs, task->parent, task->path,
+                                 task->depth, dir_dev,
+                                 (unsigned long long)dir_stat.st_ino);
+        if (dir_id < 0) {
+#ifndef _WIN32
+          close(dir_fd);
+#endif
+          return;
         }
       }
-      if (!skip) {
-        scan_directory_recursive(full_path, config, results);
+    }
+  }
+
+  /* Step 3: Buffer the entry names.  A directory whose mtime matches
+     the last run has had nothing added, removed or renamed, so its
+     saved listing replaces readdir().                                */
+  EntryBuffer *eb = &w->entries;
+  eb->count = 0;
+  eb->names_len = 0;
+
+  DIR *dir = NULL;
+  const SnapDir *cached =
+      config->next && dir_mtime >= 0
+          ? snapshot_find_dir(config->previous, rel, dir_mtime)
+          : NULL;
+  if (cached) {
+    entries_load(eb, cached);
+  } else {
+    dir = entries_read(eb, task);
+    if (!dir) {
+      perror("opendir");
+#ifndef _WIN32
+      close(task->fd);
+#endif
+      return;
+    }
+  }
+  if (config->next && dir_mtime >= 0)
+    snapshot_add_dir(config->next, rel, dir_mtime, eb->names, eb->names_len,
+                     eb->types, eb->count);
+
+  /* Step 4: Ignore files change the rules for this whole subtree */
+  int ignore_present[sizeof(IGNORE_FILES) / sizeof(IGNORE_FILES[0])] = {0};
+  for (size_t e = 0; config->use_ignore_files && e < eb->count; e++) {
+    for (int i = 0; IGNORE_FILES[i]; i++) {
+      if (strcmp(eb->names + eb->offsets[e], IGNORE_FILES[i]) == 0)
+        ignore_present[i] = 1;
+    }
+  }
+  apply_ignore_files(w, task, dir_fd, path_len, ignore_present);
+
+  const PathFilter *filter = task->filter;
+  size_t words = path_filter_state_words(filter);
+  uint64_t state[words];
+
+  for (size_t e = 0; e < eb->count; e++) {
+    const char *name = eb->names + eb->offsets[e];
+
+    /* Step 5: Run the name through the filter automaton, continuing
+       from this directory's state                                    */
+    memcpy(state, task->state, words * sizeof(uint64_t));
+    path_filter_step(filter, state, name, strlen(name));
+    int keep_file = path_filter_accepts(filter, state, 0);
+    int keep_dir = path_filter_accepts(filter, state, 1);
+    if (!keep_file && !keep_dir)
+      continue; /* Rejected by name - no need to know what it is */
+
+    /* Step 6: Classify the entry, from d_type when the filesystem
+       provides it, so most entries cost no metadata syscall at all */
+    struct stat file_stat;
+    int stated;
+    int kind = classify_entry(dir_fd, task->path, path_len, name, eb->types[e],
+                              config->follow_symlinks, &file_stat, &stated);
+
+    if (kind == ENTRY_FILE && keep_file) {
+      TargetFile target = {
+          .path = NULL, .size = -1, .mtime_ns = 0, .ino = 0, .dev = 0};
+      /* The snapshot compares size, mtime and inode of every file */
+      if (!stated && (config->next || config->want_sizes ||
+                      (config->follow_symlinks && eb->inos[e] == 0)))
+        stated = stat_entry(dir_fd, task->path, path_len, name, 1,
+                            &file_stat) == 0;
+      if (stated)
+        stamp_from_stat(&target, &file_stat);
+
+      /* Files linked from several places are kept once, after the
+         walk.  d_ino and the directory's device identify plain entries
+         without a stat.                                               */
+      if (config->follow_symlinks && !stated) {
+        target.dev = dir_dev;
+        target.ino = eb->inos[e];
+      }
+      /* Joined straight into the list's arena, freed with the list */
+      size_t name_len = strlen(name);
+      target.path = fl_path_alloc(w->found, path_len + 1 + name_len);
+      if (target.path) {
+        memcpy(target.path, task->path, path_len);
+        target.path[path_len] = '/';
+        memcpy(target.path + path_len + 1, name, name_len + 1);
+        fl_append_entry(w->found, &target);
+      }
+    }
+    /* Subdirectories are pruned here, before they are ever opened */
+    else if (kind == ENTRY_DIR && keep_dir) {
+      if (config->max_depth >= 0 && task->depth >= config->max_depth)
+        continue;
+      DirTask child = {.fd = -1,
+                       .path = NULL,
+                       .depth = task->depth + 1,
+                       .filter = filter,
+                       .state = malloc(words * sizeof(uint64_t)),
+                       .parent = dir_id};
+      child.path = join_path(task->path, path_len, name);
+      if (!child.path || !child.state) {
+        free(child.path);
+        free(child.state);
+        continue;
       }
+      path_filter_step(filter, state, "/", 1);
+      memcpy(child.state, state, words * sizeof(uint64_t));
+      child.fd = walker_open_child(w->walker, dir_fd, name);
+      walker_push(w, child);
     }
   }
 
-  closedir(dir);
-  return 0;
+  if (dir)
+    closedir(dir); /* Also closes task->fd */
+#ifndef _WIN32
+  else
+    close(dir_fd);
+#endif
+}
+
+static void *walk_worker_main(void *arg) {
+  WalkWorker *w = arg;
+  DirTask task;
+  while (walker_next(w, &task)) {
+    walk_directory(w, &task);
+    free(task.path);
+    free(task.state);
+    walker_task_done(w->walker);
+  }
+  /* Each worker sorts its own run, so the merge below only interleaves */
+  fl_sort(w->found);
+  return NULL;
 }
 
-int collect_target_files(const ScanConfig *config, DynamicArray *file_paths) {
+int scan_directory_recursive(const char *path, const ScanConfig *config,
+                             FileList *results) {
+  if (!path || !config || !results)
+    return -1;
+
+  /* Step 1: Set up the shared walker state */
+  Walker wk;
+  wk.config = config;
+  wk.num_workers =
+      config->num_threads > 0 ? config->num_threads : default_thread_count();
+  wk.queued = 0;
+  wk.pending = 0;
+  wk.open_fds = 0;
+  wk.root_len = strlen(path);
+  wk.filters = NULL;
+  wk.filter_count = 0;
+  wk.filter_capacity = 0;
+  if (config->follow_symlinks && dir_table_init(&wk.dirs) == -1)
+    return -1;
+  wk.workers = calloc((size_t)wk.num_workers, sizeof(WalkWorker));
+  if (!wk.workers) {
+    if (config->follow_symlinks)
+      dir_table_destroy(&wk.dirs);
+    return -1;
+  }
+  pthread_mutex_init(&wk.lock, NULL);
+  pthread_cond_init(&wk.wake, NULL);
+
+  int ready = 0;
+  for (; ready < wk.num_workers; ready++) {
+    WalkWorker *w = &wk.workers[ready];
+    w->walker = &wk;
+    w->id = ready;
+    w->found = fl_create();
+    if (!w->found)
+      break;
+    if (entries_init(&w->entries) == -1) {
+      fl_free(w->found);
+      break;
+    }
+    if (deque_init(&w->deque) == -1) {
+      entries_destroy(&w->entries);
+      fl_free(w->found);
+      break;
+    }
+  }
+
+  int status = -1;
+  if (ready == wk.num_workers) {
+    /* Step 2: Seed worker 0 with the starting directory */
+    DirTask root = {.fd = -1,
+                    .path = malloc(strlen(path) + 1),
+                    .depth = 0,
+                    .filter = config->filter,
+                    .state = filter_state_for(config->filter, "", 0),
+                    .parent = -1};
+    if (root.path && root.state) {
+      strcpy(root.path, path);
+      walker_push(&wk.workers[0], root);
+      status = 0;
+    } else {
+      free(root.path);
+      free(root.state);
+    }
+  }
+
+  if (status == 0) {
+    /* Step 3: Run the workers; the calling thread acts as worker 0 */
+    pthread_t *threads = calloc((size_t)wk.num_workers, sizeof(pthread_t));
+    int started = 1;
+    for (; threads && started < wk.num_workers; started++) {
+      if (pthread_create(&threads[started], NULL, walk_worker_main,
+                         &wk.workers[started]) != 0)
+        break; /* Fewer helpers, remaining deques stay empty */
+    }
+    walk_worker_main(&wk.workers[0]);
+    for (int i = 1; threads && i < started; i++)
+      pthread_join(threads[i], NULL);
+    free(threads);
+  }
+
+  /* Step 4: Merge the sorted worker-local runs by path - which worker
+     found a file depends on timing, so this keeps the list (and every
+     report built from it) the same across runs and thread counts    */
+  size_t first = results->size;
+  if (status == 0) {
+    FileList **runs = malloc((size_t)ready * sizeof(FileList *));
+    for (int i = 0; runs && i < ready; i++)
+      runs[i] = wk.workers[i].found;
+    if (!runs || fl_merge_sorted(results, runs, (size_t)ready) == -1)
+      status = -1;
+    free(runs);
+  }
+
+  /* Step 5: Files of a directory claimed under another path than its
+     best one move there.  A file reached through several links is then
+     listed once, under its smallest path - the first one, in a list
+     sorted by path.                                                  */
+  if (status == 0 && config->follow_symlinks) {
+    long moved = dir_table_resolve(&wk.dirs);
+    if (moved < 0 ||
+        (moved > 0 && dir_table_rename(&wk.dirs, results, first) == -1))
+      status = -1;
+  }
+  if (status == 0 && config->follow_symlinks) {
+    InodeSet *seen = inode_set_create();
+    size_t kept = first;
+    for (size_t i = first; seen && i < results->size; i++) {
+      const TargetFile *f = &results->files[i];
+      if (f->ino == 0 || inode_set_insert(seen, f->dev, f->ino) != 0)
+        results->files[kept++] = *f;
+    }
+    if (seen)
+      results->size = kept;
+    else
+      status = -1;
+    inode_set_free(seen);
+  }
+  for (int i = 0; i < ready; i++) {
+    fl_free(wk.workers[i].found);
+    entries_destroy(&wk.workers[i].entries);
+    deque_destroy(&wk.workers[i].deque);
+  }
+  for (size_t i = 0; i < wk.filter_count; i++)
+    path_filter_free(wk.filters[i]);
+  free(wk.filters);
+  if (config->follow_symlinks)
+    dir_table_destroy(&wk.dirs);
+  pthread_cond_destroy(&wk.wake);
+  pthread_mutex_destroy(&wk.lock);
+  free(wk.workers);
+  return status;
+}
+
+int collect_target_files(const ScanConfig *config, FileList *file_paths) {
   /* Step 1: Validate all inputs */
   if (!config || !config->base_path || !config->filter || !file_paths) {
     fprintf(stderr, "Error: Invalid configuration parameters\n");
@@ -178,12 +1123,30 @@ int collect_target_files(const ScanConfig *config, DynamicArray *file_paths) {
     return -1;
   }
 
-  /* Step 4: Call recursive scanner to collect files */
+  /* Step 4: Tracked files only - read them from the git index */
+  if (config->use_git_index) {
+    int status = git_index_collect(config->base_path, config->filter,
+                                   file_paths);
+    if (status == -1) {
+      fprintf(stderr, "Error: Failed to read the git index\n");
+      return -1;
+    }
+    if (status == 0) {
+      /* The index has no sizes to trust; stat when they are wanted */
+      for (size_t i = 0; config->want_sizes && i < file_paths->size; i++)
+        stat_target_file(&file_paths->files[i]);
+      return 0;
+    }
+    fprintf(stderr, "Warning: Git index layout not supported, walking the "
+                    "directory instead\n");
+  }
+
+  /* Step 5: Call recursive scanner to collect files */
   if (scan_directory_recursive(config->base_path, config, file_paths) == -1) {
     fprintf(stderr, "Error: Failed to scan directory recursively\n");
     return -1;
   }
 
-  /* Step 5: Success */
+  /* Step 6: Success */
   return 0;
 }
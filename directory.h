@@ -2,30 +2,38 @@
 #define DIRECTORY_H
 
 #include "data_structs.h"
-
-/* File extension filter structure */
-typedef struct {
-  char **extensions; /* Array of extensions: ".jsx", ".tsx" */
-  size_t count;      /* Number of extensions */
-} ExtensionFilter;
+#include "path_filter.h"
+#include "snapshot.h"
 
 /* Directory scanning configuration */
 typedef struct {
-  const char *base_path;   /* Starting directory */
-  ExtensionFilter *filter; /* File extensions to include */
-  int max_depth;           /* Recursion limit (-1 = unlimited) */
-  int follow_symlinks;     /* Follow symbolic links? */
+  const char *base_path;    /* Starting directory */
+  const PathFilter *filter; /* Compiled include/exclude rules */
+  int use_ignore_files;     /* Honour .gitignore / .nointlignore? */
+  int use_git_index;        /* List tracked files from .git/index instead
+                               of walking the directory tree */
+  int max_depth;            /* Recursion limit (-1 = unlimited) */
+  int follow_symlinks;      /* Follow symbolic links?  Every physical
+                               directory is then read once, and listed
+                               under its shortest path; every physical
+                               file is listed once */
+  int num_threads;          /* Walker threads (0 = one per online CPU) */
+  const Snapshot *previous; /* Last run: unchanged dirs skip readdir */
+  Snapshot *next;           /* This run: dirs are recorded, files get
+                               size/mtime/inode (NULL = no snapshot) */
+  int want_sizes;           /* Stat every kept file, so its size is
+                               known (the pipeline orders by it) */
 } ScanConfig;
 
-/* Function declarations */
-ExtensionFilter *ext_filter_create(void);
-int ext_filter_add(ExtensionFilter *filter, const char *extension);
-void ext_filter_free(ExtensionFilter *filter);
-int ext_filter_matches(const ExtensionFilter *filter, const char *filename);
-
 /* Main directory scanning functions */
 int scan_directory_recursive(const char *path, const ScanConfig *config,
-                             DynamicArray *results);
-int collect_target_files(const ScanConfig *config, DynamicArray *file_paths);
+                             FileList *results);
+int collect_target_files(const ScanConfig *config, FileList *file_paths);
+
+/* Fills size, mtime_ns and ino of a file the walker did not stat */
+int stat_target_file(TargetFile *target);
+
+/* Number of walker threads to use when config->num_threads is 0 */
+int default_thread_count(void);
 
 #endif
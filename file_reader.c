@@ -1,10 +1,27 @@
+#define _DEFAULT_SOURCE /* MADV_SEQUENTIAL */
+#define _POSIX_C_SOURCE 200809L
 #include "file_reader.h"
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-#define INITIAL_BUFFER_SIZE 4096          /* 4KB initial buffer */
-#define MAX_FILE_SIZE (100 * 1024 * 1024) /* 100MB safety limit */
+#define MAP_THRESHOLD (64 * 1024) /* Smaller files are cheaper to pread() */
+#define STREAM_CONTEXT 256        /* Bytes of the last window kept around */
+
+struct FileStream {
+  FILE *file;
+  char *data;       /* STREAM_CONTEXT + window bytes */
+  size_t capacity;  /* Allocated bytes in data */
+  size_t size;      /* Bytes held in data */
+  size_t consumed;  /* Bytes of data already handed out */
+  size_t line;      /* Line number of data[consumed] */
+  int eof;          /* Nothing left to read from file */
+};
 
 /* Step 3A: Buffer creation */
 FileBuffer *fb_create(size_t initial_capacity) {
@@ -32,71 +49,431 @@ FileBuffer *fb_create(size_t initial_capacity) {
   /* Step 3: Initialize size and capacity */
   fb->size = 0;                    /* Buffer is empty, nothing read yet */
   fb->capacity = initial_capacity; /* This is what we allocated */
+  fb->mapped = 0;
+  fb->spare = NULL;
 
   return fb;
 }
 
-/* Step 3B: Read entire file into buffer */
-int fb_read_file(const char *filepath, FileBuffer *buffer) {
+/* Grows the content buffer to hold at least min_capacity bytes */
+int fb_reserve(FileBuffer *buffer, size_t min_capacity) {
+  if (min_capacity <= buffer->capacity)
+    return 0;
+  char *new_content = realloc(buffer->content, min_capacity);
+  if (!new_content) {
+    fprintf(stderr, "Error: Failed to grow buffer for file\n");
+    return -1;
+  }
+  buffer->content = new_content;
+  buffer->capacity = min_capacity;
+  return 0;
+}
+
+/* Reads the whole file without stat()ing it: size_hint (the size the
+   directory walker already knows, or -1) only pre-sizes the buffer, and
+   reading simply continues until EOF.  A file over limit bytes is
+   FB_TOO_BIG (an error at MAX_FILE_SIZE).                             */
+static int fb_read_limited(const char *filepath, long long size_hint,
+                           size_t limit, FileBuffer *buffer) {
   /* Step 1: Validate inputs */
   if (!filepath || !buffer) {
     fprintf(stderr, "Error: NULL filepath or buffer\n");
     return -1;
   }
 
-  /* Step 2: Get file size with stat() */
-  struct stat file_stat;
-  if (stat(filepath, &file_stat) == -1) {
-    perror("stat");
-    return -1;
-  }
+  fb_unmap(buffer);
 
-  /* Step 3: Check file size safety limits */
-  if (file_stat.st_size > MAX_FILE_SIZE) {
-    fprintf(stderr, "Error: File too large (%ld bytes)\n", file_stat.st_size);
+  /* Step 2: Check the known size against the limit */
+  if (size_hint > (long long)limit) {
+    if (limit < MAX_FILE_SIZE)
+      return FB_TOO_BIG;
+    fprintf(stderr, "Error: File too large (%lld bytes)\n", size_hint);
     return -1;
   }
 
-  if (file_stat.st_size > (off_t)buffer->capacity) {
-    char *new_content = realloc(buffer->content, (size_t)file_stat.st_size);
-    if (!new_content) {
-      fprintf(stderr, "Error: Failed to grow buffer for file\n");
-      return -1;
-    }
-    buffer->content = new_content;
-    buffer->capacity = (size_t)file_stat.st_size;
-  }
+  /* Step 3: Size the buffer for the whole file plus one byte, so the
+     EOF shows up as a short read and there's room for a terminator  */
+  if (size_hint >= 0 && fb_reserve(buffer, (size_t)size_hint + 1) == -1)
+    return -1;
 
-  /* Step 4: Open file for reading */
+  /* Step 4: Open file for reading (unbuffered - we read in big blocks) */
   FILE *file = fopen(filepath, "rb");
   if (!file) {
     perror("fopen");
     return -1;
   }
+  setvbuf(file, NULL, _IONBF, 0);
 
-  /* Step 5: Read entire file into buffer */
-  size_t bytes_read = fread(buffer->content, 1, file_stat.st_size, file);
-  if (bytes_read != (size_t)file_stat.st_size) {
-    fprintf(stderr,
-            "Error: Failed to read entire file (got %zu of %ld bytes)\n",
-            bytes_read, file_stat.st_size);
+  /* Step 5: Read until EOF, doubling the buffer if the file is bigger
+     than expected                                                     */
+  size_t bytes_read = 0;
+  for (;;) {
+    if (bytes_read + 1 >= buffer->capacity) {
+      if (bytes_read > limit) {
+        fclose(file);
+        if (limit < MAX_FILE_SIZE)
+          return FB_TOO_BIG;
+        fprintf(stderr, "Error: File too large (over %d bytes)\n",
+                MAX_FILE_SIZE);
+        return -1;
+      }
+      if (fb_reserve(buffer, buffer->capacity * 2) == -1) {
+        fclose(file);
+        return -1;
+      }
+    }
+    size_t room = buffer->capacity - 1 - bytes_read;
+    size_t got = fread(buffer->content + bytes_read, 1, room, file);
+    bytes_read += got;
+    if (got < room) {
+      if (ferror(file)) {
+        fprintf(stderr, "Error: Failed to read entire file (got %zu bytes)\n",
+                bytes_read);
+        fclose(file);
+        return -1;
+      }
+      break; /* EOF */
+    }
+  }
+  if (bytes_read > limit) {
     fclose(file);
-    return -1;
+    return limit < MAX_FILE_SIZE ? FB_TOO_BIG : -1;
   }
 
-  /* Step 6: Update buffer metadata */
+  /* Step 6: Update buffer metadata; keep the content NUL-terminated so
+     string functions never run past the end of the data             */
   buffer->size = bytes_read; /* How much we actually read */
-  /* capacity stays the same - it's what we allocated */
+  buffer->content[bytes_read] = '\0';
 
   /* Step 7: Cleanup and return success */
   fclose(file);
   return 0;
 }
 
+/* Step 3B: Read entire file into buffer */
+int fb_read_file(const char *filepath, FileBuffer *buffer) {
+  return fb_read_limited(filepath, -1, MAX_FILE_SIZE, buffer);
+}
+
+int fb_read_file_sized(const char *filepath, long long size_hint,
+                       FileBuffer *buffer) {
+  return fb_read_limited(filepath, size_hint, STREAM_THRESHOLD, buffer);
+}
+
+/* Drops a mapping and puts the heap buffer back in place */
+void fb_unmap(FileBuffer *buffer) {
+  if (!buffer || !buffer->mapped)
+    return;
+#ifndef _WIN32
+  munmap(buffer->content, buffer->size);
+#endif
+  buffer->content = buffer->spare;
+  buffer->spare = NULL;
+  buffer->mapped = 0;
+  buffer->size = 0;
+}
+
+static int map_allowed = 1; /* See fb_allow_mmap() */
+
+void fb_allow_mmap(int allow) { map_allowed = allow; }
+
+#ifndef _WIN32
+/* Small-file path: pread() into the heap buffer until EOF, after the
+   first done bytes that are already there                           */
+static int fb_pread_all(int fd, size_t expected, size_t done,
+                        FileBuffer *buffer) {
+  if (fb_reserve(buffer, expected + 1) == -1)
+    return -1;
+
+  size_t bytes_read = done;
+  for (;;) {
+    if (bytes_read + 1 >= buffer->capacity) {
+      if (buffer->capacity > MAX_FILE_SIZE) {
+        fprintf(stderr, "Error: File too large (over %d bytes)\n",
+                MAX_FILE_SIZE);
+        return -1;
+      }
+      if (fb_reserve(buffer, buffer->capacity * 2) == -1)
+        return -1;
+    }
+    ssize_t got = pread(fd, buffer->content + bytes_read,
+                        buffer->capacity - 1 - bytes_read, (off_t)bytes_read);
+    if (got < 0) {
+      perror("pread");
+      return -1;
+    }
+    if (got == 0)
+      break; /* EOF */
+    bytes_read += (size_t)got;
+  }
+
+  buffer->size = bytes_read;
+  buffer->content[bytes_read] = '\0';
+  return 0;
+}
+
+/* Reads up to want bytes from the start of the file; returns how many
+   it got (fewer only at EOF), or -1                                 */
+static long long fb_pread_head(int fd, size_t want, FileBuffer *buffer) {
+  if (fb_reserve(buffer, want + 1) == -1)
+    return -1;
+  size_t bytes_read = 0;
+  while (bytes_read < want) {
+    ssize_t got = pread(fd, buffer->content + bytes_read, want - bytes_read,
+                        (off_t)bytes_read);
+    if (got < 0) {
+      perror("pread");
+      return -1;
+    }
+    if (got == 0)
+      break; /* EOF */
+    bytes_read += (size_t)got;
+  }
+  return (long long)bytes_read;
+}
+#endif
+
+/* Zero-copy read: maps the file read-only and hands the mapping to the
+   parsers, so no byte is copied into a heap buffer first.  Files under
+   MAP_THRESHOLD (or empty) are pread() instead - for those a mapping
+   costs more in page-table setup than the copy it saves.  Of a file of
+   unknown size the first MAP_THRESHOLD bytes are pread() before
+   anything else, so a small one costs no fstat().  A mapped buffer is
+   not NUL-terminated.  Falls back to fb_read_limited() where mmap()
+   is not available.  A file over limit bytes is not read: the result
+   is FB_TOO_BIG and the caller streams it instead.                   */
+static int fb_map_limited(const char *filepath, long long size_hint,
+                          size_t limit, FileBuffer *buffer) {
+#ifdef _WIN32
+  return fb_read_limited(filepath, size_hint, limit, buffer);
+#else
+  /* Step 1: Validate inputs */
+  if (!filepath || !buffer) {
+    fprintf(stderr, "Error: NULL filepath or buffer\n");
+    return -1;
+  }
+  fb_unmap(buffer);
+
+  /* Step 2: Open the file */
+  int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    perror("open");
+    return -1;
+  }
+
+  /* Step 3: Known small files skip the fstat() too */
+  if (size_hint >= 0 && size_hint < MAP_THRESHOLD) {
+    int status = fb_pread_all(fd, (size_t)size_hint, 0, buffer);
+    close(fd);
+    return status;
+  }
+
+  /* Step 4: Unknown size - a file that ends within the first
+     MAP_THRESHOLD bytes is done without an fstat()              */
+  size_t head = 0;
+  if (size_hint < 0) {
+    long long got = fb_pread_head(fd, MAP_THRESHOLD, buffer);
+    if (got < 0) {
+      close(fd);
+      return -1;
+    }
+    head = (size_t)got;
+    if (head < MAP_THRESHOLD) {
+      buffer->size = head;
+      buffer->content[head] = '\0';
+      close(fd);
+      return 0;
+    }
+  }
+
+  /* Step 5: The mapping length must be exact */
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    perror("fstat");
+    close(fd);
+    return -1;
+  }
+  if ((size_t)file_stat.st_size > limit) {
+    close(fd);
+    if (limit < MAX_FILE_SIZE)
+      return FB_TOO_BIG;
+    fprintf(stderr, "Error: File too large (%lld bytes)\n",
+            (long long)file_stat.st_size);
+    return -1;
+  }
+  size_t size = (size_t)file_stat.st_size;
+  if (size < MAP_THRESHOLD || !map_allowed) {
+    int status = fb_pread_all(fd, size, head < size ? head : 0, buffer);
+    close(fd);
+    return status;
+  }
+
+  /* Step 6: Map it; the kernel reads ahead aggressively when told the
+     access is sequential                                             */
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* The mapping keeps the file referenced */
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return -1;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  buffer->spare = buffer->content;
+  buffer->content = map;
+  buffer->size = size;
+  buffer->mapped = 1;
+  return 0;
+#endif
+}
+
+int fb_map_file(const char *filepath, long long size_hint, FileBuffer *buffer) {
+  return fb_map_limited(filepath, size_hint, STREAM_THRESHOLD, buffer);
+}
+
+int fb_map_whole(const char *filepath, FileBuffer *buffer) {
+  return fb_map_limited(filepath, -1, MAX_FILE_SIZE, buffer);
+}
+
+/* Step 3E: Streaming reads for files too big to hold at once */
+FileStream *fs_open(const char *filepath, size_t window) {
+  if (!filepath || window == 0) {
+    fprintf(stderr, "Error: NULL filepath or empty window\n");
+    return NULL;
+  }
+  FileStream *stream = calloc(1, sizeof(FileStream));
+  if (!stream)
+    return NULL;
+
+  stream->capacity = STREAM_CONTEXT + window;
+  stream->data = malloc(stream->capacity);
+  stream->file = fopen(filepath, "rb");
+  if (!stream->data || !stream->file) {
+    if (!stream->file)
+      perror("fopen");
+    fs_close(stream);
+    return NULL;
+  }
+  setvbuf(stream->file, NULL, _IONBF, 0);
+  stream->line = 1;
+  return stream;
+}
+
+/* Slides the unread tail (plus a little context before it) to the
+   front of data and tops the buffer up from the file               */
+static int fs_fill(FileStream *stream) {
+  if (stream->consumed > STREAM_CONTEXT) {
+    size_t drop = stream->consumed - STREAM_CONTEXT;
+    memmove(stream->data, stream->data + drop, stream->size - drop);
+    stream->size -= drop;
+    stream->consumed -= drop;
+  }
+  if (stream->eof)
+    return 0;
+
+  size_t room = stream->capacity - stream->size;
+  size_t got = fread(stream->data + stream->size, 1, room, stream->file);
+  stream->size += got;
+  if (got < room) {
+    if (ferror(stream->file)) {
+      fprintf(stderr, "Error: Failed to read file\n");
+      return -1;
+    }
+    stream->eof = 1;
+  }
+  return 0;
+}
+
+int fs_next(FileStream *stream, FileWindow *view) {
+  for (;;) {
+    /* Step 1: Top the window up */
+    if (fs_fill(stream) == -1)
+      return -1;
+    const char *start = stream->data + stream->consumed;
+    size_t avail = stream->size - stream->consumed;
+    if (avail == 0)
+      return 0; /* EOF */
+
+    /* Step 2: Cut after the last complete line; at EOF the final line
+       needs no newline                                                */
+    size_t len = avail;
+    while (len > 0 && start[len - 1] != '\n')
+      len--;
+    if (len == 0 && stream->eof)
+      len = avail;
+
+    if (len > 0) {
+      view->content = start;
+      view->size = len;
+      view->context = stream->consumed;
+      view->first_line = stream->line;
+      for (const char *nl = memchr(start, '\n', len); nl;
+           nl = memchr(nl + 1, '\n', len - (size_t)(nl + 1 - start)))
+        stream->line++;
+      stream->consumed += len;
+      return 1;
+    }
+
+    /* Step 3: One line fills the whole window - make the window bigger
+       and read on, up to STREAM_MAX_LINE                             */
+    if (stream->capacity < STREAM_CONTEXT + STREAM_MAX_LINE) {
+      size_t grown = stream->capacity * 2;
+      if (grown > STREAM_CONTEXT + STREAM_MAX_LINE)
+        grown = STREAM_CONTEXT + STREAM_MAX_LINE;
+      char *bigger = realloc(stream->data, grown);
+      if (bigger) {
+        stream->data = bigger;
+        stream->capacity = grown;
+        continue;
+      }
+    }
+
+    /* Step 4: Longer still - drop it up to (and including) its
+       newline; it still counts as a line                         */
+    for (;;) {
+      start = stream->data + stream->consumed;
+      avail = stream->size - stream->consumed;
+      const char *nl = memchr(start, '\n', avail);
+      if (nl) {
+        stream->consumed += (size_t)(nl - start) + 1;
+        stream->line++;
+        break;
+      }
+      stream->consumed = stream->size;
+      if (stream->eof)
+        return 0;
+      if (fs_fill(stream) == -1)
+        return -1;
+    }
+  }
+}
+
+/* Starts the stream over from the first byte (for a second pass) */
+int fs_rewind(FileStream *stream) {
+  if (fseek(stream->file, 0, SEEK_SET) != 0) {
+    perror("fseek");
+    return -1;
+  }
+  stream->size = 0;
+  stream->consumed = 0;
+  stream->line = 1;
+  stream->eof = 0;
+  return 0;
+}
+
+void fs_close(FileStream *stream) {
+  if (!stream)
+    return;
+  if (stream->file)
+    fclose(stream->file);
+  free(stream->data);
+  free(stream);
+}
+
 /* Step 3C: Memory cleanup */
 void fb_free(FileBuffer *buffer) {
   if (!buffer)
     return;
+  fb_unmap(buffer);
   free(buffer->content);
   free(buffer);
 }
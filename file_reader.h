@@ -5,11 +5,22 @@
 
 /* File buffer structure for reading file contents */
 typedef struct {
-  char *content;   /* The actual file content */
+  char *content;   /* The actual file content (NUL-terminated after a read,
+                      NOT terminated when mapped - always honour size) */
   size_t size;     /* Number of bytes read */
   size_t capacity; /* Allocated buffer space */
+  int mapped;      /* content is a read-only mmap() of the file */
+  char *spare;     /* Heap buffer parked while content is mapped */
 } FileBuffer;
 
+#define INITIAL_BUFFER_SIZE 4096          /* 4KB initial buffer */
+#define MAX_FILE_SIZE (100 * 1024 * 1024) /* 100MB safety limit */
+#define STREAM_THRESHOLD (4 * 1024 * 1024) /* Bigger files are streamed */
+#define STREAM_WINDOW (1024 * 1024)        /* Bytes per streamed window */
+#define STREAM_MAX_LINE (16 * 1024 * 1024) /* A window grows to hold a line
+                                              up to this long */
+#define FB_TOO_BIG 1 /* Result of a read that was over its limit */
+
 /* File reading configuration */
 typedef struct {
   size_t initial_capacity; /* Starting buffer size */
@@ -17,10 +28,45 @@ typedef struct {
   int follow_symlinks;     /* Follow symbolic links? */
 } FileReadConfig;
 
+/* Reads a file one window at a time, always cut after a newline, so
+   memory stays bounded by the window whatever the file size          */
+typedef struct FileStream FileStream;
+
+/* One run of whole lines handed out by fs_next() */
+typedef struct {
+  const char *content; /* NOT NUL-terminated - honour size */
+  size_t size;         /* Bytes of whole lines (the last may lack '\n') */
+  size_t context;      /* Bytes of the file kept just before content */
+  size_t first_line;   /* Line number of content[0], from 1 */
+} FileWindow;
+
 /* Function declarations */
 FileBuffer *fb_create(size_t initial_capacity);
+int fb_reserve(FileBuffer *buffer, size_t min_capacity);
 int fb_read_file(const char *filepath, FileBuffer *buffer);
+/* fb_read_file_sized() and fb_map_file() read source files: one over
+   STREAM_THRESHOLD is not read but FB_TOO_BIG, for the caller to stream */
+int fb_read_file_sized(const char *filepath, long long size_hint,
+                       FileBuffer *buffer);
+int fb_map_file(const char *filepath, long long size_hint, FileBuffer *buffer);
+/* Same for data files of our own, whatever their size (up to
+   MAX_FILE_SIZE) - never FB_TOO_BIG                                */
+int fb_map_whole(const char *filepath, FileBuffer *buffer);
+/* allow = 0 makes fb_map_file() pread() every file: a mapped file that
+   is truncated while it is parsed raises SIGBUS, and editors truncate
+   files all the time under --watch.  Set it before any thread reads. */
+void fb_allow_mmap(int allow);
+void fb_unmap(FileBuffer *buffer);
 void fb_free(FileBuffer *buffer);
 void fb_print_preview(const FileBuffer *buffer, size_t max_chars);
 
+FileStream *fs_open(const char *filepath, size_t window);
+/* Returns 1 with the next window in *view, 0 at EOF, -1 on error.  A
+   line longer than the window grows it, up to STREAM_MAX_LINE; a line
+   longer still is dropped (its number is still counted).  The view
+   stays valid until the next call.                                   */
+int fs_next(FileStream *stream, FileWindow *view);
+int fs_rewind(FileStream *stream);
+void fs_close(FileStream *stream);
+
 #endif
@@ -0,0 +1,192 @@
+#include "findings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_FINDINGS 256
+#define FINDINGS_ARENA_BLOCK (256 * 1024)
+#define FINDINGS_NAMES_BLOCK (16 * 1024)
+#define MAX_LABEL 255
+#define PACKED_HEADER 16 /* line, col, kind + label length, text length */
+
+/* Tags of the kinds that carry no label */
+static const char *const KIND_TAGS[FINDING_KIND_COUNT] = {
+    "jsx", "prop", "toast", "set-state", "zod", "jsx-expr", "throw"};
+
+/* =====================================================================
+   LIFECYCLE
+   ===================================================================== */
+
+FindingList *findings_create(void) {
+  FindingList *list = calloc(1, sizeof(FindingList));
+  if (!list)
+    return NULL;
+  list->items = malloc(INITIAL_FINDINGS * sizeof(Finding));
+  list->paths = sv_create(FINDINGS_NAMES_BLOCK);
+  list->labels = sv_create(FINDINGS_NAMES_BLOCK);
+  list->label_index = hm_create(64);
+  list->arena = arena_create(FINDINGS_ARENA_BLOCK);
+  if (!list->items || !list->paths || !list->labels || !list->label_index ||
+      !list->arena) {
+    fprintf(stderr, "Error: malloc failed for FindingList\n");
+    findings_free(list);
+    return NULL;
+  }
+  list->capacity = INITIAL_FINDINGS;
+  return list;
+}
+
+void findings_free(FindingList *list) {
+  if (!list)
+    return;
+  free(list->items);
+  sv_free(list->paths);
+  sv_free(list->labels);
+  hm_free(list->label_index);
+  arena_free(list->arena);
+  free(list);
+}
+
+/* =====================================================================
+   ADDING
+   ===================================================================== */
+
+long findings_add_path(FindingList *list, const char *path) {
+  if (sv_append(list->paths, path) == -1)
+    return -1;
+  return (long)list->paths->size - 1;
+}
+
+/* Returns the stored copy of label, adding it the first time */
+static const char *intern_label(FindingList *list, const char *label,
+                                size_t len) {
+  size_t idx;
+  if (hm_get_span(list->label_index, label, len, &idx))
+    return list->labels->strings[idx];
+
+  if (len > MAX_LABEL)
+    len = MAX_LABEL;
+  if (sv_append_n(list->labels, label, len) == -1)
+    return NULL;
+  idx = list->labels->size - 1;
+  if (hm_put(list->label_index, list->labels->strings[idx], idx) == -1)
+    return NULL;
+  return list->labels->strings[idx];
+}
+
+int findings_add(FindingList *list, uint32_t file, size_t line, size_t col,
+                 FindingKind kind, const char *label, size_t label_len,
+                 const char *text, size_t text_len) {
+  /* Step 1: Make room */
+  if (list->size >= list->capacity) {
+    size_t new_capacity = list->capacity * 2;
+    Finding *grown = realloc(list->items, new_capacity * sizeof(Finding));
+    if (!grown) {
+      fprintf(stderr, "Error: malloc failed for finding\n");
+      return -1;
+    }
+    list->items = grown;
+    list->capacity = new_capacity;
+  }
+
+  /* Step 2: Copy what the record points to */
+  Finding *f = &list->items[list->size];
+  f->file = file;
+  f->line = (uint32_t)line;
+  f->col = (uint32_t)col;
+  f->kind = (uint32_t)kind;
+  f->label = label ? intern_label(list, label, label_len) : NULL;
+  f->text = arena_strndup(list->arena, text, text_len);
+  f->text_len = text_len;
+  if ((label && !f->label) || !f->text) {
+    fprintf(stderr, "Error: malloc failed for finding\n");
+    return -1;
+  }
+  list->size++;
+  return 0;
+}
+
+int findings_copy(FindingList *list, uint32_t file, const FindingList *src,
+                  size_t first, size_t count) {
+  for (size_t i = first; i < first + count; i++) {
+    const Finding *f = &src->items[i];
+    if (findings_add(list, file, f->line, f->col, (FindingKind)f->kind,
+                     f->label, f->label ? strlen(f->label) : 0, f->text,
+                     f->text_len) == -1)
+      return -1;
+  }
+  return 0;
+}
+
+void finding_tag(const Finding *f, char *buf, size_t size) {
+  if (f->kind == FINDING_PROP && f->label)
+    snprintf(buf, size, "prop:%s", f->label);
+  else if (f->kind == FINDING_JSX_TEXT && f->label)
+    snprintf(buf, size, "%s", f->label);
+  else
+    snprintf(buf, size, "%s",
+             f->kind < FINDING_KIND_COUNT ? KIND_TAGS[f->kind] : "?");
+}
+
+/* =====================================================================
+   PACKED FORM
+   Per finding: u32 line, u32 col, u32 kind << 16 | label_len,
+   u32 text_len, then the label and text bytes.  Host byte order, like
+   the rest of the snapshot.
+   ===================================================================== */
+
+char *findings_pack(const FindingList *list, size_t first, size_t count,
+                    size_t *len) {
+  /* Step 1: Size the block */
+  size_t total = 0;
+  for (size_t i = first; i < first + count; i++) {
+    const Finding *f = &list->items[i];
+    total += PACKED_HEADER + (f->label ? strlen(f->label) : 0) + f->text_len;
+  }
+  char *packed = malloc(total ? total : 1);
+  if (!packed)
+    return NULL;
+
+  /* Step 2: Fill it */
+  char *p = packed;
+  for (size_t i = first; i < first + count; i++) {
+    const Finding *f = &list->items[i];
+    uint32_t label_len = f->label ? (uint32_t)strlen(f->label) : 0;
+    uint32_t header[4] = {f->line, f->col, f->kind << 16 | label_len,
+                          (uint32_t)f->text_len};
+    memcpy(p, header, PACKED_HEADER);
+    p += PACKED_HEADER;
+    memcpy(p, f->label ? f->label : "", label_len);
+    p += label_len;
+    memcpy(p, f->text, f->text_len);
+    p += f->text_len;
+  }
+  *len = total;
+  return packed;
+}
+
+int findings_unpack(FindingList *list, uint32_t file, const char *packed,
+                    size_t len, size_t count) {
+  const char *p = packed;
+  const char *end = packed + len;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t header[4];
+    if ((size_t)(end - p) < PACKED_HEADER)
+      return -1;
+    memcpy(header, p, PACKED_HEADER);
+    p += PACKED_HEADER;
+
+    uint32_t kind = header[2] >> 16;
+    size_t label_len = header[2] & 0xffff;
+    size_t text_len = header[3];
+    if (kind >= FINDING_KIND_COUNT ||
+        (size_t)(end - p) < label_len + text_len)
+      return -1;
+    if (findings_add(list, file, header[0], header[1], (FindingKind)kind,
+                     label_len ? p : NULL, label_len, p + label_len,
+                     text_len) == -1)
+      return -1;
+    p += label_len + text_len;
+  }
+  return 0;
+}
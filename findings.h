@@ -0,0 +1,74 @@
+#ifndef FINDINGS_H
+#define FINDINGS_H
+
+#include "data_structs.h"
+#include <stdint.h>
+
+/* Which detector reported a finding */
+typedef enum {
+  FINDING_JSX_TEXT,  /* Pattern 1 - label is the element name */
+  FINDING_PROP,      /* Pattern 2 - label is the prop name */
+  FINDING_TOAST,     /* Pattern 3 */
+  FINDING_SET_STATE, /* Pattern 4 */
+  FINDING_ZOD,       /* Pattern 5 */
+  FINDING_JSX_EXPR,  /* Pattern 6 */
+  FINDING_THROW,     /* Pattern 7 */
+  FINDING_KIND_COUNT
+} FindingKind;
+
+/* One untranslated string */
+typedef struct {
+  uint32_t file;     /* Index into FindingList.paths */
+  uint32_t line;     /* From 1 */
+  uint32_t col;      /* From 1 */
+  uint32_t kind;     /* FindingKind */
+  const char *label; /* Interned in FindingList.labels, or NULL */
+  const char *text;  /* In FindingList.arena, NUL-terminated */
+  size_t text_len;
+} Finding;
+
+/* Every finding of a run, in the order they were added.  Paths and
+   labels are stored once each; texts live in one arena and are freed
+   with the list.                                                     */
+typedef struct {
+  Finding *items;
+  size_t size;
+  size_t capacity;
+  StringVec *paths;     /* File paths, indexed by Finding.file */
+  StringVec *labels;    /* Distinct labels */
+  HashMap *label_index; /* label -> index in labels */
+  Arena *arena;         /* Finding texts */
+} FindingList;
+
+FindingList *findings_create(void);
+void findings_free(FindingList *list);
+
+/* Registers path and returns its file index, or -1 */
+long findings_add_path(FindingList *list, const char *path);
+
+/* Appends a finding, copying label[0..label_len) (label may be NULL)
+   and text[0..text_len) - neither needs a NUL terminator             */
+int findings_add(FindingList *list, uint32_t file, size_t line, size_t col,
+                 FindingKind kind, const char *label, size_t label_len,
+                 const char *text, size_t text_len);
+
+/* Appends src->items[first, first + count) under file */
+int findings_copy(FindingList *list, uint32_t file, const FindingList *src,
+                  size_t first, size_t count);
+
+/* Writes the tag shown in reports ("h2", "prop:title", "zod", ...) */
+void finding_tag(const Finding *f, char *buf, size_t size);
+
+/* ── Packed form, as stored in snapshots ────────────────────────────── */
+
+/* Packs items[first, first + count) into one malloc'd block and sets
+   *len to its size.  Returns NULL if out of memory.                   */
+char *findings_pack(const FindingList *list, size_t first, size_t count,
+                    size_t *len);
+
+/* Appends count packed findings to list under file.  Returns -1 on a
+   block that does not hold them.                                       */
+int findings_unpack(FindingList *list, uint32_t file, const char *packed,
+                    size_t len, size_t count);
+
+#endif /* FINDINGS_H */
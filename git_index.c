@@ -0,0 +1,406 @@
+#define _DEFAULT_SOURCE /* realpath */
+#define _POSIX_C_SOURCE 200809L
+#include "git_index.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define INDEX_HEADER_SIZE 12
+#define INDEX_STAT_SIZE 40 /* ctime, mtime, dev, ino, mode, uid, gid, size */
+#define SHA1_SIZE 20
+#define SHA256_SIZE 32
+
+#define FLAG_EXTENDED 0x4000
+#define FLAG_STAGE_MASK 0x3000
+#define EXT_FLAG_SKIP_WORKTREE 0x4000
+
+/* =====================================================================
+   LOCATING THE INDEX
+   ===================================================================== */
+
+static char *resolve_path(const char *path) {
+#ifdef _WIN32
+  char *full = _fullpath(NULL, path, PATH_MAX);
+  if (full) {
+    for (char *p = full; *p; p++)
+      if (*p == '\\')
+        *p = '/';
+  }
+  return full;
+#else
+  return realpath(path, NULL);
+#endif
+}
+
+static int is_dir(const char *path) {
+  struct stat st;
+  return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/* Reads a whole file into a NUL-terminated heap buffer */
+static unsigned char *read_whole_file(const char *path, size_t *len_out) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  size_t cap = 64 * 1024, len = 0;
+  unsigned char *data = malloc(cap);
+  while (data) {
+    len += fread(data + len, 1, cap - len, file);
+    if (len < cap)
+      break;
+    unsigned char *bigger = realloc(data, cap * 2);
+    if (!bigger) {
+      free(data);
+      data = NULL;
+      break;
+    }
+    data = bigger;
+    cap *= 2;
+  }
+  fclose(file);
+  if (data)
+    data[len] = '\0'; /* len < cap whenever the loop ends normally */
+  *len_out = len;
+  return data;
+}
+
+/* Walks up from dir until a ".git" directory or file is found.
+   Fills root (the work tree) and git_dir.  Returns 0 on success.     */
+static int find_repository(const char *dir, char *root, char *git_dir) {
+  char path[PATH_MAX];
+  if (strlen(dir) >= sizeof(path))
+    return -1;
+  strcpy(root, dir);
+
+  for (;;) {
+    if (snprintf(path, sizeof(path), "%s/.git", root) >= (int)sizeof(path))
+      return -1;
+
+    if (is_dir(path)) {
+      strcpy(git_dir, path);
+      return 0;
+    }
+
+    /* Worktrees and submodules: ".git" is a file "gitdir: <path>" */
+    size_t len = 0;
+    char *text = (char *)read_whole_file(path, &len);
+    if (text) {
+      int found = 0;
+      if (len > 8 && strncmp(text, "gitdir: ", 8) == 0) {
+        size_t n = len - 8;
+        while (n > 0 && (text[8 + n - 1] == '\n' || text[8 + n - 1] == '\r'))
+          n--;
+        const char *target = text + 8;
+        int absolute = target[0] == '/' || (n > 1 && target[1] == ':');
+        int w = absolute ? snprintf(git_dir, PATH_MAX, "%.*s", (int)n, target)
+                         : snprintf(git_dir, PATH_MAX, "%s/%.*s", root,
+                                    (int)n, target);
+        found = w > 0 && w < PATH_MAX;
+      }
+      free(text);
+      return found ? 0 : -1;
+    }
+
+    /* Step up one directory */
+    char *slash = strrchr(root, '/');
+    if (!slash)
+      return -1;
+    if (slash == root) {
+      if (root[1] == '\0')
+        return -1; /* Already at "/" */
+      root[1] = '\0';
+    } else {
+      *slash = '\0';
+    }
+  }
+}
+
+/* Compares the n bytes at s with the lowercase word, ignoring case */
+static int word_is(const char *s, size_t n, const char *word) {
+  if (strlen(word) != n)
+    return 0;
+  for (size_t i = 0; i < n; i++) {
+    if (tolower((unsigned char)s[i]) != word[i])
+      return 0;
+  }
+  return 1;
+}
+
+/* SHA-256 repositories store 32-byte object ids in the index.  Reads
+   "objectformat" from the [extensions] section of the config; returns
+   0 if it names a format we do not know.                            */
+static size_t object_id_size(const char *git_dir) {
+  char path[PATH_MAX];
+  if (snprintf(path, sizeof(path), "%s/config", git_dir) >= (int)sizeof(path))
+    return SHA1_SIZE;
+  size_t len = 0;
+  char *config = (char *)read_whole_file(path, &len);
+  if (!config)
+    return SHA1_SIZE;
+
+  size_t size = SHA1_SIZE;
+  int in_extensions = 0;
+  for (char *line = config; line && *line;) {
+    char *eol = strchr(line, '\n');
+    if (eol)
+      *eol = '\0';
+
+    /* Step 1: Skip indentation; comments and blank lines say nothing */
+    char *p = line;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    line = eol ? eol + 1 : NULL;
+    if (*p == '\0' || *p == '#' || *p == ';')
+      continue;
+
+    /* Step 2: A section header - [extensions], not [remote "x"] */
+    if (*p == '[') {
+      char *close = strchr(p, ']');
+      in_extensions = close && word_is(p + 1, (size_t)(close - p - 1),
+                                       "extensions");
+      continue;
+    }
+    if (!in_extensions)
+      continue;
+
+    /* Step 3: objectformat = <value>, up to a comment */
+    char *key = p;
+    while (isalnum((unsigned char)*p) || *p == '-')
+      p++;
+    if (!word_is(key, (size_t)(p - key), "objectformat"))
+      continue;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p++ != '=')
+      continue;
+    while (*p == ' ' || *p == '\t' || *p == '"')
+      p++;
+    char *value = p;
+    while (*p && *p != '"' && *p != '#' && *p != ';' &&
+           !isspace((unsigned char)*p))
+      p++;
+    size_t value_len = (size_t)(p - value);
+    size = word_is(value, value_len, "sha1")     ? SHA1_SIZE
+           : word_is(value, value_len, "sha256") ? SHA256_SIZE
+                                                 : 0;
+  }
+  free(config);
+  return size;
+}
+
+/* =====================================================================
+   DIRC PARSING
+   ===================================================================== */
+
+static uint32_t be32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint16_t be16(const unsigned char *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/* Version 4 prefix length: git's "offset" varint encoding */
+static int read_varint(const unsigned char **pp, const unsigned char *end,
+                       size_t *out) {
+  const unsigned char *p = *pp;
+  if (p >= end)
+    return -1;
+  unsigned char c = *p++;
+  size_t val = c & 127;
+  while (c & 128) {
+    if (p >= end || val > (SIZE_MAX >> 8))
+      return -1;
+    c = *p++;
+    val = ((val + 1) << 7) | (c & 127);
+  }
+  *pp = p;
+  *out = val;
+  return 0;
+}
+
+/* Walks every index entry, keeping tracked regular files under prefix */
+static int parse_index(const unsigned char *data, size_t len, size_t oid_size,
+                       const char *prefix, const char *base_path,
+                       const PathFilter *filter, FileList *out) {
+  /* Step 1: Header - signature, version, entry count */
+  if (len < INDEX_HEADER_SIZE || memcmp(data, "DIRC", 4) != 0) {
+    fprintf(stderr, "Error: Not a git index (bad signature)\n");
+    return -1;
+  }
+  uint32_t version = be32(data + 4);
+  uint32_t count = be32(data + 8);
+  if (version < 2 || version > 4) {
+    fprintf(stderr, "Error: Unsupported git index version %u\n", version);
+    return -1;
+  }
+
+  size_t prefix_len = strlen(prefix);
+  size_t base_len = strlen(base_path);
+  char name[PATH_MAX];
+  size_t name_len = 0;
+  char last_kept[PATH_MAX] = "";
+
+  size_t first_kept = out->size;
+  const unsigned char *p = data + INDEX_HEADER_SIZE;
+  const unsigned char *end = data + len;
+  size_t fixed = INDEX_STAT_SIZE + oid_size + 2; /* + flags */
+
+  for (uint32_t i = 0; i < count; i++) {
+    /* Step 2: Fixed-size part of the entry */
+    const unsigned char *entry = p;
+    if ((size_t)(end - p) < fixed)
+      goto truncated;
+    uint32_t mode = be32(p + 24);
+    uint16_t flags = be16(p + INDEX_STAT_SIZE + oid_size);
+    p += fixed;
+
+    uint16_t ext_flags = 0;
+    if (version >= 3 && (flags & FLAG_EXTENDED)) {
+      if (end - p < 2)
+        goto truncated;
+      ext_flags = be16(p);
+      p += 2;
+    }
+
+    /* Step 3: The path - plain in v2/v3, prefix-compressed in v4 */
+    if (version == 4) {
+      size_t strip;
+      if (read_varint(&p, end, &strip) == -1 || strip > name_len)
+        goto truncated;
+      const unsigned char *nul = memchr(p, '\0', (size_t)(end - p));
+      if (!nul)
+        goto truncated;
+      size_t suffix = (size_t)(nul - p);
+      name_len -= strip;
+      if (name_len + suffix >= sizeof(name))
+        goto truncated;
+      memcpy(name + name_len, p, suffix);
+      name_len += suffix;
+      name[name_len] = '\0';
+      p = nul + 1;
+    } else {
+      const unsigned char *nul = memchr(p, '\0', (size_t)(end - p));
+      if (!nul || (size_t)(nul - p) >= sizeof(name))
+        goto truncated;
+      name_len = (size_t)(nul - p);
+      memcpy(name, p, name_len);
+      name[name_len] = '\0';
+      /* Entries are NUL-padded to a multiple of 8 bytes */
+      size_t entry_len = ((size_t)(nul - entry) + 8) & ~(size_t)7;
+      if ((size_t)(end - entry) < entry_len)
+        goto truncated;
+      p = entry + entry_len;
+    }
+
+    /* Step 4: Keep regular files, once, that are checked out */
+    if ((mode & 0170000) != 0100000)
+      continue; /* symlink, submodule, sparse directory */
+    if (ext_flags & EXT_FLAG_SKIP_WORKTREE)
+      continue;
+    if ((flags & FLAG_STAGE_MASK) != 0 && strcmp(name, last_kept) == 0)
+      continue; /* Conflict stages 2/3 of a path already kept */
+
+    /* Step 5: Only paths below the scanned directory */
+    const char *rel = name;
+    if (prefix_len > 0) {
+      if (strncmp(name, prefix, prefix_len) != 0 || name[prefix_len] != '/')
+        continue;
+      rel = name + prefix_len + 1;
+    }
+    if (!path_filter_match_path(filter, rel, 0))
+      continue;
+
+    size_t rel_len = strlen(rel);
+    char *full = fl_path_alloc(out, base_len + 1 + rel_len);
+    if (!full)
+      return -1;
+    memcpy(full, base_path, base_len);
+    full[base_len] = '/';
+    memcpy(full + base_len + 1, rel, rel_len + 1);
+    /* The index's cached size is stale once the file is edited, so
+       the size is left unknown rather than trusted as a read hint   */
+    if (fl_append(out, full, -1) == -1)
+      return -1;
+    memcpy(last_kept, name, name_len + 1);
+  }
+
+  /* Step 6: Extensions, up to the trailing checksum.  A split index
+     ("link") keeps most entries in a shared index file, so what was
+     read above is only part of the list.                            */
+  while ((size_t)(end - p) >= 8 + oid_size) {
+    uint32_t ext_len = be32(p + 4);
+    if (memcmp(p, "link", 4) == 0) {
+      out->size = first_kept;
+      return GIT_INDEX_UNSUPPORTED;
+    }
+    if ((size_t)(end - p) - 8 - oid_size < ext_len)
+      goto truncated;
+    p += 8 + ext_len;
+  }
+  return 0;
+
+truncated:
+  fprintf(stderr, "Error: Truncated or corrupt git index\n");
+  return -1;
+}
+
+int git_index_collect(const char *base_path, const PathFilter *filter,
+                      FileList *out) {
+  if (!base_path || !filter || !out)
+    return -1;
+
+  /* Step 1: Resolve the scanned directory and find its repository */
+  char *base_real = resolve_path(base_path);
+  if (!base_real) {
+    perror("realpath");
+    return -1;
+  }
+  char root[PATH_MAX], git_dir[PATH_MAX];
+  if (find_repository(base_real, root, git_dir) == -1) {
+    fprintf(stderr, "Error: %s is not inside a git work tree\n", base_path);
+    free(base_real);
+    return -1;
+  }
+
+  /* Step 2: Prefix of the scanned directory inside the work tree */
+  size_t root_len = strlen(root);
+  const char *prefix = base_real + root_len;
+  if (root_len == 1) /* root is "/" */
+    prefix = base_real + 1;
+  while (*prefix == '/')
+    prefix++;
+
+  /* Step 3: Read the index - one sequential read of one file */
+  char index_path[PATH_MAX];
+  if (snprintf(index_path, sizeof(index_path), "%s/index", git_dir) >=
+      (int)sizeof(index_path)) {
+    free(base_real);
+    return -1;
+  }
+  size_t len = 0;
+  unsigned char *data = read_whole_file(index_path, &len);
+  if (!data) {
+    fprintf(stderr, "Error: Cannot read git index %s\n", index_path);
+    free(base_real);
+    return -1;
+  }
+
+  /* Step 4: Parse entries into the file list */
+  size_t oid_size = object_id_size(git_dir);
+  int status = oid_size == 0 ? GIT_INDEX_UNSUPPORTED
+                             : parse_index(data, len, oid_size, prefix,
+                                           base_path, filter, out);
+  free(data);
+  free(base_real);
+  return status;
+}
@@ -0,0 +1,22 @@
+#ifndef GIT_INDEX_H
+#define GIT_INDEX_H
+
+#include "data_structs.h"
+#include "path_filter.h"
+
+#define GIT_INDEX_UNSUPPORTED -2
+
+/* Lists the tracked files below base_path straight from the git index
+   (.git/index, DIRC versions 2-4) - no git subprocess, no tree walk.
+   Only regular files at stage 0 are kept (no symlinks, submodules or
+   skip-worktree entries); each one must pass filter, with its path
+   relative to base_path.  Sizes are left unknown (-1): the index's
+   copy is stale for any file edited since it was staged.
+   Returns 0 on success, -1 if no repository or index was found, and
+   GIT_INDEX_UNSUPPORTED (listing nothing) for a split index, whose
+   entries are spread over two files, or an object format other than
+   SHA-1 and SHA-256.                                                 */
+int git_index_collect(const char *base_path, const PathFilter *filter,
+                      FileList *out);
+
+#endif /* GIT_INDEX_H */
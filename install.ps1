@@ -18,8 +18,10 @@ if (-not (Get-Command gcc -ErrorAction SilentlyContinue)) {
 }
 
 Push-Location $RepoDir
-gcc -Wall -Wextra -std=c99 -O2 -o $ExeName `
-    main.c data_structs.c directory.c file_reader.c text_parser.c
+gcc -Wall -Wextra -std=c99 -O2 -pthread -o $ExeName `
+    main.c data_structs.c directory.c file_reader.c git_index.c path_filter.c read_ahead.c `
+    snapshot.c text_parser.c watch.c byte_scan.c lexer.c word_tables.c findings.c `
+    scan_pipeline.c report.c content_cache.c binary_io.c
 if ($LASTEXITCODE -ne 0) {
     Write-Error "Compilation failed."
     exit 1
@@ -0,0 +1,512 @@
+#include "lexer.h"
+#include "word_tables.h"
+#include <ctype.h>
+#include <string.h>
+
+/* LexFrame.mode */
+enum { LEX_JS, LEX_TEMPLATE, LEX_TAG, LEX_CHILD };
+
+/* LexFrame.flags */
+#define TAG_CLOSING 1   /* </name> */
+#define TAG_NAMED 2     /* The element name was read */
+#define TPL_SUBST 1     /* Template holds a ${...} */
+#define TPL_CARRIED 2   /* Template started in an earlier buffer */
+
+#define PARAMS_LOOKAHEAD 512 /* Bytes searched for the ")" of "<T>(...)" */
+
+/* Lexer.pending */
+enum { PENDING_NONE, PENDING_COMMENT, PENDING_QUOTE };
+
+unsigned lexer_index_classes(void) {
+  return 1u << BS_NEWLINE | 1u << BS_DQUOTE | 1u << BS_SQUOTE |
+         1u << BS_LT | 1u << BS_LBRACE;
+}
+
+void lexer_start(Lexer *lx, int allow_jsx) {
+  memset(lx, 0, sizeof(Lexer));
+  lx->frames[0].mode = LEX_JS;
+  lx->allow_jsx = allow_jsx;
+  lx->last_kind = -1;
+}
+
+void lexer_start_after(Lexer *lx, int allow_jsx, char last) {
+  lexer_start(lx, allow_jsx);
+  lx->last_kind = TOK_PUNCT;
+  lx->last_char = last;
+}
+
+int lexer_at_top_level(const Lexer *lx, char last) {
+  return lx->depth == 0 && lx->pending == PENDING_NONE &&
+         lx->frames[0].mode == LEX_JS && lx->frames[0].braces == 0 &&
+         lx->frames[0].flags == 0 && lx->last_kind == TOK_PUNCT &&
+         lx->last_char == last && !lx->last_keyword;
+}
+
+void lexer_feed(Lexer *lx, const char *text, size_t size, size_t first_line,
+                const ByteIndex *index) {
+  lx->text = text;
+  lx->size = size;
+  lx->pos = 0;
+  lx->index = index;
+  lx->line = first_line;
+  lx->line_start = 0;
+  lx->counted = 0;
+  for (int i = 0; i <= lx->depth; i++) {
+    if (lx->frames[i].mode == LEX_TEMPLATE)
+      lx->frames[i].flags |= TPL_CARRIED;
+  }
+}
+
+/* =====================================================================
+   HELPERS
+   ===================================================================== */
+
+static int is_ident_char(unsigned char c) {
+  return isalnum(c) || c == '_' || c == '$' || c >= 0x80;
+}
+
+static int is_name_char(unsigned char c) {
+  return is_ident_char(c) || c == '-' || c == ':' || c == '.';
+}
+
+static int quote_class(char q) {
+  return q == '"' ? BS_DQUOTE : BS_SQUOTE;
+}
+
+/* Offset of the next byte of class c in [from, size), or size */
+static size_t next_of(const Lexer *lx, int c, size_t from) {
+  return byte_index_next(lx->index, c, from, lx->size);
+}
+
+/* Counts the newlines up to off, so tokens get line and column */
+static void locate(Lexer *lx, size_t off, size_t *line, size_t *col) {
+  for (;;) {
+    size_t nl = byte_index_next(lx->index, BS_NEWLINE, lx->counted, off);
+    if (nl >= off)
+      break;
+    lx->line++;
+    lx->line_start = nl + 1;
+    lx->counted = nl + 1;
+  }
+  lx->counted = off;
+  *line = lx->line;
+  *col = off - lx->line_start + 1;
+}
+
+static int emit(Lexer *lx, Token *tok, TokenKind kind, size_t off, size_t len,
+                size_t next_pos) {
+  tok->kind = kind;
+  tok->ptr = lx->text + off;
+  tok->len = len;
+  tok->tag = NULL;
+  locate(lx, off, &tok->line, &tok->col);
+  lx->pos = next_pos;
+  lx->last_kind = (int)kind;
+  lx->last_char = len ? lx->text[off] : '\0';
+  lx->last_keyword = 0;
+  return 1;
+}
+
+static void push(Lexer *lx, int mode) {
+  /* Too deep to be real code: start over at the top level */
+  if (lx->depth + 1 >= LEXER_MAX_DEPTH) {
+    lx->depth = 0;
+    return;
+  }
+  LexFrame *f = &lx->frames[++lx->depth];
+  f->mode = (unsigned char)mode;
+  f->flags = 0;
+  f->braces = 0;
+  f->tag[0] = '\0';
+}
+
+static void pop(Lexer *lx) {
+  if (lx->depth > 0)
+    lx->depth--;
+}
+
+/* Returns 1 if the previous token leaves us where an expression starts,
+   so '/' opens a regex and '<' a JSX tag rather than dividing or
+   comparing                                                          */
+static int expression_start(const Lexer *lx) {
+  if (lx->last_kind == -1)
+    return 1;
+  if (lx->last_kind == TOK_PUNCT)
+    return lx->last_char != ')' && lx->last_char != ']' &&
+           lx->last_char != '}';
+  if (lx->last_kind == TOK_WORD)
+    return lx->last_keyword;
+  return 0;
+}
+
+/* Skips to the end of a block comment; leaves it pending if this
+   buffer ends first                                                 */
+static void skip_block_comment(Lexer *lx, size_t from) {
+  const char *t = lx->text;
+  size_t p = from;
+  while (p < lx->size) {
+    const char *star = memchr(t + p, '*', lx->size - p);
+    if (!star)
+      break;
+    p = (size_t)(star - t) + 1;
+    if (p < lx->size && t[p] == '/') {
+      lx->pos = p + 1;
+      lx->pending = PENDING_NONE;
+      return;
+    }
+  }
+  lx->pos = lx->size;
+  lx->pending = PENDING_COMMENT;
+}
+
+/* Finds the quote closing an attribute string, which may span lines;
+   leaves it pending if this buffer ends first                       */
+static size_t find_attr_quote(Lexer *lx, char quote, size_t from) {
+  size_t end = next_of(lx, quote_class(quote), from);
+  if (end >= lx->size) {
+    lx->pending = PENDING_QUOTE;
+    lx->quote = quote;
+  } else {
+    lx->pending = PENDING_NONE;
+  }
+  return end;
+}
+
+/* =====================================================================
+   JAVASCRIPT
+   ===================================================================== */
+
+static int lex_js_string(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t p = lx->pos;
+  char q = t[p];
+  size_t nl = next_of(lx, BS_NEWLINE, p + 1);
+
+  /* The closing quote is the first one not escaped by a backslash */
+  size_t e = p + 1;
+  for (;;) {
+    e = byte_index_next(lx->index, quote_class(q), e, nl);
+    if (e >= nl)
+      break;
+    size_t slashes = 0;
+    while (e - slashes > p + 1 && t[e - slashes - 1] == '\\')
+      slashes++;
+    if (slashes % 2 == 0)
+      break;
+    e++;
+  }
+  if (e >= nl) { /* Unterminated - give up at the end of the line */
+    lx->pos = nl;
+    return 0;
+  }
+  return emit(lx, tok, TOK_STRING, p + 1, e - p - 1, e + 1);
+}
+
+static int lex_regex(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t start = lx->pos;
+  size_t p = start + 1;
+  int in_class = 0;
+  while (p < lx->size && t[p] != '\n') {
+    if (t[p] == '\\') {
+      p += 2;
+      continue;
+    }
+    if (t[p] == '[')
+      in_class = 1;
+    else if (t[p] == ']')
+      in_class = 0;
+    else if (t[p] == '/' && !in_class) {
+      p++;
+      break;
+    }
+    p++;
+  }
+  if (p > lx->size)
+    p = lx->size;
+  while (p < lx->size && is_ident_char((unsigned char)t[p]))
+    p++; /* flags */
+  return emit(lx, tok, TOK_OTHER, start, p - start, p);
+}
+
+/* Returns 1 if the '<' at p opens TypeScript type parameters rather
+   than a tag.  TSX writes them so they cannot parse as JSX: "<T,>",
+   "<T extends U>", "<T = U>", and in types "<T>(...) =>" or
+   "<T>(...):" - the last two only for a capitalised name, as
+   <span>(note)</span> is JSX.                                      */
+static int type_parameters(const Lexer *lx, size_t p) {
+  const char *t = lx->text;
+  size_t n = lx->size;
+  size_t e = p + 1;
+  while (e < n && is_ident_char((unsigned char)t[e]))
+    e++;
+  size_t a = e;
+  while (a < n && (t[a] == ' ' || t[a] == '\t'))
+    a++;
+  if (a >= n)
+    return 0;
+  if (t[a] == ',' || (t[a] == '=' && (a + 1 >= n || t[a + 1] != '>')))
+    return 1;
+  if (a > e && n - a > 7 && memcmp(t + a, "extends", 7) == 0 &&
+      !is_ident_char((unsigned char)t[a + 7]))
+    return 1;
+
+  /* "<T>(": find the matching ")" and see what follows it */
+  if (t[a] != '>' || !isupper((unsigned char)t[p + 1]) || a + 1 >= n ||
+      t[a + 1] != '(')
+    return 0;
+  size_t limit = n - a > PARAMS_LOOKAHEAD ? a + PARAMS_LOOKAHEAD : n;
+  size_t q = a + 1;
+  for (int parens = 0; q < limit; q++) {
+    parens += (t[q] == '(') - (t[q] == ')');
+    if (parens == 0)
+      break;
+  }
+  if (q >= limit)
+    return 0;
+  for (q++; q < n && (t[q] == ' ' || t[q] == '\t'); q++)
+    ;
+  return q < n &&
+         (t[q] == ':' || (t[q] == '=' && q + 1 < n && t[q + 1] == '>'));
+}
+
+static int lex_js(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t n = lx->size;
+  size_t p = lx->pos;
+  unsigned char c = (unsigned char)t[p];
+  LexFrame *f = &lx->frames[lx->depth];
+
+  if (isspace(c)) {
+    while (p < n && isspace((unsigned char)t[p]))
+      p++;
+    lx->pos = p;
+    return 0;
+  }
+  if (c == '/' && p + 1 < n && t[p + 1] == '/') {
+    lx->pos = next_of(lx, BS_NEWLINE, p);
+    return 0;
+  }
+  if (c == '/' && p + 1 < n && t[p + 1] == '*') {
+    skip_block_comment(lx, p + 2);
+    return 0;
+  }
+  if (c == '"' || c == '\'')
+    return lex_js_string(lx, tok);
+  if (c == '`') {
+    push(lx, LEX_TEMPLATE);
+    lx->frames[lx->depth].braces = p + 1; /* Where its text starts */
+    lx->pos = p + 1;
+    return 0;
+  }
+  if (is_ident_char(c)) {
+    size_t e = p + 1;
+    while (e < n && is_ident_char((unsigned char)t[e]))
+      e++;
+    emit(lx, tok, TOK_WORD, p, e - p, e);
+    lx->last_keyword = expr_keyword_index(t + p, e - p) >= 0;
+    return 1;
+  }
+  if (c == '/' && expression_start(lx))
+    return lex_regex(lx, tok);
+  if (c == '<' && lx->allow_jsx && expression_start(lx) && p + 1 < n &&
+      (isalpha((unsigned char)t[p + 1]) || t[p + 1] == '>') &&
+      !type_parameters(lx, p)) {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    push(lx, LEX_TAG);
+    return 1;
+  }
+  if (c == '{') {
+    f->braces++;
+    return emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+  }
+  if (c == '}') {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    if (f->braces > 0)
+      f->braces--;
+    else
+      pop(lx); /* Closes a {...} embedded in JSX or ${...} in a template */
+    return 1;
+  }
+  if (c == '=' && p + 1 < n && t[p + 1] == '>')
+    return emit(lx, tok, TOK_PUNCT, p, 2, p + 2);
+  return emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+}
+
+/* Inside `...`: frame->braces holds where the text started */
+static int lex_template(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t p = lx->pos;
+  LexFrame *f = &lx->frames[lx->depth];
+
+  while (p < lx->size) {
+    if (t[p] == '\\') {
+      p += 2;
+      continue;
+    }
+    if (t[p] == '`') {
+      int plain = !(f->flags & (TPL_SUBST | TPL_CARRIED));
+      size_t start = f->braces;
+      pop(lx);
+      if (plain)
+        return emit(lx, tok, TOK_STRING, start, p - start, p + 1);
+      return emit(lx, tok, TOK_OTHER, p, 1, p + 1);
+    }
+    if (t[p] == '$' && p + 1 < lx->size && t[p + 1] == '{') {
+      f->flags |= TPL_SUBST;
+      lx->pos = p + 2;
+      push(lx, LEX_JS);
+      return 0;
+    }
+    p++;
+  }
+  lx->pos = lx->size;
+  return 0;
+}
+
+/* =====================================================================
+   JSX
+   ===================================================================== */
+
+/* Inside <...> */
+static int lex_tag(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t n = lx->size;
+  size_t p = lx->pos;
+  unsigned char c = (unsigned char)t[p];
+  LexFrame *f = &lx->frames[lx->depth];
+
+  if (isspace(c)) {
+    while (p < n && isspace((unsigned char)t[p]))
+      p++;
+    lx->pos = p;
+    return 0;
+  }
+  if (c == '/' && p + 1 < n && t[p + 1] == '>') {
+    emit(lx, tok, TOK_PUNCT, p, 2, p + 2);
+    pop(lx); /* Self-closing: no children */
+    return 1;
+  }
+  if (c == '/') {
+    f->flags |= TAG_CLOSING;
+    return emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+  }
+  if (c == '>') {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    if (f->flags & TAG_CLOSING) {
+      pop(lx);
+      if (lx->frames[lx->depth].mode == LEX_CHILD)
+        pop(lx); /* The element ends */
+    } else {
+      char tag[LEXER_TAG_MAX];
+      memcpy(tag, f->tag, sizeof(tag));
+      pop(lx);
+      push(lx, LEX_CHILD);
+      memcpy(lx->frames[lx->depth].tag, tag, sizeof(tag));
+    }
+    return 1;
+  }
+  if (c == '"' || c == '\'') {
+    size_t e = find_attr_quote(lx, (char)c, p + 1);
+    if (e >= n) {
+      lx->pos = n;
+      return 0;
+    }
+    return emit(lx, tok, TOK_STRING, p + 1, e - p - 1, e + 1);
+  }
+  if (c == '{') {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    push(lx, LEX_JS);
+    return 1;
+  }
+  if (is_name_char(c)) {
+    size_t e = p + 1;
+    while (e < n && is_name_char((unsigned char)t[e]))
+      e++;
+    if (!(f->flags & TAG_NAMED)) {
+      size_t len = e - p < LEXER_TAG_MAX ? e - p : LEXER_TAG_MAX - 1;
+      memcpy(f->tag, t + p, len);
+      f->tag[len] = '\0';
+      f->flags |= TAG_NAMED;
+    }
+    return emit(lx, tok, TOK_JSX_NAME, p, e - p, e);
+  }
+  if (c == ';' || c == '(' || c == ')') {
+    /* Not JSX after all - a comparison the heuristic took for a tag.
+       Lex this byte again in the parent context.                     */
+    pop(lx);
+    return 0;
+  }
+  return emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+}
+
+/* Between <tag> and </tag> */
+static int lex_child(Lexer *lx, Token *tok) {
+  const char *t = lx->text;
+  size_t p = lx->pos;
+  LexFrame *f = &lx->frames[lx->depth];
+
+  if (t[p] == '<') {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    push(lx, LEX_TAG);
+    return 1;
+  }
+  if (t[p] == '{') {
+    emit(lx, tok, TOK_PUNCT, p, 1, p + 1);
+    push(lx, LEX_JS);
+    return 1;
+  }
+
+  /* Text runs to the next tag or expression, across lines */
+  size_t lt = next_of(lx, BS_LT, p);
+  size_t brace = next_of(lx, BS_LBRACE, p);
+  size_t e = lt < brace ? lt : brace;
+  size_t a = p, b = e;
+  while (a < b && isspace((unsigned char)t[a]))
+    a++;
+  while (b > a && isspace((unsigned char)t[b - 1]))
+    b--;
+  if (a == b) {
+    lx->pos = e;
+    return 0;
+  }
+  emit(lx, tok, TOK_JSX_TEXT, a, b - a, e);
+  tok->tag = f->tag[0] ? f->tag : "jsx";
+  return 1;
+}
+
+/* =====================================================================
+   DRIVER
+   ===================================================================== */
+
+int lexer_next(Lexer *lx, Token *tok) {
+  /* Step 1: Finish what the previous buffer left open */
+  if (lx->pending == PENDING_COMMENT) {
+    skip_block_comment(lx, lx->pos);
+  } else if (lx->pending == PENDING_QUOTE) {
+    size_t e = find_attr_quote(lx, lx->quote, lx->pos);
+    lx->pos = e < lx->size ? e + 1 : lx->size;
+  }
+
+  /* Step 2: Lex in whatever context is on top of the stack */
+  while (lx->pos < lx->size) {
+    int got;
+    switch (lx->frames[lx->depth].mode) {
+    case LEX_JS:
+      got = lex_js(lx, tok);
+      break;
+    case LEX_TEMPLATE:
+      got = lex_template(lx, tok);
+      break;
+    case LEX_TAG:
+      got = lex_tag(lx, tok);
+      break;
+    default:
+      got = lex_child(lx, tok);
+      break;
+    }
+    if (got)
+      return 1;
+  }
+  return 0;
+}
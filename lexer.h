@@ -0,0 +1,89 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "byte_scan.h"
+#include <stddef.h>
+
+/* A single-pass TSX/JSX lexer.  It tracks JavaScript, template
+   literal, JSX tag and JSX child contexts on a stack, skips comments,
+   and hands out tokens that point straight into the buffer.
+   Whitespace and comments produce no token.                          */
+
+typedef enum {
+  TOK_WORD,     /* Identifier, keyword or number */
+  TOK_PUNCT,    /* One character, or "=>" / "/>" */
+  TOK_STRING,   /* '...' "..." or `...` without ${}: ptr/len cover the
+                   text between the quotes */
+  TOK_OTHER,    /* Regex or template with ${}: nothing to report */
+  TOK_JSX_NAME, /* Tag or attribute name inside <...> */
+  TOK_JSX_TEXT  /* Text between JSX tags, whitespace-trimmed */
+} TokenKind;
+
+typedef struct {
+  TokenKind kind;
+  const char *ptr; /* Into the buffer - NOT NUL-terminated */
+  size_t len;
+  size_t line;     /* Of ptr[0], from 1 */
+  size_t col;      /* Of ptr[0], from 1 */
+  const char *tag; /* TOK_JSX_TEXT: innermost element ("jsx" for <>) */
+} Token;
+
+#define LEXER_MAX_DEPTH 64 /* Deeper nesting restarts at the top level */
+#define LEXER_TAG_MAX 64   /* Longer tag names are cut */
+
+/* One entry of the context stack */
+typedef struct {
+  unsigned char mode;  /* LEX_JS / LEX_TEMPLATE / LEX_TAG / LEX_CHILD */
+  unsigned char flags; /* LEX_TAG: closing tag / name seen */
+  size_t braces;       /* LEX_JS: '{' still open in this frame;
+                          LEX_TEMPLATE: offset where its text starts */
+  char tag[LEXER_TAG_MAX]; /* LEX_TAG / LEX_CHILD: element name */
+} LexFrame;
+
+/* The lexer state.  It survives lexer_feed(), so a file read one
+   window at a time is lexed as one text: comments, attribute strings
+   and JSX nesting carry on across a cut.  A token that starts in one
+   window and ends in the next is dropped.                           */
+typedef struct {
+  /* Current buffer */
+  const char *text;
+  size_t size;
+  size_t pos;
+  const ByteIndex *index; /* Bitmaps of text (see lexer_index_classes) */
+  size_t line;            /* Line of line_start */
+  size_t line_start;      /* Offset where line begins */
+  size_t counted;         /* Newlines before this offset are counted */
+
+  /* Carried between buffers */
+  LexFrame frames[LEXER_MAX_DEPTH];
+  int depth;        /* Index of the current frame */
+  int pending;      /* A comment or string the last buffer left open */
+  char quote;       /* ...closed by this byte */
+  int allow_jsx;    /* 0 for .ts files: '<' is never a tag */
+  int last_kind;    /* Kind of the previous token, or -1 */
+  char last_char;   /* ...its first byte */
+  int last_keyword; /* ...it was a keyword an expression may follow */
+} Lexer;
+
+/* Byte classes lexer_feed() needs indexed (for byte_index_build) */
+unsigned lexer_index_classes(void);
+
+/* Resets lx for a new file */
+void lexer_start(Lexer *lx, int allow_jsx);
+
+/* Resets lx to the state it is in right after the punctuation last
+   (';' or '}') at the top level of a file, with nothing left open   */
+void lexer_start_after(Lexer *lx, int allow_jsx, char last);
+
+/* Returns 1 if lx is in exactly that state */
+int lexer_at_top_level(const Lexer *lx, char last);
+
+/* Continues with text[0..size), whose first byte is on first_line and
+   at the start of a line.  index must cover exactly this text.      */
+void lexer_feed(Lexer *lx, const char *text, size_t size, size_t first_line,
+                const ByteIndex *index);
+
+/* Returns 1 with the next token in *tok, or 0 at the end of the text */
+int lexer_next(Lexer *lx, Token *tok);
+
+#endif /* LEXER_H */
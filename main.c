@@ -1,12 +1,20 @@
+#include "content_cache.h"
 #include "data_structs.h"
 #include "directory.h"
 #include "file_reader.h"
+#include "findings.h"
+#include "path_filter.h"
+#include "read_ahead.h"
+#include "report.h"
+#include "scan_pipeline.h"
+#include "snapshot.h"
 #include "text_parser.h"
+#include "watch.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define INITIAL_BUFFER_SIZE 4096 /* 4KB initial buffer */
+#define DEFAULT_READ_AHEAD 32    /* Files in flight ahead of the parser */
 
 void display_banner() {
   printf("\n");
@@ -21,169 +29,634 @@ void display_banner() {
   printf("\n");
 }
 
-int main(int argc, char *argv[]) {
-  /* Display project banner */
-  display_banner();
+void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options] <directory>\n", prog);
+  fprintf(stderr, "       %s --merge PARTIAL...\n", prog);
+  fprintf(stderr, "  --threads N      walker and parser threads (default:\n"
+                  "                   one per CPU)\n");
+  fprintf(stderr, "  --include GLOB   only scan matching files (repeatable,\n"
+                  "                   default: *.tsx *.jsx *.ts *.js)\n");
+  fprintf(stderr, "  --exclude GLOB   skip matching files/dirs (repeatable,\n"
+                  "                   .gitignore syntax)\n");
+  fprintf(stderr, "  --no-ignore      don't read .gitignore / .nointlignore\n");
+  fprintf(stderr, "  --follow-symlinks  walk into linked folders and files,\n"
+                  "                   each physical one scanned once\n");
+  fprintf(stderr, "  --git-index      scan the files tracked in .git/index\n"
+                  "                   instead of walking the directory\n");
+  fprintf(stderr, "  --snapshot FILE  reuse the results of the last run for\n"
+                  "                   unchanged files and directories\n");
+  fprintf(stderr, "  --read-ahead N   files read ahead of the parser\n"
+                  "                   (default: 32, 0 = read each file when\n"
+                  "                   parsed)\n");
+  fprintf(stderr, "  --no-io-uring    read ahead with threads, not io_uring\n");
+  fprintf(stderr, "  --watch          keep running and rescan files as they\n"
+                  "                   change (Linux only)\n");
+  fprintf(stderr, "  --cache DIR      reuse the results of earlier runs for\n"
+                  "                   files with the same contents\n");
+  fprintf(stderr, "  --cache-size MB  size cap of the cache (default: 64)\n");
+  fprintf(stderr, "  --shard K/N      scan only the K-th of N parts of the\n"
+                  "                   files, split by path\n");
+  fprintf(stderr, "  --partial FILE   also write the results to FILE for\n"
+                  "                   --merge\n");
+  fprintf(stderr, "  --merge PARTIAL...  print the report of the partial\n"
+                  "                   reports of every shard, with paths\n"
+                  "                   relative to the scanned directory\n");
+}
 
-  /* Step 1: Validate arguments */
-  if (argc < 2) {
-    fprintf(stderr, "Usage: %s <directory>\n", argv[0]);
-    return 1;
+/* Appends the findings a snapshot saved for one file */
+void replay_findings(const SnapFile *old, const char *path,
+                     FindingList *results) {
+  if (old->finding_count == 0)
+    return;
+  long file = findings_add_path(results, path);
+  if (file < 0 || findings_unpack(results, (uint32_t)file, old->findings,
+                                  old->findings_len,
+                                  old->finding_count) == -1)
+    fprintf(stderr, "Warning: Bad findings saved for %s\n", path);
+}
+
+/* Saves the findings this run made for one file in next, and status
+   (0 or the ContentKind it was skipped as)                             */
+void record_findings(Snapshot *next, const char *rel,
+                     const TargetFile *target, const FindingList *results,
+                     size_t first, int status) {
+  size_t len = 0;
+  char *packed = findings_pack(results, first, results->size - first, &len);
+  if (!packed)
+    return;
+  snapshot_add_file(next, rel, target, packed, len, results->size - first,
+                    (unsigned)status);
+  free(packed);
+}
+
+/* Lists a file the classifier rejected as "path (kind)" */
+void note_skipped(DynamicArray *skipped, const char *path, int status) {
+  char entry[4096];
+  snprintf(entry, sizeof(entry), "%s (%s)", path,
+           content_kind_name((ContentKind)status));
+  da_append(skipped, entry);
+}
+
+/* How scan_target_files() gets file contents and who parses them */
+typedef struct {
+  int read_ahead; /* Files read ahead of the parser (0 = read each one
+                     when it is parsed) */
+  int use_uring;  /* Read ahead through io_uring when the kernel has it */
+  int parsers;    /* Parser threads (1 = parse on the calling thread) */
+  ContentCache *cache; /* Results by file contents (--cache), or NULL */
+} ReadOptions;
+
+/* Reads and scans one file on this thread: from ra when reading
+   ahead, otherwise through the session's own buffer                */
+int scan_one_file(TargetFile *target, ReadAhead *ra, ScanSession *session,
+                  ContentCache *cache, FindingList *results) {
+  FileBuffer *buf = NULL;
+  if (target->size <= STREAM_THRESHOLD) {
+    if (ra)
+      read_ahead_next(ra, &buf);
+    else if (fb_map_file(target->path, target->size, session->buffer) == 0)
+      buf = session->buffer;
+    /* Not stat'ed by the walker: it may be too big to read whole */
+    if (!buf && target->size < 0)
+      stat_target_file(target);
   }
+  if (buf)
+    return cache_scan_file(cache, session, target->path, buf, results);
+  if (target->size > STREAM_THRESHOLD)
+    return scan_session_stream(session, target->path, results);
+  return -1;
+}
 
-  const char *base_dir = argv[1];
+/* Scans every listed file, or replays its findings from previous when
+   it is unchanged.  next (if any) records what this run found.  Files
+   the classifier rejects are listed in skipped as "path (kind)".      */
+void scan_target_files(FileList *files, size_t base_len,
+                       const Snapshot *previous, Snapshot *next,
+                       const ReadOptions *read, ScanSession *session,
+                       FindingList *results, DynamicArray *skipped) {
+  /* Step 1: Find the files the snapshot still covers; queue the rest */
+  const SnapFile **hits = calloc(files->size + 1, sizeof(SnapFile *));
+  TargetFile **queue = malloc((files->size + 1) * sizeof(TargetFile *));
+  if (!hits || !queue) {
+    fprintf(stderr, "Error: Out of memory\n");
+    free(hits);
+    free(queue);
+    return;
+  }
+  size_t queued = 0;
+  for (size_t i = 0; i < files->size; i++) {
+    TargetFile *target = &files->files[i];
+    if (next) {
+      if (target->mtime_ns == 0) /* Listed from the git index */
+        stat_target_file(target);
+      hits[i] = snapshot_find_file(previous, target->path + base_len + 1,
+                                   target);
+    }
+    if (!hits[i])
+      queue[queued++] = target;
+  }
 
-  /* Step 2: Create extension filter — scan .tsx, .jsx, .ts, .js */
-  ExtensionFilter *filter = ext_filter_create();
-  if (!filter) {
-    fprintf(stderr, "Error: Failed to create extension filter\n");
-    return 1;
+  /* Step 2: Scan the queued files on parser threads, or start reading
+     them ahead of the parser on this one                              */
+  ScanPipeline *pipeline = NULL;
+  ReadAhead *ra = NULL;
+  if (read->parsers > 1 && queued > 1)
+    pipeline = scan_pipeline_run(queue, queued, read->parsers,
+                                 read->read_ahead, read->use_uring, session,
+                                 read->cache);
+  if (!pipeline) {
+    /* Oversized files are streamed, never read whole */
+    size_t kept = 0;
+    for (size_t q = 0; q < queued; q++) {
+      if (queue[q]->size <= STREAM_THRESHOLD)
+        queue[kept++] = queue[q];
+    }
+    if (read->read_ahead > 0 && kept > 1)
+      ra = read_ahead_create((const TargetFile *const *)queue, kept,
+                             read->read_ahead, read->use_uring);
   }
-  ext_filter_add(filter, ".tsx");
-  ext_filter_add(filter, ".jsx");
-  ext_filter_add(filter, ".ts");
-  ext_filter_add(filter, ".js");
 
-  /* Step 3: Create scan configuration */
-  ScanConfig scan_cfg = {.base_path = base_dir,
-                         .filter = filter,
-                         .max_depth = -1,
-                         .follow_symlinks = 0};
+  /* Step 3: Go through the list in order so the findings are too */
+  size_t job = 0;
+  for (size_t i = 0; i < files->size; i++) {
+    TargetFile *target = &files->files[i];
+    const char *rel = target->path + base_len + 1;
+
+    /* Unchanged since the last run: replay its findings */
+    if (hits[i]) {
+      replay_findings(hits[i], target->path, results);
+      if (hits[i]->status > 0)
+        note_skipped(skipped, target->path, (int)hits[i]->status);
+      snapshot_copy_file(next, hits[i], target);
+      continue;
+    }
 
-  /* Step 4: Scan for target files */
-  DynamicArray *file_paths = da_create();
-  if (!file_paths) {
-    fprintf(stderr, "Error: Failed to create file paths array\n");
-    ext_filter_free(filter);
-    return 1;
+    size_t first = results->size;
+    int status = pipeline ? scan_pipeline_take(pipeline, job++, results)
+                          : scan_one_file(target, ra, session, read->cache,
+                                          results);
+    if (status == -1)
+      continue;
+    if (status > 0)
+      note_skipped(skipped, target->path, status);
+    if (next)
+      record_findings(next, rel, target, results, first, status);
   }
 
-  if (collect_target_files(&scan_cfg, file_paths) == -1) {
-    fprintf(stderr, "Error: Failed to scan directory\n");
-    da_free(file_paths);
-    ext_filter_free(filter);
-    return 1;
+  fb_unmap(session->buffer); /* Don't pin the last file until the next run */
+
+  read_ahead_free(ra);
+  scan_pipeline_free(pipeline);
+  free(hits);
+  free(queue);
+}
+
+/* Prints the findings grouped by file.  They arrive sorted by path,
+   then line and column, each file's findings in one run.          */
+void print_report(const FindingList *findings) {
+  if (findings->size == 0) {
+    printf("✓ All files are properly translated!\n");
+    return;
   }
+  printf("✗ Files with untranslated text:\n\n");
 
-  if (file_paths->size == 0) {
-    printf("No .tsx / .jsx / .ts / .js files found\n");
-    da_free(file_paths);
-    ext_filter_free(filter);
-    return 0;
+  long current_file = -1;
+  for (size_t i = 0; i < findings->size; i++) {
+    const Finding *f = &findings->items[i];
+
+    /* Print file header when we encounter a new file */
+    if ((long)f->file != current_file) {
+      printf("  \xE2\x96\xB8 %s\n", findings->paths->strings[f->file]);
+      current_file = (long)f->file;
+    }
+
+    char tag[80];
+    finding_tag(f, tag, sizeof(tag));
+    printf("      Line %-4u  [%-20s]  \"%.*s\"\n", (unsigned)f->line, tag,
+           (int)f->text_len, f->text);
   }
 
-  printf("Scanning %zu file(s)...\n\n", file_paths->size);
+  printf("\nTotal issues found: %zu\n", findings->size);
+}
 
-  /* Step 5: Process each file and collect issues */
-  DynamicArray *problematic_files = da_create();
-  if (!problematic_files) {
-    da_free(file_paths);
-    ext_filter_free(filter);
-    return 1;
+/* Lists the files that were never handed to the detectors */
+void print_skipped(const DynamicArray *skipped) {
+  if (skipped->size == 0)
+    return;
+  printf("\nSkipped %zu generated, minified or binary file(s):\n",
+         skipped->size);
+  for (size_t i = 0; i < skipped->size; i++)
+    printf("  \xE2\x96\xB8 %s\n", skipped->strings[i]);
+}
+
+/* Adds an inotify watch on every directory the last walk visited */
+void watch_directories(Watcher *watcher, const char *base_dir,
+                       const Snapshot *snap, const FileList *files) {
+  size_t base_len = strlen(base_dir);
+  char path[4096];
+  for (size_t i = 0; i < snap->dir_count; i++) {
+    const char *rel = snap->dirs[i].path;
+    if (rel[0] == '\0')
+      watcher_add_dir(watcher, base_dir);
+    else if (snprintf(path, sizeof(path), "%s/%s", base_dir, rel) <
+             (int)sizeof(path))
+      watcher_add_dir(watcher, path);
   }
 
-  for (size_t i = 0; i < file_paths->size; i++) {
-    FileBuffer *buf = fb_create(INITIAL_BUFFER_SIZE);
-    if (!buf)
+  /* --git-index never walks: watch the folders holding tracked files */
+  if (snap->dir_count > 0)
+    return;
+  watcher_add_dir(watcher, base_dir);
+  char last[4096] = "";
+  for (size_t i = 0; i < files->size; i++) {
+    const char *slash = strrchr(files->files[i].path, '/');
+    size_t len = slash ? (size_t)(slash - files->files[i].path) : 0;
+    if (len <= base_len || len >= sizeof(path))
       continue;
+    memcpy(path, files->files[i].path, len);
+    path[len] = '\0';
+    if (strcmp(path, last) != 0) {
+      watcher_add_dir(watcher, path);
+      strcpy(last, path);
+    }
+  }
+}
 
-    if (fb_read_file(file_paths->strings[i], buf) == -1) {
-      fb_free(buf);
-      continue;
+/* Re-stats the files inotify saw being rewritten, so the next scan
+   finds their stamps changed                                        */
+void restat_changed_files(FileList *files, const DynamicArray *changed) {
+  HashMap *by_path = hm_create(files->size);
+  if (!by_path)
+    return;
+  for (size_t i = 0; i < files->size; i++)
+    hm_put(by_path, files->files[i].path, i);
+  for (size_t i = 0; i < changed->size; i++) {
+    size_t idx;
+    if (hm_get(by_path, changed->strings[i], &idx))
+      stat_target_file(&files->files[idx]);
+  }
+  hm_free(by_path);
+}
+
+/* --watch: after the first scan, rescan whatever changes until the
+   process is interrupted.  Only rewritten files are parsed again; new,
+   deleted or renamed entries trigger an incremental walk that reuses
+   the listings of every unchanged directory.                          */
+int watch_tree(ScanConfig *config, FileList **files, Snapshot **current,
+               const char *snapshot_file, const ReadOptions *read,
+               ScanSession *session) {
+  Watcher *watcher = watcher_create();
+  if (!watcher)
+    return -1;
+  watch_directories(watcher, config->base_path, *current, *files);
+  size_t base_len = strlen(config->base_path);
+
+  for (;;) {
+    printf("\nWatching %zu director%s for changes (Ctrl+C to stop)...\n",
+           watcher_count(watcher), watcher_count(watcher) == 1 ? "y" : "ies");
+    fflush(stdout);
+
+    /* Step 1: Wait for a burst of changes */
+    DynamicArray *changed = da_create();
+    if (!changed)
+      break;
+    int structural = watcher_wait(watcher, changed);
+    if (structural == -1) {
+      da_free(changed);
+      break;
     }
 
-    ParserConfig *parser_cfg = parser_config_create();
-    if (parser_cfg) {
-      scan_file_for_untranslated(file_paths->strings[i], buf, parser_cfg,
-                                 problematic_files);
-      parser_config_free(parser_cfg);
+    /* Step 2: Bring the file list up to date */
+    Snapshot *fresh = snapshot_create((*current)->config_hash);
+    if (!fresh) {
+      da_free(changed);
+      break;
     }
+    if (structural) {
+      FileList *list = fl_create();
+      config->previous = *current;
+      config->next = fresh;
+      if (!list || collect_target_files(config, list) == -1) {
+        fl_free(list);
+        snapshot_free(fresh);
+        da_free(changed);
+        continue;
+      }
+      fl_free(*files);
+      *files = list;
+    } else {
+      restat_changed_files(*files, changed);
+    }
+    da_free(changed);
+
+    /* Step 3: Rescan changed files, replay the rest */
+    FindingList *results = findings_create();
+    DynamicArray *skipped = da_create();
+    if (!results || !skipped) {
+      findings_free(results);
+      da_free(skipped);
+      snapshot_free(fresh);
+      break;
+    }
+    scan_target_files(*files, base_len, *current, fresh, read, session,
+                      results, skipped);
+    snapshot_free(*current);
+    *current = fresh;
+    if (snapshot_file)
+      snapshot_save(fresh, snapshot_file);
+
+    /* Step 4: Redraw the report in place */
+    printf("\033[H\033[2J");
+    printf("Scanned %zu file(s)\n\n", (*files)->size);
+    print_report(results);
+    print_skipped(skipped);
+    findings_free(results);
+    da_free(skipped);
+
+    if (structural)
+      watch_directories(watcher, config->base_path, fresh, *files);
+  }
 
-    fb_free(buf);
+  watcher_free(watcher);
+  return -1;
+}
+
+/* Keeps the files of shard (from 0) of shard_count, in list order */
+void keep_shard(FileList *files, size_t base_len, int shard,
+                int shard_count) {
+  size_t kept = 0;
+  for (size_t i = 0; i < files->size; i++) {
+    const char *rel = files->files[i].path + base_len + 1;
+    if (report_shard_of(rel, shard_count) == shard)
+      files->files[kept++] = files->files[i];
   }
+  files->size = kept;
+}
 
-  /* Step 6: Print results grouped by file */
-  if (problematic_files->size == 0) {
-    printf("✓ All files are properly translated!\n");
-  } else {
-    printf("✗ Files with untranslated text:\n\n");
+/* --merge: prints the report of partial reports files[0, count) */
+int merge_partials(const char *const *files, size_t count) {
+  FindingList *findings = findings_create();
+  DynamicArray *skipped = da_create();
+  size_t scanned = 0;
+  int status = 1;
+  if (findings && skipped &&
+      report_merge(files, count, findings, skipped, &scanned) == 0) {
+    printf("Merged %zu partial report(s) of %zu file(s)\n\n", count,
+           scanned);
+    print_report(findings);
+    print_skipped(skipped);
+    status = 0;
+  }
+  findings_free(findings);
+  da_free(skipped);
+  return status;
+}
 
-    char current_file[512] = "";
+int main(int argc, char *argv[]) {
+  /* Display project banner */
+  display_banner();
 
-    for (size_t i = 0; i < problematic_files->size; i++) {
-      char *result = problematic_files->strings[i];
+  /* --merge takes partial reports, not a directory */
+  if (argc > 1 && strcmp(argv[1], "--merge") == 0) {
+    if (argc < 3) {
+      print_usage(argv[0]);
+      return 1;
+    }
+    return merge_partials((const char *const *)argv + 2, (size_t)argc - 2);
+  }
 
-      /*  Result format: "filepath:line:col: <TAG> text"
-          We anchor on the ": <" sequence to safely handle Windows paths
-          that contain a leading drive letter colon (C:\...).          */
-      char *tag_marker = strstr(result, ": <");
-      if (!tag_marker)
-        continue;
+  /* Step 1: Create the path filter with the built-in skips */
+  PathFilter *filter = path_filter_create();
+  if (!filter || path_filter_add_defaults(filter) == -1) {
+    fprintf(stderr, "Error: Failed to create path filter\n");
+    path_filter_free(filter);
+    return 1;
+  }
 
-      /* Walk backwards from tag_marker to find line and file separators */
-      char *last_colon = tag_marker - 1;
-      while (last_colon > result && *last_colon != ':')
-        last_colon--;
-      if (last_colon <= result)
-        continue;
+  /* Step 2: Parse options and the target directory */
+  const char *base_dir = NULL;
+  int num_threads = 0;
+  int include_count = 0;
+  int use_ignore_files = 1;
+  int use_git_index = 0;
+  const char *snapshot_file = NULL;
+  int watch = 0;
+  int follow_symlinks = 0;
+  int shard = 0, shard_count = 1;
+  const char *cache_dir = NULL;
+  long cache_mb = CACHE_DEFAULT_SIZE / (1024 * 1024);
+  const char *partial_file = NULL;
+  ReadOptions read = {
+      .read_ahead = DEFAULT_READ_AHEAD, .use_uring = 1, .parsers = 1};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+      if (num_threads < 1) {
+        fprintf(stderr, "Error: --threads expects a positive number\n");
+        path_filter_free(filter);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--include") == 0 && i + 1 < argc) {
+      path_filter_add(filter, RULE_INCLUDE, argv[++i]);
+      include_count++;
+    } else if (strcmp(argv[i], "--exclude") == 0 && i + 1 < argc) {
+      path_filter_add(filter, RULE_EXCLUDE, argv[++i]);
+    } else if (strcmp(argv[i], "--no-ignore") == 0) {
+      use_ignore_files = 0;
+    } else if (strcmp(argv[i], "--git-index") == 0) {
+      use_git_index = 1;
+    } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+      snapshot_file = argv[++i];
+    } else if (strcmp(argv[i], "--watch") == 0) {
+      watch = 1;
+    } else if (strcmp(argv[i], "--follow-symlinks") == 0) {
+      follow_symlinks = 1;
+    } else if (strcmp(argv[i], "--read-ahead") == 0 && i + 1 < argc) {
+      read.read_ahead = atoi(argv[++i]);
+      if (read.read_ahead < 0) {
+        fprintf(stderr, "Error: --read-ahead expects a number >= 0\n");
+        path_filter_free(filter);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--no-io-uring") == 0) {
+      read.use_uring = 0;
+    } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+      cache_dir = argv[++i];
+    } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+      cache_mb = atol(argv[++i]);
+      /* The cache is mapped whole, like any file read */
+      if (cache_mb < 1 || cache_mb > MAX_FILE_SIZE / (1024 * 1024)) {
+        fprintf(stderr, "Error: --cache-size expects 1 to %d (MB)\n",
+                MAX_FILE_SIZE / (1024 * 1024));
+        path_filter_free(filter);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+      char end;
+      if (sscanf(argv[++i], "%d/%d%c", &shard, &shard_count, &end) != 2 ||
+          shard_count < 1 || shard < 1 || shard > shard_count) {
+        fprintf(stderr, "Error: --shard expects K/N with 1 <= K <= N\n");
+        path_filter_free(filter);
+        return 1;
+      }
+      shard--;
+    } else if (strcmp(argv[i], "--partial") == 0 && i + 1 < argc) {
+      partial_file = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      print_usage(argv[0]);
+      path_filter_free(filter);
+      return 1;
+    } else {
+      base_dir = argv[i];
+    }
+  }
 
-      char *prev_colon = last_colon - 1;
-      while (prev_colon > result && *prev_colon != ':')
-        prev_colon--;
-      if (prev_colon <= result)
-        continue;
+  if (!base_dir) {
+    print_usage(argv[0]);
+    path_filter_free(filter);
+    return 1;
+  }
+  if (watch && (shard_count > 1 || partial_file)) {
+    fprintf(stderr, "Error: --watch cannot be sharded\n");
+    path_filter_free(filter);
+    return 1;
+  }
+  /* Watched files get truncated by editors mid-scan: never map them */
+  if (watch)
+    fb_allow_mmap(0);
+
+  /* Default to .tsx, .jsx, .ts, .js when no --include was given */
+  if ((include_count == 0 && path_filter_add_default_includes(filter) == -1) ||
+      path_filter_compile(filter) == -1) {
+    fprintf(stderr, "Error: Failed to compile path filter\n");
+    path_filter_free(filter);
+    return 1;
+  }
 
-      /* Filename: everything before prev_colon */
-      size_t filename_len = (size_t)(prev_colon - result);
-      char filename[512];
-      if (filename_len >= sizeof(filename))
-        continue;
-      strncpy(filename, result, filename_len);
-      filename[filename_len] = '\0';
+  /* Findings only depend on file contents and the parser, so the last
+     run's snapshot stays valid under other filter options.  Watch mode
+     keeps one in memory to know what changed.                         */
+  Snapshot *previous = NULL, *next = NULL;
+  if (snapshot_file || watch) {
+    uint32_t hash = hash_string(base_dir, hash_string(PARSER_VERSION, 0));
+    if (snapshot_file)
+      previous = snapshot_load(snapshot_file, hash);
+    next = snapshot_create(hash);
+    if (!next) {
+      fprintf(stderr, "Error: Failed to create snapshot\n");
+      snapshot_free(previous);
+      path_filter_free(filter);
+      return 1;
+    }
+  }
 
-      /* Line number: between prev_colon+1 and last_colon */
-      size_t ln_len = (size_t)(last_colon - prev_colon - 1);
-      char line_str[32];
-      if (ln_len >= sizeof(line_str))
-        continue;
-      strncpy(line_str, prev_colon + 1, ln_len);
-      line_str[ln_len] = '\0';
-      int line_num = atoi(line_str);
-
-      /* Tag: between '<' and '>' after the ": <" anchor */
-      char *lt = tag_marker + 2; /* points at '<' */
-      char *gt = strchr(lt, '>');
-      if (!gt)
-        continue;
+  /* Step 3: Create scan configuration */
+  read.parsers = num_threads > 0 ? num_threads : default_thread_count();
+  ScanConfig scan_cfg = {.base_path = base_dir,
+                         .filter = filter,
+                         .use_ignore_files = use_ignore_files,
+                         .use_git_index = use_git_index,
+                         .max_depth = -1,
+                         .follow_symlinks = follow_symlinks,
+                         .num_threads = num_threads,
+                         .previous = previous,
+                         .next = next,
+                         .want_sizes = read.parsers > 1};
 
-      char tag_display[64] = "";
-      size_t tlen = (size_t)(gt - lt - 1);
-      if (tlen > 0 && tlen < sizeof(tag_display)) {
-        strncpy(tag_display, lt + 1, tlen);
-        tag_display[tlen] = '\0';
-      }
+  /* Step 4: Scan for target files */
+  FileList *file_paths = fl_create();
+  if (!file_paths) {
+    fprintf(stderr, "Error: Failed to create file paths array\n");
+    snapshot_free(previous);
+    snapshot_free(next);
+    path_filter_free(filter);
+    return 1;
+  }
 
-      /* Text: after "> " */
-      char *text_start = gt + 2;
+  if (collect_target_files(&scan_cfg, file_paths) == -1) {
+    fprintf(stderr, "Error: Failed to scan directory\n");
+    fl_free(file_paths);
+    snapshot_free(previous);
+    snapshot_free(next);
+    path_filter_free(filter);
+    return 1;
+  }
 
-      /* Print file header when we encounter a new file */
-      if (strcmp(current_file, filename) != 0) {
-        printf("  \xE2\x96\xB8 %s\n", filename);
-        strncpy(current_file, filename, sizeof(current_file) - 1);
-        current_file[sizeof(current_file) - 1] = '\0';
-      }
+  /* Sharded: keep this shard's part of the (path-sorted) list */
+  if (shard_count > 1)
+    keep_shard(file_paths, strlen(base_dir), shard, shard_count);
 
-      printf("      Line %-4d  [%-20s]  \"%s\"\n", line_num, tag_display,
-             text_start);
-    }
+  if (file_paths->size == 0 && !watch && !partial_file) {
+    printf("No .tsx / .jsx / .ts / .js files found\n");
+    if (snapshot_file)
+      snapshot_save(next, snapshot_file);
+    fl_free(file_paths);
+    snapshot_free(previous);
+    snapshot_free(next);
+    path_filter_free(filter);
+    return 0;
+  }
+
+  printf("Scanning %zu file(s)...\n\n", file_paths->size);
 
-    printf("\nTotal issues found: %zu\n", problematic_files->size);
+  /* Step 5: Process each file and collect issues */
+  FindingList *problematic_files = findings_create();
+  DynamicArray *skipped_files = da_create();
+  ScanSession *session = scan_session_create();
+  int status = 0;
+  if (!problematic_files || !skipped_files || !session) {
+    findings_free(problematic_files);
+    da_free(skipped_files);
+    scan_session_free(session);
+    fl_free(file_paths);
+    snapshot_free(previous);
+    snapshot_free(next);
+    path_filter_free(filter);
+    return 1;
   }
 
-  /* Step 7: Cleanup */
-  da_free(file_paths);
-  da_free(problematic_files);
-  ext_filter_free(filter);
+  /* Files read whole are looked up by contents first.  The cache is
+     written back once this scan is done, so --watch rescans go
+     without it.                                                     */
+  if (cache_dir)
+    read.cache = cache_open(cache_dir, hash_string(PARSER_VERSION, 0),
+                            (size_t)cache_mb * 1024 * 1024);
+
+  /* Big files are also split over the threads, by top-level lines -
+     onto the threads that have nothing else to do, never more       */
+  int split_idle = read.parsers - 1;
+  session->config.split_threads = read.parsers;
+  session->config.split_idle = &split_idle;
+  scan_target_files(file_paths, strlen(base_dir), previous, next, &read,
+                    session, problematic_files, skipped_files);
+  cache_close(read.cache);
+  read.cache = NULL;
+  snapshot_free(previous);
+  if (snapshot_file)
+    snapshot_save(next, snapshot_file);
 
-  return 0;
+  /* Step 6: Print results grouped by file */
+  if (partial_file &&
+      report_save(partial_file, strlen(base_dir), shard + 1, shard_count,
+                  file_paths->size, problematic_files, skipped_files) == -1)
+    status = 1;
+  print_report(problematic_files);
+  print_skipped(skipped_files);
+  findings_free(problematic_files);
+  da_free(skipped_files);
+
+  /* Step 7: Keep rescanning until interrupted */
+  if (watch &&
+      watch_tree(&scan_cfg, &file_paths, &next, snapshot_file, &read,
+                 session) == -1)
+    status = 1;
+
+  /* Step 8: Cleanup */
+  scan_session_free(session);
+  fl_free(file_paths);
+  snapshot_free(next);
+  path_filter_free(filter);
+
+  return status;
 }
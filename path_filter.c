@@ -0,0 +1,628 @@
+#include "path_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_RULE_CAPACITY 16
+#define MAX_GLOB_LENGTH 1024
+#define FIXED_MASKS 7 /* start, loop, globstar, 2 accepts, 2 applicability */
+
+/* =====================================================================
+   RULES
+   ===================================================================== */
+
+/* Rule groups, compiled in this order so later groups win ties:
+   built-in defaults < ignore files found while walking < command line */
+enum { GROUP_DEFAULT, GROUP_IGNORE_FILE, GROUP_USER, GROUP_COUNT };
+
+#define RULE_DIR_ONLY 1  /* glob ended with '/'                        */
+#define RULE_FILE_ONLY 2 /* built-in file skips must not prune folders */
+
+typedef struct {
+  char *glob;    /* Final glob, relative to the scan root */
+  RuleKind kind; /* Include / exclude / negate */
+  int group;     /* GROUP_* */
+  int flags;     /* RULE_DIR_ONLY / RULE_FILE_ONLY */
+} FilterRule;
+
+/* One automaton position: a byte class plus how it repeats.
+   POS_STAR repeats (or is skipped); POS_GLOBSTAR is a '**' segment that
+   repeats over '/' too and, when entered, may skip its trailing '/'.   */
+enum { POS_ONE, POS_STAR, POS_GLOBSTAR };
+
+typedef struct {
+  int type;
+  uint8_t bytes[32]; /* Bitmap of accepted byte values */
+} GlobPos;
+
+struct PathFilter {
+  FilterRule *rules;
+  size_t rule_count;
+  size_t rule_capacity;
+
+  /* Compiled automaton (valid once compiled == 1) */
+  int compiled;
+  size_t words;             /* uint64_t words per state */
+  uint8_t byte_class[256];  /* Byte -> equivalence class */
+  size_t class_count;       /* Distinct classes */
+  uint64_t *class_masks;    /* Single block: fixed masks, then one row per
+                               class holding the positions accepting it */
+  uint64_t *start;          /* First position of every glob */
+  uint64_t *loop;           /* POS_STAR and POS_GLOBSTAR positions */
+  uint64_t *globstar;       /* POS_GLOBSTAR positions */
+  uint64_t *accept_include; /* Accept bits of include globs */
+  uint64_t *accept_exclude; /* Accept bits of exclude globs */
+  uint64_t *rules_for_file; /* Exclude/negate accept bits valid for files */
+  uint64_t *rules_for_dir;  /* Exclude/negate accept bits valid for dirs */
+  int has_includes;
+};
+
+PathFilter *path_filter_create(void) {
+  PathFilter *f = calloc(1, sizeof(PathFilter));
+  if (!f)
+    return NULL;
+
+  f->rules = malloc(INITIAL_RULE_CAPACITY * sizeof(FilterRule));
+  if (!f->rules) {
+    free(f);
+    return NULL;
+  }
+  f->rule_capacity = INITIAL_RULE_CAPACITY;
+  return f;
+}
+
+static void filter_drop_compiled(PathFilter *f) {
+  free(f->class_masks); /* All masks live in this one allocation */
+  f->class_masks = NULL;
+  f->compiled = 0;
+}
+
+void path_filter_free(PathFilter *filter) {
+  if (!filter)
+    return;
+  for (size_t i = 0; i < filter->rule_count; i++) {
+    free(filter->rules[i].glob);
+  }
+  free(filter->rules);
+  filter_drop_compiled(filter);
+  free(filter);
+}
+
+static int filter_push_rule(PathFilter *f, char *glob, RuleKind kind,
+                            int group, int flags) {
+  if (f->rule_count >= f->rule_capacity) {
+    size_t new_capacity = f->rule_capacity * 2;
+    FilterRule *new_rules =
+        realloc(f->rules, new_capacity * sizeof(FilterRule));
+    if (!new_rules)
+      return -1;
+    f->rules = new_rules;
+    f->rule_capacity = new_capacity;
+  }
+  FilterRule *r = &f->rules[f->rule_count++];
+  r->glob = glob;
+  r->kind = kind;
+  r->group = group;
+  r->flags = flags;
+  filter_drop_compiled(f);
+  return 0;
+}
+
+/* Turns one .gitignore-style line into a rule anchored at the scan
+   root.  dir_rel is the directory the line came from ("" = root).
+   Returns 1 if a rule was added, 0 for blank/comment lines.          */
+static int filter_add_line(PathFilter *f, RuleKind kind, int group,
+                           int flags, const char *dir_rel, const char *line,
+                           size_t len) {
+  /* Step 1: Trim line ending and unescaped trailing spaces */
+  while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n'))
+    len--;
+  while (len > 0 && line[len - 1] == ' ' && (len < 2 || line[len - 2] != '\\'))
+    len--;
+  if (len == 0 || line[0] == '#')
+    return 0;
+
+  /* Step 2: '!' turns an exclude into a negation */
+  if (kind == RULE_EXCLUDE && line[0] == '!') {
+    kind = RULE_NEGATE;
+    line++;
+    len--;
+  }
+
+  /* Step 3: Trailing '/' restricts the rule to directories */
+  if (len > 0 && line[len - 1] == '/') {
+    flags |= RULE_DIR_ONLY;
+    len--;
+  }
+
+  /* Step 4: A leading or inner '/' anchors the glob; otherwise it may
+     match at any depth, i.e. it behaves like "**\/glob"             */
+  int anchored = 0;
+  if (len > 0 && line[0] == '/') {
+    anchored = 1;
+    line++;
+    len--;
+  } else if (memchr(line, '/', len)) {
+    anchored = 1;
+  }
+  if (len == 0)
+    return 0;
+
+  /* Step 5: Build "<dir_rel>/" + ("**\/" if floating) + glob.  The
+     directory is a literal path: glob characters in its name (as in
+     "app/[locale]") are escaped.                                    */
+  size_t dir_len = 0;
+  for (const char *d = dir_rel; d && *d; d++)
+    dir_len += strchr("[]*?\\", *d) ? 2 : 1;
+  size_t total = dir_len + 1 + 3 + len + 1;
+  if (total > MAX_GLOB_LENGTH)
+    return 0;
+  char *glob = malloc(total);
+  if (!glob)
+    return -1;
+  size_t n = 0;
+  for (const char *d = dir_rel; d && *d; d++) {
+    if (strchr("[]*?\\", *d))
+      glob[n++] = '\\';
+    glob[n++] = *d;
+  }
+  if (n > 0)
+    glob[n++] = '/';
+  if (!anchored) {
+    memcpy(glob + n, "**/", 3);
+    n += 3;
+  }
+  memcpy(glob + n, line, len);
+  glob[n + len] = '\0';
+
+  if (filter_push_rule(f, glob, kind, group, flags) == -1) {
+    free(glob);
+    return -1;
+  }
+  return 1;
+}
+
+int path_filter_add(PathFilter *filter, RuleKind kind, const char *glob) {
+  if (!filter || !glob)
+    return -1;
+  if (filter_add_line(filter, kind, GROUP_USER, 0, "", glob, strlen(glob)) < 0)
+    return -1;
+  return 0;
+}
+
+int path_filter_add_defaults(PathFilter *filter) {
+  if (!filter)
+    return -1;
+
+  /* Directories to skip entirely (generated / vendor / cache) */
+  static const char *SKIP_DIRS[] = {"node_modules/", ".next/",  "dist/",
+                                    "build/",        ".git/",   ".cache/",
+                                    "coverage/",     "out/",    NULL};
+  /* Config, test and spec files never hold user-facing text */
+  static const char *SKIP_FILES[] = {"*.config.*", "*.test.*", "*.spec.*",
+                                     NULL};
+
+  for (int i = 0; SKIP_DIRS[i]; i++) {
+    if (filter_add_line(filter, RULE_EXCLUDE, GROUP_DEFAULT, 0, "",
+                        SKIP_DIRS[i], strlen(SKIP_DIRS[i])) < 0)
+      return -1;
+  }
+  for (int i = 0; SKIP_FILES[i]; i++) {
+    if (filter_add_line(filter, RULE_EXCLUDE, GROUP_DEFAULT, RULE_FILE_ONLY,
+                        "", SKIP_FILES[i], strlen(SKIP_FILES[i])) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+int path_filter_add_default_includes(PathFilter *filter) {
+  static const char *EXTENSIONS[] = {"*.tsx", "*.jsx", "*.ts", "*.js", NULL};
+  for (int i = 0; EXTENSIONS[i]; i++) {
+    if (path_filter_add(filter, RULE_INCLUDE, EXTENSIONS[i]) == -1)
+      return -1;
+  }
+  return 0;
+}
+
+PathFilter *path_filter_extend(const PathFilter *parent, const char *dir_rel,
+                               const char *text, size_t text_len) {
+  if (!parent || !text)
+    return NULL;
+
+  PathFilter *f = path_filter_create();
+  if (!f)
+    return NULL;
+
+  /* Step 1: Copy the parent's rules */
+  for (size_t i = 0; i < parent->rule_count; i++) {
+    const FilterRule *r = &parent->rules[i];
+    char *glob = malloc(strlen(r->glob) + 1);
+    if (!glob || filter_push_rule(f, glob, r->kind, r->group, r->flags) == -1) {
+      free(glob);
+      path_filter_free(f);
+      return NULL;
+    }
+    strcpy(glob, r->glob);
+  }
+
+  /* Step 2: Add one rule per ignore-file line */
+  int added = 0;
+  const char *p = text, *end = text + text_len;
+  while (p < end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+    int r = filter_add_line(f, RULE_EXCLUDE, GROUP_IGNORE_FILE, 0, dir_rel, p,
+                            len);
+    if (r < 0) {
+      path_filter_free(f);
+      return NULL;
+    }
+    added += r;
+    p += len + 1;
+  }
+
+  if (added == 0 || path_filter_compile(f) == -1) {
+    path_filter_free(f);
+    return NULL;
+  }
+  return f;
+}
+
+/* =====================================================================
+   GLOB -> POSITIONS
+   ===================================================================== */
+
+static void pos_set(GlobPos *p, unsigned char c) {
+  p->bytes[c >> 3] |= (uint8_t)(1u << (c & 7));
+}
+
+static void pos_set_all(GlobPos *p, int allow_slash) {
+  memset(p->bytes, 0xFF, sizeof(p->bytes));
+  if (!allow_slash)
+    p->bytes['/' >> 3] &= (uint8_t) ~(1u << ('/' & 7));
+}
+
+/* Parses a [...] class starting at g[*i] == '['.  Returns 0 if the
+   bracket is unterminated (it is then matched literally).           */
+static int parse_class(const char *g, size_t *i, GlobPos *pos) {
+  size_t j = *i + 1;
+  int negate = 0;
+  if (g[j] == '!' || g[j] == '^') {
+    negate = 1;
+    j++;
+  }
+  GlobPos tmp;
+  memset(&tmp, 0, sizeof(tmp));
+  int first = 1;
+  while (g[j] && (g[j] != ']' || first)) {
+    unsigned char lo = (unsigned char)g[j];
+    if (lo == '\\' && g[j + 1])
+      lo = (unsigned char)g[++j];
+    unsigned char hi = lo;
+    if (g[j + 1] == '-' && g[j + 2] && g[j + 2] != ']') {
+      hi = (unsigned char)g[j + 2];
+      j += 2;
+    }
+    for (unsigned c = lo; c <= hi; c++)
+      pos_set(&tmp, (unsigned char)c);
+    j++;
+    first = 0;
+  }
+  if (g[j] != ']')
+    return 0;
+
+  if (negate) {
+    for (size_t b = 0; b < sizeof(tmp.bytes); b++)
+      tmp.bytes[b] = (uint8_t)~tmp.bytes[b];
+  }
+  tmp.bytes['/' >> 3] &= (uint8_t) ~(1u << ('/' & 7)); /* never '/' */
+  tmp.type = POS_ONE;
+  *pos = tmp;
+  *i = j + 1;
+  return 1;
+}
+
+/* Splits a glob into positions.  out must hold strlen(g) entries. */
+static size_t parse_glob(const char *g, GlobPos *out) {
+  size_t n = 0, i = 0;
+  while (g[i]) {
+    GlobPos *p = &out[n];
+    memset(p, 0, sizeof(*p));
+
+    if (g[i] == '*') {
+      int whole_segment = g[i + 1] == '*' && (i == 0 || g[i - 1] == '/') &&
+                          (g[i + 2] == '/' || g[i + 2] == '\0');
+      if (whole_segment && g[i + 2] == '/') {
+        /* "**\/" - any run of segments, the '/' is part of the skip */
+        p->type = POS_GLOBSTAR;
+        pos_set_all(p, 1);
+        n++;
+        memset(&out[n], 0, sizeof(GlobPos));
+        pos_set(&out[n], '/');
+        n++;
+        i += 3;
+      } else if (whole_segment) {
+        /* Trailing "**" - everything below */
+        p->type = POS_STAR;
+        pos_set_all(p, 1);
+        n++;
+        i += 2;
+      } else {
+        p->type = POS_STAR;
+        pos_set_all(p, 0);
+        n++;
+        while (g[i] == '*')
+          i++;
+      }
+      continue;
+    }
+
+    if (g[i] == '?') {
+      pos_set_all(p, 0);
+      i++;
+    } else if (g[i] == '[' && parse_class(g, &i, p)) {
+      /* parse_class advanced i */
+    } else {
+      if (g[i] == '\\' && g[i + 1])
+        i++;
+      pos_set(p, (unsigned char)g[i]);
+      i++;
+    }
+    p->type = POS_ONE;
+    n++;
+  }
+  return n;
+}
+
+/* =====================================================================
+   COMPILATION
+   Every glob becomes a run of bits: one per position plus a final
+   accept bit.  A state bit j means "ready to match position j".
+   ===================================================================== */
+
+static void bit_set(uint64_t *words, size_t bit) {
+  words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+int path_filter_compile(PathFilter *filter) {
+  if (!filter)
+    return -1;
+  if (filter->compiled)
+    return 0;
+
+  /* Step 1: Parse every glob, in group order */
+  size_t total_pos = 0;
+  for (size_t i = 0; i < filter->rule_count; i++)
+    total_pos += strlen(filter->rules[i].glob) + 1;
+
+  GlobPos *all = malloc((total_pos + 1) * sizeof(GlobPos));
+  size_t *rule_off = malloc((filter->rule_count + 1) * sizeof(size_t));
+  size_t *rule_len = malloc((filter->rule_count + 1) * sizeof(size_t));
+  size_t *order = malloc((filter->rule_count + 1) * sizeof(size_t));
+  if (!all || !rule_off || !rule_len || !order) {
+    free(all);
+    free(rule_off);
+    free(rule_len);
+    free(order);
+    return -1;
+  }
+
+  size_t nrules = 0, bits = 0;
+  for (int group = 0; group < GROUP_COUNT; group++) {
+    for (size_t i = 0; i < filter->rule_count; i++) {
+      if (filter->rules[i].group != group)
+        continue;
+      order[nrules] = i;
+      rule_off[nrules] = bits;
+      rule_len[nrules] = parse_glob(filter->rules[i].glob, all + bits);
+      bits += rule_len[nrules] + 1; /* + accept bit */
+      nrules++;
+    }
+  }
+
+  /* Step 2: Allocate every mask in a single block: the fixed masks
+     first, then one row per byte value (deduplicated in step 4)    */
+  size_t words = bits / 64 + 1;
+  uint64_t *block = calloc((FIXED_MASKS + 256) * words, sizeof(uint64_t));
+  if (!block) {
+    free(all);
+    free(rule_off);
+    free(rule_len);
+    free(order);
+    return -1;
+  }
+  uint64_t *start = block;
+  uint64_t *loop = block + 1 * words;
+  uint64_t *globstar = block + 2 * words;
+  uint64_t *accept_include = block + 3 * words;
+  uint64_t *accept_exclude = block + 4 * words;
+  uint64_t *rules_for_file = block + 5 * words;
+  uint64_t *rules_for_dir = block + 6 * words;
+  uint64_t *rows = block + FIXED_MASKS * words;
+  int has_includes = 0;
+
+  /* Step 3: Fill masks position by position */
+  for (size_t r = 0; r < nrules; r++) {
+    const FilterRule *rule = &filter->rules[order[r]];
+    size_t off = rule_off[r], len = rule_len[r];
+    bit_set(start, off);
+
+    for (size_t k = 0; k < len; k++) {
+      const GlobPos *p = &all[off + k];
+      if (p->type != POS_ONE)
+        bit_set(loop, off + k);
+      if (p->type == POS_GLOBSTAR)
+        bit_set(globstar, off + k);
+      for (unsigned c = 0; c < 256; c++) {
+        if (p->bytes[c >> 3] & (1u << (c & 7)))
+          bit_set(rows + c * words, off + k);
+      }
+    }
+
+    size_t accept = off + len;
+    if (rule->kind == RULE_INCLUDE) {
+      bit_set(accept_include, accept);
+      has_includes = 1;
+      continue;
+    }
+    if (rule->kind == RULE_EXCLUDE)
+      bit_set(accept_exclude, accept);
+    if (!(rule->flags & RULE_DIR_ONLY))
+      bit_set(rules_for_file, accept);
+    if (!(rule->flags & RULE_FILE_ONLY))
+      bit_set(rules_for_dir, accept);
+  }
+
+  /* Step 4: Collapse identical byte rows into equivalence classes, so
+     the table stays small no matter how many globs there are         */
+  size_t classes = 0;
+  for (unsigned c = 0; c < 256; c++) {
+    const uint64_t *row = rows + c * words;
+    size_t k = 0;
+    while (k < classes &&
+           memcmp(rows + k * words, row, words * sizeof(uint64_t)) != 0)
+      k++;
+    if (k == classes) {
+      memmove(rows + k * words, row, words * sizeof(uint64_t));
+      classes++;
+    }
+    filter->byte_class[c] = (uint8_t)k;
+  }
+  uint64_t *shrunk =
+      realloc(block, (FIXED_MASKS + classes) * words * sizeof(uint64_t));
+  if (shrunk)
+    block = shrunk;
+
+  /* Step 5: Publish */
+  filter->words = words;
+  filter->class_count = classes;
+  filter->class_masks = block;
+  filter->start = block;
+  filter->loop = block + 1 * words;
+  filter->globstar = block + 2 * words;
+  filter->accept_include = block + 3 * words;
+  filter->accept_exclude = block + 4 * words;
+  filter->rules_for_file = block + 5 * words;
+  filter->rules_for_dir = block + 6 * words;
+  filter->has_includes = has_includes;
+  filter->compiled = 1;
+
+  free(all);
+  free(rule_off);
+  free(rule_len);
+  free(order);
+  return 0;
+}
+
+/* =====================================================================
+   MATCHING
+   ===================================================================== */
+
+size_t path_filter_state_words(const PathFilter *filter) {
+  return filter ? filter->words : 0;
+}
+
+/* Adds epsilon moves: a repeating position may be left at any time
+   (j -> j+1); a '**\/' position just entered may skip itself and its
+   '/' (j -> j+2).  entered holds the bits reached without looping.   */
+static void filter_closure(const PathFilter *f, uint64_t *state,
+                           uint64_t *entered) {
+  int changed;
+  do {
+    changed = 0;
+    uint64_t leave_carry = 0, skip_carry = 0;
+    for (size_t i = 0; i < f->words; i++) {
+      uint64_t lo = f->loop[i] & state[i];
+      uint64_t leave = (lo << 1) | leave_carry;
+      leave_carry = lo >> 63;
+
+      uint64_t ent = entered[i] | leave;
+      uint64_t gs = f->globstar[i] & ent;
+      ent |= (gs << 2) | skip_carry;
+      skip_carry = gs >> 62;
+
+      uint64_t st = state[i] | ent;
+      if (st != state[i] || ent != entered[i]) {
+        state[i] = st;
+        entered[i] = ent;
+        changed = 1;
+      }
+    }
+  } while (changed);
+}
+
+void path_filter_start(const PathFilter *filter, uint64_t *state) {
+  size_t words = filter->words;
+  uint64_t entered[words];
+  memcpy(state, filter->start, words * sizeof(uint64_t));
+  memcpy(entered, filter->start, words * sizeof(uint64_t));
+  filter_closure(filter, state, entered);
+}
+
+void path_filter_step(const PathFilter *filter, uint64_t *state,
+                      const char *text, size_t len) {
+  size_t words = filter->words;
+  const uint64_t *class_rows = filter->class_masks + FIXED_MASKS * words;
+  uint64_t entered[words];
+
+  for (size_t n = 0; n < len; n++) {
+    const uint64_t *m =
+        class_rows + filter->byte_class[(unsigned char)text[n]] * words;
+
+    /* Positions accepting this byte advance (entered) or repeat */
+    uint64_t carry = 0;
+    for (size_t i = 0; i < words; i++) {
+      uint64_t t = state[i] & m[i];
+      entered[i] = (t << 1) | carry;
+      carry = t >> 63;
+      state[i] = entered[i] | (t & filter->loop[i]);
+    }
+    filter_closure(filter, state, entered);
+  }
+}
+
+int path_filter_accepts(const PathFilter *filter, const uint64_t *state,
+                        int is_dir) {
+  const uint64_t *applicable =
+      is_dir ? filter->rules_for_dir : filter->rules_for_file;
+
+  /* Step 1: The highest matching exclude/negate bit is the last rule */
+  for (size_t i = filter->words; i-- > 0;) {
+    uint64_t hit = state[i] & applicable[i];
+    if (hit) {
+      int bit = 63 - __builtin_clzll(hit);
+      if ((filter->accept_exclude[i] >> bit) & 1)
+        return 0;
+      break; /* negated - fall through to the include check */
+    }
+  }
+
+  /* Step 2: Directories are walked unless excluded; files must also
+     match an include glob when any exist                              */
+  if (is_dir || !filter->has_includes)
+    return 1;
+  for (size_t i = 0; i < filter->words; i++) {
+    if (state[i] & filter->accept_include[i])
+      return 1;
+  }
+  return 0;
+}
+
+int path_filter_match_path(const PathFilter *filter, const char *rel_path,
+                           int is_dir) {
+  uint64_t state[filter->words];
+  path_filter_start(filter, state);
+
+  const char *seg = rel_path;
+  for (;;) {
+    const char *slash = strchr(seg, '/');
+    size_t len = slash ? (size_t)(slash - seg) : strlen(seg);
+    path_filter_step(filter, state, seg, len);
+    if (!slash)
+      return path_filter_accepts(filter, state, is_dir);
+    if (!path_filter_accepts(filter, state, 1))
+      return 0; /* A parent directory is excluded */
+    path_filter_step(filter, state, "/", 1);
+    seg = slash + 1;
+  }
+}
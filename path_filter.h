@@ -0,0 +1,70 @@
+#ifndef PATH_FILTER_H
+#define PATH_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* What a rule does when its glob matches */
+typedef enum {
+  RULE_INCLUDE, /* File must match at least one include (--include) */
+  RULE_EXCLUDE, /* Skip the path (--exclude, ignore files)          */
+  RULE_NEGATE   /* Re-include a previously excluded path ("!glob")  */
+} RuleKind;
+
+/* Include/exclude rules compiled into one automaton.
+   Globs use .gitignore syntax relative to the scan root:
+     *  ?  [a-z]  [!a-z]  match inside one path segment
+     **            as a whole segment, matches any number of segments
+     trailing /    only matches directories
+     leading /     or any inner / anchors the glob to its directory
+   Exclude/negate rules are ordered: the last matching one wins.
+
+   Matching is incremental.  A state (path_filter_state_words() words)
+   is the automaton after a path prefix; the walker keeps the state of
+   each directory and only feeds "name" (and "/" for subdirectories)
+   to get the state of an entry, so every path byte is consumed once.
+   A compiled filter is read-only and may be shared between threads.  */
+typedef struct PathFilter PathFilter;
+
+/* ── Building ───────────────────────────────────────────────────────── */
+PathFilter *path_filter_create(void);
+void        path_filter_free(PathFilter *filter);
+
+/* Adds one glob; RULE_EXCLUDE globs starting with '!' become negations */
+int path_filter_add(PathFilter *filter, RuleKind kind, const char *glob);
+
+/* Built-in excludes: build/vendor/cache directories and
+   *.config.* / *.test.* / *.spec.* files                            */
+int path_filter_add_defaults(PathFilter *filter);
+
+/* Default includes: *.tsx, *.jsx, *.ts, *.js                         */
+int path_filter_add_default_includes(PathFilter *filter);
+
+int path_filter_compile(PathFilter *filter);
+
+/* Returns a new compiled filter: parent's rules plus the lines of an
+   ignore file found in dir_rel ("" for the scan root).  Returns NULL
+   if the file holds no rules or on allocation failure.              */
+PathFilter *path_filter_extend(const PathFilter *parent, const char *dir_rel,
+                               const char *text, size_t text_len);
+
+/* ── Matching ───────────────────────────────────────────────────────── */
+size_t path_filter_state_words(const PathFilter *filter);
+
+/* Fills state with the automaton before any input (the scan root) */
+void path_filter_start(const PathFilter *filter, uint64_t *state);
+
+/* Feeds len bytes of path text to the automaton, updating state */
+void path_filter_step(const PathFilter *filter, uint64_t *state,
+                      const char *text, size_t len);
+
+/* Returns 1 if the path the state has consumed should be kept */
+int path_filter_accepts(const PathFilter *filter, const uint64_t *state,
+                        int is_dir);
+
+/* One-shot helper: runs a whole relative path ("src/app/page.tsx")
+   checking every parent directory along the way                      */
+int path_filter_match_path(const PathFilter *filter, const char *rel_path,
+                           int is_dir);
+
+#endif /* PATH_FILTER_H */
@@ -0,0 +1,567 @@
+#define _DEFAULT_SOURCE /* syscall() */
+#define _POSIX_C_SOURCE 200809L
+#include "read_ahead.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define INITIAL_READ_BUFFER 4096
+#define MAX_POOL_THREADS 16
+
+/* Life of one slot of the read-ahead window */
+enum { SLOT_IDLE, SLOT_QUEUED, SLOT_BUSY, SLOT_DONE, SLOT_FAILED };
+
+typedef struct {
+  FileBuffer *buf;
+  size_t pos;    /* Index in files */
+  int state;     /* SLOT_* */
+  int fd;        /* io_uring: the opened file */
+  size_t wanted; /* io_uring: length of the read in flight */
+} ReadSlot;
+
+typedef struct Uring Uring;
+
+struct ReadAhead {
+  const TargetFile *const *files;
+  size_t count;
+  ReadSlot *slots;
+  int depth;
+  size_t next_pos; /* Next file to give a slot */
+  size_t head;     /* Next file to hand to the caller */
+  size_t released; /* Files the caller is done with (their slots are free) */
+
+  Uring *ring; /* NULL = thread pool */
+
+  /* Thread pool */
+  pthread_t *threads;
+  int thread_count;
+  pthread_mutex_t lock;
+  pthread_cond_t work; /* A slot was queued (or stop was set) */
+  pthread_cond_t done; /* A slot finished */
+  int stop;
+};
+
+/* Gives free slots the next files of the list (caller holds lock).
+   Slot k always holds a file whose pos % depth == k.                */
+static void fill_slots(ReadAhead *ra) {
+  while (ra->next_pos < ra->count &&
+         ra->next_pos < ra->released + (size_t)ra->depth) {
+    ReadSlot *slot = &ra->slots[ra->next_pos % ra->depth];
+    slot->pos = ra->next_pos++;
+    slot->state = SLOT_QUEUED;
+    slot->buf->size = 0;
+  }
+}
+
+/* =====================================================================
+   IO_URING (raw syscalls - no liburing dependency)
+   ===================================================================== */
+
+/* Opcodes are enums; IORING_FEAT_FAST_POLL marks headers (5.7+) that
+   have OPENAT/READ/CLOSE and the probe interface                     */
+#if defined(__linux__) && defined(IORING_FEAT_FAST_POLL)
+
+enum { OP_OPEN, OP_READ, OP_CLOSE };
+
+struct Uring {
+  int fd;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_size, cq_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe *cqes;
+  unsigned to_submit; /* SQEs written but not yet submitted */
+};
+
+static int uring_enter(Uring *u, unsigned submit, unsigned wait) {
+  int r = (int)syscall(__NR_io_uring_enter, u->fd, submit, wait,
+                       wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+  if (r >= 0)
+    u->to_submit -= (unsigned)r < submit ? (unsigned)r : submit;
+  return r;
+}
+
+static void uring_destroy(Uring *u) {
+  if (!u)
+    return;
+  if (u->sqes)
+    munmap(u->sqes, u->sqes_size);
+  if (u->cq_ptr && u->cq_ptr != u->sq_ptr)
+    munmap(u->cq_ptr, u->cq_size);
+  if (u->sq_ptr)
+    munmap(u->sq_ptr, u->sq_size);
+  if (u->fd >= 0)
+    close(u->fd);
+  free(u);
+}
+
+/* Asks the kernel whether it knows every opcode we need */
+static int uring_supports_ops(int fd) {
+  size_t len = sizeof(struct io_uring_probe) +
+               256 * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe *probe = calloc(1, len);
+  if (!probe)
+    return 0;
+  int ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                   256) == 0;
+  static const int NEEDED[] = {IORING_OP_OPENAT, IORING_OP_READ,
+                               IORING_OP_CLOSE};
+  for (size_t i = 0; ok && i < sizeof(NEEDED) / sizeof(NEEDED[0]); i++) {
+    ok = NEEDED[i] <= probe->last_op &&
+         (probe->ops[NEEDED[i]].flags & IO_URING_OP_SUPPORTED);
+  }
+  free(probe);
+  return ok;
+}
+
+/* Sets up a ring; returns NULL if io_uring is missing or disabled */
+static Uring *uring_create(unsigned entries) {
+  Uring *u = calloc(1, sizeof(Uring));
+  if (!u)
+    return NULL;
+
+  /* Step 1: Create the ring */
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (u->fd < 0 || !uring_supports_ops(u->fd)) {
+    uring_destroy(u);
+    return NULL;
+  }
+
+  /* Step 2: Map the submission and completion rings */
+  u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (u->cq_size > u->sq_size)
+      u->sq_size = u->cq_size;
+    u->cq_size = u->sq_size;
+  }
+  u->sq_ptr = mmap(NULL, u->sq_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+  if (u->sq_ptr == MAP_FAILED) {
+    u->sq_ptr = NULL;
+    uring_destroy(u);
+    return NULL;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    u->cq_ptr = u->sq_ptr;
+  } else {
+    u->cq_ptr = mmap(NULL, u->cq_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    if (u->cq_ptr == MAP_FAILED) {
+      u->cq_ptr = NULL;
+      uring_destroy(u);
+      return NULL;
+    }
+  }
+
+  /* Step 3: Map the SQE array */
+  u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+  if (u->sqes == MAP_FAILED) {
+    u->sqes = NULL;
+    uring_destroy(u);
+    return NULL;
+  }
+
+  char *sq = u->sq_ptr, *cq = u->cq_ptr;
+  u->sq_head = (unsigned *)(sq + p.sq_off.head);
+  u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  u->sq_array = (unsigned *)(sq + p.sq_off.array);
+  u->cq_head = (unsigned *)(cq + p.cq_off.head);
+  u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  return u;
+}
+
+/* Returns a cleared SQE, submitting queued ones if the ring is full */
+static struct io_uring_sqe *uring_sqe(Uring *u) {
+  for (;;) {
+    unsigned head = __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *u->sq_tail;
+    if (tail - head <= *u->sq_mask) {
+      unsigned idx = tail & *u->sq_mask;
+      struct io_uring_sqe *sqe = &u->sqes[idx];
+      memset(sqe, 0, sizeof(*sqe));
+      u->sq_array[idx] = idx;
+      __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+      u->to_submit++;
+      return sqe;
+    }
+    if (uring_enter(u, u->to_submit, 0) < 0 && errno != EINTR)
+      return NULL;
+  }
+}
+
+static uint64_t slot_tag(const ReadAhead *ra, const ReadSlot *slot, int op) {
+  return ((uint64_t)(slot - ra->slots) << 2) | (uint64_t)op;
+}
+
+static void uring_open(ReadAhead *ra, ReadSlot *slot) {
+  struct io_uring_sqe *sqe = uring_sqe(ra->ring);
+  if (!sqe) {
+    slot->state = SLOT_FAILED;
+    return;
+  }
+  sqe->opcode = IORING_OP_OPENAT;
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (uint64_t)(uintptr_t)ra->files[slot->pos]->path;
+  sqe->open_flags = O_RDONLY | O_CLOEXEC;
+  sqe->user_data = slot_tag(ra, slot, OP_OPEN);
+  slot->state = SLOT_BUSY;
+}
+
+/* Reads into the rest of the buffer, growing it when it is full.  A
+   file that turns out to be over STREAM_THRESHOLD fails quietly, like
+   fb_read_file_sized(): the caller streams it instead.               */
+static void uring_read(ReadAhead *ra, ReadSlot *slot) {
+  FileBuffer *buf = slot->buf;
+  if (buf->size + 1 >= buf->capacity) {
+    if (buf->size > STREAM_THRESHOLD) {
+      slot->state = SLOT_FAILED;
+    } else if (fb_reserve(buf, buf->capacity * 2) == -1) {
+      slot->state = SLOT_FAILED;
+    }
+  }
+  struct io_uring_sqe *sqe =
+      slot->state == SLOT_FAILED ? NULL : uring_sqe(ra->ring);
+  if (!sqe) {
+    slot->state = SLOT_FAILED;
+    close(slot->fd);
+    return;
+  }
+  slot->wanted = buf->capacity - 1 - buf->size;
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = slot->fd;
+  sqe->addr = (uint64_t)(uintptr_t)(buf->content + buf->size);
+  sqe->len = (unsigned)slot->wanted;
+  sqe->off = buf->size;
+  sqe->user_data = slot_tag(ra, slot, OP_READ);
+}
+
+static void uring_finish(ReadAhead *ra, ReadSlot *slot) {
+  slot->buf->content[slot->buf->size] = '\0';
+  slot->state = SLOT_DONE;
+  struct io_uring_sqe *sqe = uring_sqe(ra->ring);
+  if (!sqe) {
+    close(slot->fd);
+    return;
+  }
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = slot->fd;
+  sqe->user_data = slot_tag(ra, slot, OP_CLOSE);
+}
+
+/* Advances one slot's open -> read... -> close chain */
+static void uring_complete(ReadAhead *ra, const struct io_uring_cqe *cqe) {
+  int op = (int)(cqe->user_data & 3);
+  if (op == OP_CLOSE)
+    return;
+  ReadSlot *slot = &ra->slots[cqe->user_data >> 2];
+  const TargetFile *file = ra->files[slot->pos];
+
+  if (cqe->res < 0) {
+    fprintf(stderr, "%s: %s\n", file->path, strerror(-cqe->res));
+    if (op == OP_READ)
+      close(slot->fd);
+    slot->state = SLOT_FAILED;
+    return;
+  }
+
+  if (op == OP_OPEN) {
+    /* Size the buffer from the walker's hint, with room past it so the
+       closing empty read needs no regrow (the file may have grown)    */
+    slot->fd = cqe->res;
+    size_t room = (size_t)file->size + INITIAL_READ_BUFFER;
+    if (file->size >= 0 && fb_reserve(slot->buf, room) == -1) {
+      close(slot->fd);
+      slot->state = SLOT_FAILED;
+      return;
+    }
+    uring_read(ra, slot);
+    return;
+  }
+
+  /* OP_READ: only a read that returns nothing is EOF.  The size hint
+     may be stale (a file edited since the walk or since git add), so
+     like the pread path we read on past it.                         */
+  slot->buf->size += (size_t)cqe->res;
+  int at_eof = cqe->res == 0;
+  if (at_eof && slot->buf->size > STREAM_THRESHOLD) {
+    close(slot->fd);
+    slot->state = SLOT_FAILED;
+  } else if (at_eof) {
+    uring_finish(ra, slot);
+  } else {
+    uring_read(ra, slot);
+  }
+}
+
+/* Handles every completion already posted, without waiting */
+static void uring_reap(ReadAhead *ra) {
+  Uring *u = ra->ring;
+  unsigned cq_head = *u->cq_head;
+  unsigned cq_tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+  while (cq_head != cq_tail) {
+    uring_complete(ra, &u->cqes[cq_head & *u->cq_mask]);
+    cq_head++;
+  }
+  __atomic_store_n(u->cq_head, cq_head, __ATOMIC_RELEASE);
+}
+
+/* Submits opens for queued slots and advances whatever has completed,
+   then waits only if the head slot is still unfinished.  Every call
+   submits and reaps, so the rest of the window keeps moving even when
+   the head was ready already.                                        */
+static void uring_wait_head(ReadAhead *ra) {
+  Uring *u = ra->ring;
+  for (int k = 0; k < ra->depth; k++) {
+    if (ra->slots[k].state == SLOT_QUEUED)
+      uring_open(ra, &ra->slots[k]);
+  }
+
+  /* Step 1: Send what is queued and take what is done - no waiting */
+  if (u->to_submit && uring_enter(u, u->to_submit, 0) < 0 && errno != EINTR)
+    perror("io_uring_enter");
+  uring_reap(ra);
+
+  /* Step 2: Block for the head only */
+  ReadSlot *head = &ra->slots[ra->head % ra->depth];
+  while (head->state == SLOT_BUSY) {
+    if (uring_enter(u, u->to_submit, 1) < 0 && errno != EINTR) {
+      perror("io_uring_enter");
+      head->state = SLOT_FAILED; /* Other slots are drained on free */
+      return;
+    }
+    uring_reap(ra);
+  }
+
+  /* Step 3: Reads and closes the completions just queued go out now,
+     not when the consumer next blocks                               */
+  if (u->to_submit)
+    uring_enter(u, u->to_submit, 0);
+}
+
+/* Waits for every operation still in flight so no read lands in a
+   freed buffer                                                      */
+static void uring_drain(ReadAhead *ra) {
+  Uring *u = ra->ring;
+  for (;;) {
+    int busy = 0;
+    for (int k = 0; k < ra->depth; k++)
+      busy |= ra->slots[k].state == SLOT_BUSY;
+    if (!busy)
+      break;
+    if (uring_enter(u, u->to_submit, 1) < 0 && errno != EINTR)
+      break;
+    unsigned cq_head = *u->cq_head;
+    unsigned cq_tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    while (cq_head != cq_tail) {
+      const struct io_uring_cqe *cqe = &u->cqes[cq_head & *u->cq_mask];
+      if ((cqe->user_data & 3) == OP_OPEN && cqe->res >= 0)
+        close(cqe->res);
+      else if ((cqe->user_data & 3) == OP_READ)
+        close(ra->slots[cqe->user_data >> 2].fd);
+      if ((cqe->user_data & 3) != OP_CLOSE)
+        ra->slots[cqe->user_data >> 2].state = SLOT_FAILED;
+      cq_head++;
+    }
+    __atomic_store_n(u->cq_head, cq_head, __ATOMIC_RELEASE);
+  }
+  /* Let queued closes run */
+  if (u->to_submit)
+    uring_enter(u, u->to_submit, 0);
+}
+
+#else /* no io_uring */
+
+static Uring *uring_create(unsigned entries) {
+  (void)entries;
+  return NULL;
+}
+static void uring_destroy(Uring *u) { (void)u; }
+static void uring_wait_head(ReadAhead *ra) { (void)ra; }
+static void uring_drain(ReadAhead *ra) { (void)ra; }
+
+#endif
+
+/* =====================================================================
+   PREAD THREAD POOL
+   ===================================================================== */
+
+static void *pool_worker_main(void *arg) {
+  ReadAhead *ra = arg;
+  pthread_mutex_lock(&ra->lock);
+  for (;;) {
+    /* Step 1: Take the queued slot nearest to the consumer */
+    ReadSlot *slot = NULL;
+    for (int k = 0; k < ra->depth; k++) {
+      ReadSlot *s = &ra->slots[k];
+      if (s->state == SLOT_QUEUED && (!slot || s->pos < slot->pos))
+        slot = s;
+    }
+    if (!slot) {
+      if (ra->stop)
+        break;
+      pthread_cond_wait(&ra->work, &ra->lock);
+      continue;
+    }
+    slot->state = SLOT_BUSY;
+    pthread_mutex_unlock(&ra->lock);
+
+    /* Step 2: Read it without holding the lock */
+    const TargetFile *file = ra->files[slot->pos];
+    int ok = fb_read_file_sized(file->path, file->size, slot->buf) == 0;
+
+    pthread_mutex_lock(&ra->lock);
+    slot->state = ok ? SLOT_DONE : SLOT_FAILED;
+    pthread_cond_broadcast(&ra->done);
+  }
+  pthread_mutex_unlock(&ra->lock);
+  return NULL;
+}
+
+/* =====================================================================
+   PUBLIC API
+   ===================================================================== */
+
+ReadAhead *read_ahead_create(const TargetFile *const *files, size_t count,
+                             int depth, int use_uring) {
+  if (!files || depth < 1)
+    return NULL;
+  ReadAhead *ra = calloc(1, sizeof(ReadAhead));
+  if (!ra)
+    return NULL;
+  ra->files = files;
+  ra->count = count;
+  ra->depth = depth;
+
+  /* Step 1: One reusable buffer per slot */
+  ra->slots = calloc((size_t)depth, sizeof(ReadSlot));
+  if (!ra->slots) {
+    free(ra);
+    return NULL;
+  }
+  for (int k = 0; k < depth; k++) {
+    ra->slots[k].buf = fb_create(INITIAL_READ_BUFFER);
+    ra->slots[k].fd = -1;
+    if (!ra->slots[k].buf) {
+      read_ahead_free(ra);
+      return NULL;
+    }
+  }
+  pthread_mutex_init(&ra->lock, NULL);
+  pthread_cond_init(&ra->work, NULL);
+  pthread_cond_init(&ra->done, NULL);
+
+  /* Step 2: io_uring when the kernel allows it, otherwise threads.
+     Each slot has at most one op in flight plus a pending close.    */
+  if (use_uring)
+    ra->ring = uring_create((unsigned)depth * 2);
+  if (!ra->ring) {
+    int want = depth < MAX_POOL_THREADS ? depth : MAX_POOL_THREADS;
+    ra->threads = calloc((size_t)want, sizeof(pthread_t));
+    for (; ra->threads && ra->thread_count < want; ra->thread_count++) {
+      if (pthread_create(&ra->threads[ra->thread_count], NULL,
+                         pool_worker_main, ra) != 0)
+        break;
+    }
+    if (ra->thread_count == 0) {
+      read_ahead_free(ra);
+      return NULL;
+    }
+  }
+
+  /* Step 3: Start reading the first window */
+  pthread_mutex_lock(&ra->lock);
+  fill_slots(ra);
+  pthread_cond_broadcast(&ra->work);
+  pthread_mutex_unlock(&ra->lock);
+  return ra;
+}
+
+int read_ahead_next(ReadAhead *ra, FileBuffer **buf) {
+  /* Step 1: The caller is done with the file handed out last time, so
+     its slot can take the next file of the window                    */
+  pthread_mutex_lock(&ra->lock);
+  ra->released = ra->head;
+  fill_slots(ra);
+  pthread_cond_broadcast(&ra->work);
+  pthread_mutex_unlock(&ra->lock);
+
+  if (ra->head >= ra->count)
+    return 0;
+
+  /* Step 2: Wait until the next file in list order is in memory */
+  ReadSlot *slot = &ra->slots[ra->head % ra->depth];
+
+  if (ra->ring) {
+    uring_wait_head(ra);
+  } else {
+    pthread_mutex_lock(&ra->lock);
+    while (slot->state == SLOT_QUEUED || slot->state == SLOT_BUSY)
+      pthread_cond_wait(&ra->done, &ra->lock);
+    pthread_mutex_unlock(&ra->lock);
+  }
+
+  *buf = slot->state == SLOT_DONE ? slot->buf : NULL;
+  ra->head++;
+  return 1;
+}
+
+int read_ahead_take(ReadAhead *ra, FileBuffer **buf, FileBuffer *spare) {
+  if (!read_ahead_next(ra, buf))
+    return 0;
+  /* The slot is only refilled by the next call, so nothing reads into
+     the buffer before it is swapped out                              */
+  if (*buf)
+    ra->slots[(ra->head - 1) % ra->depth].buf = spare;
+  return 1;
+}
+
+void read_ahead_free(ReadAhead *ra) {
+  if (!ra)
+    return;
+  if (ra->ring) {
+    uring_drain(ra);
+    uring_destroy(ra->ring);
+  }
+  if (ra->threads) {
+    pthread_mutex_lock(&ra->lock);
+    ra->stop = 1;
+    for (int k = 0; k < ra->depth; k++) {
+      if (ra->slots[k].state == SLOT_QUEUED)
+        ra->slots[k].state = SLOT_IDLE; /* Don't start new reads */
+    }
+    pthread_cond_broadcast(&ra->work);
+    pthread_mutex_unlock(&ra->lock);
+    for (int i = 0; i < ra->thread_count; i++)
+      pthread_join(ra->threads[i], NULL);
+    free(ra->threads);
+  }
+  if (ra->slots) {
+    for (int k = 0; k < ra->depth; k++)
+      fb_free(ra->slots[k].buf);
+    free(ra->slots);
+    pthread_cond_destroy(&ra->done);
+    pthread_cond_destroy(&ra->work);
+    pthread_mutex_destroy(&ra->lock);
+  }
+  free(ra);
+}
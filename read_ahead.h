@@ -0,0 +1,32 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include "data_structs.h"
+#include "file_reader.h"
+
+/* Reads files ahead of the parser.  Up to depth files are being opened
+   and read at any time - through io_uring on Linux, otherwise (or when
+   the kernel refuses it) by a small pool of pread() threads - while the
+   caller parses the ones already in memory.  Files are handed out in
+   list order so findings stay in the same order as a plain loop.      */
+typedef struct ReadAhead ReadAhead;
+
+/* files must stay valid until read_ahead_free().  use_uring = 0 forces
+   the thread pool.                                                    */
+ReadAhead *read_ahead_create(const TargetFile *const *files, size_t count,
+                             int depth, int use_uring);
+
+/* Waits for the next file.  Returns 0 once all files were handed out,
+   otherwise 1 with *buf set to its contents (NUL-terminated) or to NULL
+   if it could not be read.  The buffer is recycled by the next call.  */
+int read_ahead_next(ReadAhead *ra, FileBuffer **buf);
+
+/* Same, but the caller keeps the buffer: spare (an empty, unmapped
+   buffer) takes its place in the window and the returned one is the
+   caller's to free.  On a failed read *buf is NULL and spare is not
+   used.                                                               */
+int read_ahead_take(ReadAhead *ra, FileBuffer **buf, FileBuffer *spare);
+
+void read_ahead_free(ReadAhead *ra);
+
+#endif /* READ_AHEAD_H */
@@ -0,0 +1,287 @@
+#include "report.h"
+#include "binary_io.h"
+#include "file_reader.h"
+#include "text_parser.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORT_MAGIC "NOINTLPR"
+#define REPORT_FORMAT 2
+
+int report_shard_of(const char *rel, int shard_count) {
+  return (int)(hash_string(rel, 0) % (uint32_t)shard_count);
+}
+
+/* =====================================================================
+   PARTIAL REPORT FORMAT
+   "NOINTLPR" u32 format u32 parser_hash u32 shard u32 shard_count
+   u64 scanned u64 files u64 skipped, then
+   file:    u32 path_len path NUL u64 count u64 findings_len findings
+   skipped: u32 entry_len entry NUL
+   Files are in path order and only those with findings are listed.
+   Paths (also those in skipped entries) are relative to the scan root,
+   so partials of jobs that checked out to different places still
+   merge into the same report.  Paths and entries keep their NUL so a
+   mapped partial can be used in place.  Host byte order, like the
+   snapshot: the shards of one run are expected to run on the same
+   kind of machine.
+   ===================================================================== */
+
+static int write_string(FILE *out, const char *str) {
+  size_t len = strlen(str);
+  return bin_write_u32(out, (uint32_t)len) | bin_write_bytes(out, str, len + 1);
+}
+
+int report_save(const char *file, size_t root_len, int shard,
+                int shard_count, size_t scanned, const FindingList *findings,
+                const DynamicArray *skipped) {
+  if (!file || !findings || !skipped)
+    return -1;
+  FILE *out = fopen(file, "wb");
+  if (!out) {
+    perror("fopen");
+    return -1;
+  }
+
+  /* Step 1: Header - count the runs of findings, one per file */
+  uint64_t runs = 0;
+  for (size_t i = 0; i < findings->size; i++) {
+    if (i == 0 || findings->items[i].file != findings->items[i - 1].file)
+      runs++;
+  }
+  int err = bin_write_bytes(out, REPORT_MAGIC, 8);
+  err |= bin_write_u32(out, REPORT_FORMAT);
+  err |= bin_write_u32(out, hash_string(PARSER_VERSION, 0));
+  err |= bin_write_u32(out, (uint32_t)shard);
+  err |= bin_write_u32(out, (uint32_t)shard_count);
+  err |= bin_write_u64(out, scanned);
+  err |= bin_write_u64(out, runs);
+  err |= bin_write_u64(out, skipped->size);
+
+  /* Step 2: One record per run of findings */
+  for (size_t first = 0; first < findings->size && !err;) {
+    size_t end = first + 1;
+    while (end < findings->size &&
+           findings->items[end].file == findings->items[first].file)
+      end++;
+    size_t len = 0;
+    char *packed = findings_pack(findings, first, end - first, &len);
+    if (!packed) {
+      err = -1;
+      break;
+    }
+    uint32_t file_index = findings->items[first].file;
+    err |= write_string(out, findings->paths->strings[file_index] +
+                                 root_len + 1);
+    err |= bin_write_u64(out, end - first);
+    err |= bin_write_u64(out, len);
+    err |= bin_write_bytes(out, packed, len);
+    free(packed);
+    first = end;
+  }
+
+  /* Step 3: The skipped files */
+  for (size_t i = 0; i < skipped->size && !err; i++)
+    err |= write_string(out, skipped->strings[i] + root_len + 1);
+
+  if (fclose(out) != 0)
+    err = -1;
+  if (err) {
+    fprintf(stderr, "Error: Failed to write partial report %s\n", file);
+    remove(file);
+    return -1;
+  }
+  return 0;
+}
+
+/* =====================================================================
+   MERGING
+   Every partial lists its files in path order, so the partials are
+   combined with a k-way merge: a heap of one cursor per partial, keyed
+   by the record each one is at.  File records sort before skipped
+   entries, so the findings all come out first.
+   ===================================================================== */
+
+/* A partial and the record it is at */
+typedef struct {
+  FileBuffer *buf;
+  BinReader in;
+  uint64_t files_left;
+  uint64_t skipped_left;
+
+  /* Current record: key is NULL once the partial is used up */
+  int in_skipped;     /* 0 = file record, 1 = skipped entry */
+  const char *key;    /* Path or skipped entry */
+  uint64_t count;     /* File record: findings */
+  const char *packed; /* ...packed */
+  uint64_t packed_len;
+} PartialCursor;
+
+/* Moves c to its next record */
+static void cursor_next(PartialCursor *c) {
+  c->key = NULL;
+  if (c->in.failed)
+    return;
+  if (c->files_left > 0) {
+    c->files_left--;
+    c->in_skipped = 0;
+    c->key = bin_read_span(&c->in, bin_read_u32(&c->in), 1);
+    c->count = bin_read_u64(&c->in);
+    c->packed_len = bin_read_u64(&c->in);
+    c->packed = bin_read_span(&c->in, c->packed_len, 0);
+  } else if (c->skipped_left > 0) {
+    c->skipped_left--;
+    c->in_skipped = 1;
+    c->key = bin_read_span(&c->in, bin_read_u32(&c->in), 1);
+  }
+  if (c->in.failed)
+    c->key = NULL;
+}
+
+/* Maps file and checks its header.  Returns -1 after saying why not. */
+static int cursor_open(PartialCursor *c, const char *file, int *shard,
+                       int *shard_count, size_t *scanned) {
+  c->buf = fb_create(INITIAL_BUFFER_SIZE);
+  if (!c->buf || fb_map_whole(file, c->buf) == -1) {
+    fprintf(stderr, "Error: Cannot read partial report %s\n", file);
+    return -1;
+  }
+  c->in.p = (const unsigned char *)c->buf->content;
+  c->in.end = c->in.p + c->buf->size;
+  if (c->buf->size < 8 || memcmp(c->in.p, REPORT_MAGIC, 8) != 0) {
+    fprintf(stderr, "Error: %s is not a partial report\n", file);
+    return -1;
+  }
+  c->in.p += 8;
+  uint32_t format = bin_read_u32(&c->in);
+  uint32_t parser = bin_read_u32(&c->in);
+  *shard = (int)bin_read_u32(&c->in);
+  *shard_count = (int)bin_read_u32(&c->in);
+  *scanned = (size_t)bin_read_u64(&c->in);
+  c->files_left = bin_read_u64(&c->in);
+  c->skipped_left = bin_read_u64(&c->in);
+  if (c->in.failed || format != REPORT_FORMAT || *shard_count < 1 ||
+      *shard < 1 || *shard > *shard_count) {
+    fprintf(stderr, "Error: Corrupt partial report %s\n", file);
+    return -1;
+  }
+  if (parser != hash_string(PARSER_VERSION, 0)) {
+    fprintf(stderr, "Error: %s was written by another parser version\n",
+            file);
+    return -1;
+  }
+  cursor_next(c);
+  return 0;
+}
+
+static int cursor_less(const PartialCursor *a, const PartialCursor *b) {
+  if (a->in_skipped != b->in_skipped)
+    return a->in_skipped < b->in_skipped;
+  return strcmp(a->key, b->key) < 0;
+}
+
+static void cursor_heap_down(PartialCursor **heap, size_t size, size_t i) {
+  for (;;) {
+    size_t least = i;
+    for (size_t c = 2 * i + 1; c <= 2 * i + 2 && c < size; c++) {
+      if (cursor_less(heap[c], heap[least]))
+        least = c;
+    }
+    if (least == i)
+      return;
+    PartialCursor *tmp = heap[i];
+    heap[i] = heap[least];
+    heap[least] = tmp;
+    i = least;
+  }
+}
+
+int report_merge(const char *const *files, size_t count,
+                 FindingList *findings, DynamicArray *skipped,
+                 size_t *scanned) {
+  if (!files || count == 0 || !findings || !skipped || !scanned)
+    return -1;
+  PartialCursor *cursors = calloc(count, sizeof(PartialCursor));
+  PartialCursor **heap = malloc(count * sizeof(PartialCursor *));
+  unsigned char *seen = NULL;
+  int status = cursors && heap ? 0 : -1;
+
+  /* Step 1: Open every partial; they must be shards of one split */
+  int expected = 0;
+  for (size_t i = 0; i < count && status == 0; i++) {
+    int shard, shard_count;
+    size_t files_scanned;
+    if (cursor_open(&cursors[i], files[i], &shard, &shard_count,
+                    &files_scanned) == -1) {
+      status = -1;
+      break;
+    }
+    if (i == 0) {
+      expected = shard_count;
+      seen = calloc((size_t)shard_count, 1);
+      if (!seen) {
+        status = -1;
+        break;
+      }
+    }
+    if (shard_count != expected) {
+      fprintf(stderr, "Error: %s is shard %d/%d, expected one of %d\n",
+              files[i], shard, shard_count, expected);
+      status = -1;
+    } else if (seen[shard - 1]) {
+      fprintf(stderr, "Error: Shard %d/%d given twice (%s)\n", shard,
+              shard_count, files[i]);
+      status = -1;
+    } else {
+      seen[shard - 1] = 1;
+      *scanned += files_scanned;
+    }
+  }
+  if (status == 0 && count < (size_t)expected)
+    fprintf(stderr, "Warning: %zu of %d shards missing - the report is "
+                    "incomplete\n",
+            (size_t)expected - count, expected);
+
+  /* Step 2: Take the smallest record until every partial is drained */
+  size_t live = 0;
+  for (size_t i = 0; i < count && status == 0; i++) {
+    if (cursors[i].key)
+      heap[live++] = &cursors[i];
+  }
+  for (size_t i = live / 2; i-- > 0;)
+    cursor_heap_down(heap, live, i);
+  while (live > 0 && status == 0) {
+    PartialCursor *c = heap[0];
+    if (c->in_skipped) {
+      status = da_append(skipped, c->key);
+    } else {
+      long file = findings_add_path(findings, c->key);
+      if (file < 0)
+        status = -1;
+      else if (findings_unpack(findings, (uint32_t)file, c->packed,
+                               (size_t)c->packed_len,
+                               (size_t)c->count) == -1)
+        c->in.failed = 1; /* Reported below */
+    }
+    cursor_next(c);
+    if (!c->key)
+      heap[0] = heap[--live];
+    cursor_heap_down(heap, live, 0);
+  }
+
+  for (size_t i = 0; i < count && status == 0; i++) {
+    if (cursors[i].in.failed) {
+      fprintf(stderr, "Error: Corrupt partial report %s\n", files[i]);
+      status = -1;
+    }
+  }
+
+  for (size_t i = 0; cursors && i < count; i++)
+    fb_free(cursors[i].buf);
+  free(cursors);
+  free(heap);
+  free(seen);
+  return status;
+}
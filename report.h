@@ -0,0 +1,34 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "data_structs.h"
+#include "findings.h"
+
+/* Partial reports of a sharded run.  Each shard (--shard K/N) scans the
+   files whose path hashes to it and writes what it found with
+   --partial FILE; --merge reads the partials back into one report, the
+   same one an unsharded run prints.                                   */
+
+/* Which files a shard takes: hash of the path relative to the scan
+   root, so every shard picks the same split wherever it is checked out */
+int report_shard_of(const char *rel, int shard_count);
+
+/* Writes findings (in path order, one run per file) and skipped to
+   file, their paths without the first root_len + 1 bytes (the scan
+   root and its '/').  scanned is the number of files this shard
+   looked at.                                                        */
+int report_save(const char *file, size_t root_len, int shard,
+                int shard_count, size_t scanned, const FindingList *findings,
+                const DynamicArray *skipped);
+
+/* Merges the partial reports files[0, count) into findings and
+   skipped, in path order and with the paths relative to the scan
+   root, as they were saved, and adds the files they scanned to
+   *scanned.  Fails on an unreadable or corrupt partial, one from
+   another parser version or a shard given twice; warns about missing
+   shards.                                                            */
+int report_merge(const char *const *files, size_t count,
+                 FindingList *findings, DynamicArray *skipped,
+                 size_t *scanned);
+
+#endif /* REPORT_H */
@@ -0,0 +1,351 @@
+#define _POSIX_C_SOURCE 200809L
+#include "scan_pipeline.h"
+#include "directory.h"
+#include "file_reader.h"
+#include "read_ahead.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFERS_PER_PARSER 2 /* One being parsed, one waiting for it */
+#define SPIN_TRIES 64        /* Busy retries before yielding the CPU */
+#define YIELD_TRIES 256      /* ...and yields before sleeping        */
+#define IDLE_SLEEP_NS 50000  /* Nap of a stage waiting on the other  */
+#define CACHE_LINE 64
+
+/* =====================================================================
+   BOUNDED MPMC RING
+   A fixed array of cells, each with a sequence number that says whose
+   turn it is: producers claim a cell by advancing tail, consumers by
+   advancing head, and neither ever takes a lock.
+   ===================================================================== */
+
+typedef struct {
+  size_t seq; /* == position: free to push, == position + 1: full */
+  void *value;
+} RingCell;
+
+typedef struct {
+  RingCell *cells;
+  size_t mask; /* Cells - 1, a power of two */
+  char pad_head[CACHE_LINE];
+  size_t head; /* Next position to pop */
+  char pad_tail[CACHE_LINE];
+  size_t tail; /* Next position to push */
+  char pad_end[CACHE_LINE];
+} Ring;
+
+static int ring_init(Ring *ring, size_t min_capacity) {
+  size_t capacity = 2;
+  while (capacity < min_capacity)
+    capacity *= 2;
+  ring->cells = malloc(capacity * sizeof(RingCell));
+  if (!ring->cells)
+    return -1;
+  for (size_t i = 0; i < capacity; i++)
+    ring->cells[i].seq = i;
+  ring->mask = capacity - 1;
+  ring->head = 0;
+  ring->tail = 0;
+  return 0;
+}
+
+static int ring_try_push(Ring *ring, void *value) {
+  size_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  for (;;) {
+    RingCell *cell = &ring->cells[pos & ring->mask];
+    size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        cell->value = value;
+        __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+    } else if (diff < 0) {
+      return 0; /* Full */
+    } else {
+      pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+static int ring_try_pop(Ring *ring, void **value) {
+  size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  for (;;) {
+    RingCell *cell = &ring->cells[pos & ring->mask];
+    size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        *value = cell->value;
+        __atomic_store_n(&cell->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+    } else if (diff < 0) {
+      return 0; /* Empty */
+    } else {
+      pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/* Waits a little longer each time a stage finds its ring full/empty */
+static void back_off(unsigned *tries) {
+  if (++*tries < SPIN_TRIES)
+    return;
+  if (*tries < SPIN_TRIES + YIELD_TRIES) {
+    sched_yield();
+    return;
+  }
+  struct timespec nap = {0, IDLE_SLEEP_NS};
+  nanosleep(&nap, NULL);
+}
+
+static void ring_push(Ring *ring, void *value) {
+  unsigned tries = 0;
+  while (!ring_try_push(ring, value))
+    back_off(&tries);
+}
+
+static void *ring_pop(Ring *ring) {
+  void *value;
+  unsigned tries = 0;
+  while (!ring_try_pop(ring, &value))
+    back_off(&tries);
+  return value;
+}
+
+/* =====================================================================
+   PIPELINE
+   ===================================================================== */
+
+/* One file and, once a parser is done with it, what it came to */
+typedef struct {
+  TargetFile *file;
+  FileBuffer *buf; /* Contents, NULL = stream it (or unreadable) */
+  int status;      /* scan_session_*() result */
+  int worker;      /* Parser whose FindingList holds the findings */
+  size_t first;    /* ...from this index */
+  size_t count;
+} ScanJob;
+
+typedef struct {
+  ScanPipeline *pipeline;
+  ScanSession *session;
+  int owns_session;
+  FindingList *results;
+  pthread_t thread;
+} ParserWorker;
+
+struct ScanPipeline {
+  ScanJob *jobs;
+  size_t count;
+  Ring ready; /* ScanJob *, reader -> parsers; NULL = no more files */
+  Ring spare; /* Empty FileBuffer *, parsers -> reader */
+  size_t buffer_count;
+  ParserWorker *workers;
+  int worker_count;
+  ContentCache *cache; /* Results of earlier runs, or NULL */
+  int idle;            /* Threads out of files: parsers split onto them */
+};
+
+static void *parser_main(void *arg) {
+  ParserWorker *w = arg;
+  ScanPipeline *p = w->pipeline;
+  ScanJob *job;
+  while ((job = ring_pop(&p->ready))) {
+    size_t first = w->results->size;
+    int status = -1;
+    if (job->buf) {
+      status = cache_scan_file(p->cache, w->session, job->file->path,
+                               job->buf, w->results);
+      fb_unmap(job->buf);
+      ring_push(&p->spare, job->buf);
+    } else if (job->file->size > STREAM_THRESHOLD) {
+      status = scan_session_stream(w->session, job->file->path, w->results);
+    }
+    job->status = status;
+    job->worker = (int)(w - p->workers);
+    job->first = first;
+    job->count = w->results->size - first;
+  }
+  /* Out of files: a parser still on a big one may lex on this thread */
+  __atomic_add_fetch(&p->idle, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/* Biggest files first, so the longest scans start before the short
+   ones rather than last; ties keep list order                       */
+static int compare_largest_first(const void *a, const void *b) {
+  const ScanJob *x = *(const ScanJob *const *)a;
+  const ScanJob *y = *(const ScanJob *const *)b;
+  if (x->file->size != y->file->size)
+    return x->file->size > y->file->size ? -1 : 1;
+  return x < y ? -1 : (x > y);
+}
+
+/* The reader stage, on the calling thread: streamed files go straight
+   to the parsers, the rest are read into spare buffers first         */
+static void run_reader(ScanPipeline *p, int read_ahead, int use_uring) {
+  /* Step 1: Order the files, the streamed ones (the biggest) first */
+  ScanJob **order = malloc(p->count * sizeof(ScanJob *));
+  const TargetFile **reads = malloc(p->count * sizeof(TargetFile *));
+  size_t read_count = 0;
+  if (order && reads) {
+    for (size_t i = 0; i < p->count; i++)
+      order[i] = &p->jobs[i];
+    qsort(order, p->count, sizeof(ScanJob *), compare_largest_first);
+    for (size_t i = 0; i < p->count; i++) {
+      if (order[i]->file->size > STREAM_THRESHOLD)
+        ring_push(&p->ready, order[i]);
+      else
+        reads[read_count++] = order[i]->file;
+    }
+  } else {
+    fprintf(stderr, "Error: Out of memory\n");
+  }
+
+  /* Step 2: Read the rest in the same order, ahead of the parsers */
+  ReadAhead *ra = NULL;
+  if (read_ahead > 0 && read_count > 1)
+    ra = read_ahead_create(reads, read_count, read_ahead, use_uring);
+  for (size_t i = 0; order && reads && i < p->count; i++) {
+    ScanJob *job = order[i];
+    if (job->file->size > STREAM_THRESHOLD)
+      continue;
+    FileBuffer *spare = ring_pop(&p->spare);
+    FileBuffer *buf = NULL;
+    if (ra)
+      read_ahead_take(ra, &buf, spare);
+    else if (fb_map_file(job->file->path, job->file->size, spare) == 0)
+      buf = spare;
+    if (!buf) {
+      ring_push(&p->spare, spare);
+      /* Not stat'ed by the walker: it may be too big to read whole */
+      if (job->file->size < 0)
+        stat_target_file(job->file);
+    }
+    job->buf = buf;
+    ring_push(&p->ready, job);
+  }
+  read_ahead_free(ra);
+  free(order);
+  free(reads);
+
+  /* Step 3: One end marker per parser; the reader is idle from now */
+  for (int i = 0; i < p->worker_count; i++)
+    ring_push(&p->ready, NULL);
+  __atomic_add_fetch(&p->idle, 1, __ATOMIC_RELEASE);
+}
+
+ScanPipeline *scan_pipeline_run(TargetFile *const *files, size_t count,
+                                int parsers, int read_ahead, int use_uring,
+                                ScanSession *session, ContentCache *cache) {
+  if (!files || parsers < 1)
+    return NULL;
+  ScanPipeline *p = calloc(1, sizeof(ScanPipeline));
+  if (!p)
+    return NULL;
+
+  /* Step 1: Jobs, rings and the buffers that go round between stages */
+  p->count = count;
+  p->cache = cache;
+  p->buffer_count = (size_t)parsers * BUFFERS_PER_PARSER;
+  p->jobs = calloc(count + 1, sizeof(ScanJob));
+  p->workers = calloc((size_t)parsers, sizeof(ParserWorker));
+  if (!p->jobs || !p->workers || ring_init(&p->ready, p->buffer_count) == -1 ||
+      ring_init(&p->spare, p->buffer_count) == -1) {
+    scan_pipeline_free(p);
+    return NULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    p->jobs[i].file = files[i];
+    p->jobs[i].status = -1;
+  }
+  for (size_t i = 0; i < p->buffer_count; i++) {
+    FileBuffer *buf = fb_create(INITIAL_BUFFER_SIZE);
+    if (!buf) {
+      scan_pipeline_free(p);
+      return NULL;
+    }
+    ring_push(&p->spare, buf);
+  }
+
+  /* Step 2: One session and one result list per parser.  Every thread
+     has a file to work on until the reader is done, so big buffers are
+     only split onto threads that ran out of files.                    */
+  int *caller_idle = session ? session->config.split_idle : NULL;
+  if (session)
+    session->config.split_idle = &p->idle;
+  for (; p->worker_count < parsers; p->worker_count++) {
+    ParserWorker *w = &p->workers[p->worker_count];
+    w->pipeline = p;
+    w->owns_session = p->worker_count > 0 || !session;
+    w->session = w->owns_session ? scan_session_create() : session;
+    if (w->owns_session && w->session && session)
+      w->session->config = session->config;
+    else if (w->owns_session && w->session)
+      w->session->config.split_idle = &p->idle;
+    w->results = findings_create();
+    if (!w->session || !w->results ||
+        pthread_create(&w->thread, NULL, parser_main, w) != 0) {
+      if (w->owns_session)
+        scan_session_free(w->session);
+      findings_free(w->results);
+      break;
+    }
+  }
+  if (p->worker_count == 0) {
+    if (session)
+      session->config.split_idle = caller_idle;
+    scan_pipeline_free(p);
+    return NULL;
+  }
+
+  /* Step 3: Read on this thread until every file is handed out */
+  run_reader(p, read_ahead, use_uring);
+  for (int i = 0; i < p->worker_count; i++)
+    pthread_join(p->workers[i].thread, NULL);
+  if (session)
+    session->config.split_idle = caller_idle;
+  return p;
+}
+
+int scan_pipeline_take(ScanPipeline *p, size_t i, FindingList *results) {
+  const ScanJob *job = &p->jobs[i];
+  if (job->count > 0) {
+    long file = findings_add_path(results, job->file->path);
+    if (file < 0 ||
+        findings_copy(results, (uint32_t)file,
+                      p->workers[job->worker].results, job->first,
+                      job->count) == -1)
+      return -1;
+  }
+  return job->status;
+}
+
+void scan_pipeline_free(ScanPipeline *p) {
+  if (!p)
+    return;
+  /* Threads are joined by now, so every buffer is back in spare */
+  void *buf;
+  while (p->spare.cells && ring_try_pop(&p->spare, &buf))
+    fb_free(buf);
+  for (int i = 0; i < p->worker_count; i++) {
+    if (p->workers[i].owns_session)
+      scan_session_free(p->workers[i].session);
+    findings_free(p->workers[i].results);
+  }
+  free(p->ready.cells);
+  free(p->spare.cells);
+  free(p->workers);
+  free(p->jobs);
+  free(p);
+}
@@ -0,0 +1,36 @@
+#ifndef SCAN_PIPELINE_H
+#define SCAN_PIPELINE_H
+
+#include "content_cache.h"
+#include "data_structs.h"
+#include "findings.h"
+#include "text_parser.h"
+
+/* Scans a batch of files on several threads.  The calling thread is the
+   reader stage: it takes the files largest first, reads them (ahead,
+   through read_ahead.c, when read_ahead > 0) and hands the buffers to
+   the parser threads over a bounded lock-free queue; empty buffers come
+   back the same way.  Files of unknown size (-1) sort last, so the
+   walker is asked for sizes (ScanConfig.want_sizes) when this is used.
+   Every parser keeps its own ScanSession and FindingList, so nothing
+   is shared while files are being scanned.                            */
+typedef struct ScanPipeline ScanPipeline;
+
+/* Scans files[0, count) on parsers threads and returns once all of them
+   are done.  session is reused by the first parser and its config
+   given to the others; files read whole go through cache (if any).
+   files must stay valid until scan_pipeline_free(); files that were
+   never stat'ed may be stat'ed.  Returns NULL if the threads could not
+   be set up.                                                          */
+ScanPipeline *scan_pipeline_run(TargetFile *const *files, size_t count,
+                                int parsers, int read_ahead, int use_uring,
+                                ScanSession *session, ContentCache *cache);
+
+/* Appends the findings of files[i] to results and returns what
+   scan_session_file() returned for it (-1 if it could not be read)   */
+int scan_pipeline_take(ScanPipeline *pipeline, size_t i,
+                       FindingList *results);
+
+void scan_pipeline_free(ScanPipeline *pipeline);
+
+#endif /* SCAN_PIPELINE_H */
@@ -0,0 +1,384 @@
+#define _POSIX_C_SOURCE 200809L
+#include "snapshot.h"
+#include "binary_io.h"
+#include "file_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define SNAPSHOT_MAGIC "NOINTLSN"
+#define SNAPSHOT_FORMAT 3
+#define INITIAL_SNAPSHOT_CAPACITY 64
+#define RACY_WINDOW_NS 1000000000LL /* Stamps this close to the run start
+                                       are not trusted next time */
+
+/* =====================================================================
+   LIFECYCLE
+   ===================================================================== */
+
+static long long now_ns(void) {
+#ifdef _WIN32
+  return (long long)time(NULL) * 1000000000LL;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+Snapshot *snapshot_create(uint32_t config_hash) {
+  Snapshot *snap = calloc(1, sizeof(Snapshot));
+  if (!snap)
+    return NULL;
+
+  snap->dirs = malloc(INITIAL_SNAPSHOT_CAPACITY * sizeof(SnapDir));
+  snap->files = malloc(INITIAL_SNAPSHOT_CAPACITY * sizeof(SnapFile));
+  snap->dir_index = hm_create(INITIAL_SNAPSHOT_CAPACITY);
+  snap->file_index = hm_create(INITIAL_SNAPSHOT_CAPACITY);
+  if (!snap->dirs || !snap->files || !snap->dir_index || !snap->file_index) {
+    snapshot_free(snap);
+    return NULL;
+  }
+  snap->dir_capacity = INITIAL_SNAPSHOT_CAPACITY;
+  snap->file_capacity = INITIAL_SNAPSHOT_CAPACITY;
+  snap->config_hash = config_hash;
+  snap->started_ns = now_ns();
+  pthread_mutex_init(&snap->lock, NULL);
+  return snap;
+}
+
+void snapshot_free(Snapshot *snap) {
+  if (!snap)
+    return;
+  for (size_t i = 0; i < snap->dir_count; i++) {
+    free(snap->dirs[i].path);
+    free(snap->dirs[i].names);
+    free(snap->dirs[i].types);
+  }
+  for (size_t i = 0; i < snap->file_count; i++) {
+    free(snap->files[i].path);
+    free(snap->files[i].findings);
+  }
+  free(snap->dirs);
+  free(snap->files);
+  hm_free(snap->dir_index);
+  hm_free(snap->file_index);
+  if (snap->dir_capacity) /* Lock only exists once create succeeded */
+    pthread_mutex_destroy(&snap->lock);
+  free(snap);
+}
+
+static char *copy_bytes(const void *src, size_t len) {
+  char *dst = malloc(len + 1);
+  if (!dst)
+    return NULL;
+  if (len)
+    memcpy(dst, src, len);
+  dst[len] = '\0';
+  return dst;
+}
+
+/* Stamps taken within the racy window may hide a later change made in
+   the same clock tick - store them as "unknown" so they never match */
+static long long trusted_mtime(const Snapshot *snap, long long mtime_ns) {
+  return mtime_ns >= snap->started_ns - RACY_WINDOW_NS ? -1 : mtime_ns;
+}
+
+/* =====================================================================
+   DIRECTORIES
+   ===================================================================== */
+
+const SnapDir *snapshot_find_dir(const Snapshot *snap, const char *rel,
+                                 long long mtime_ns) {
+  size_t idx;
+  if (!snap || !hm_get(snap->dir_index, rel, &idx))
+    return NULL;
+  const SnapDir *d = &snap->dirs[idx];
+  return d->mtime_ns >= 0 && d->mtime_ns == mtime_ns ? d : NULL;
+}
+
+/* Appends a directory record; the caller holds snap->lock if needed */
+static int add_dir_locked(Snapshot *snap, SnapDir *d) {
+  if (snap->dir_count >= snap->dir_capacity) {
+    size_t new_capacity = snap->dir_capacity * 2;
+    SnapDir *grown = realloc(snap->dirs, new_capacity * sizeof(SnapDir));
+    if (!grown)
+      return -1;
+    snap->dirs = grown;
+    snap->dir_capacity = new_capacity;
+  }
+  if (hm_put(snap->dir_index, d->path, snap->dir_count) == -1)
+    return -1;
+  snap->dirs[snap->dir_count++] = *d;
+  return 0;
+}
+
+int snapshot_add_dir(Snapshot *snap, const char *rel, long long mtime_ns,
+                     const char *names, size_t names_len,
+                     const unsigned char *types, size_t entry_count) {
+  SnapDir d;
+  d.path = copy_bytes(rel, strlen(rel));
+  d.mtime_ns = trusted_mtime(snap, mtime_ns);
+  d.names = copy_bytes(names, names_len);
+  d.names_len = names_len;
+  d.types = (unsigned char *)copy_bytes(types, entry_count);
+  d.entry_count = entry_count;
+  if (!d.path || !d.names || !d.types) {
+    free(d.path);
+    free(d.names);
+    free(d.types);
+    return -1;
+  }
+
+  /* Called by every walker thread */
+  pthread_mutex_lock(&snap->lock);
+  int status = add_dir_locked(snap, &d);
+  pthread_mutex_unlock(&snap->lock);
+  if (status == -1) {
+    free(d.path);
+    free(d.names);
+    free(d.types);
+  }
+  return status;
+}
+
+/* =====================================================================
+   FILES
+   ===================================================================== */
+
+const SnapFile *snapshot_find_file(const Snapshot *snap, const char *rel,
+                                   const TargetFile *meta) {
+  size_t idx;
+  if (!snap || !hm_get(snap->file_index, rel, &idx))
+    return NULL;
+  const SnapFile *f = &snap->files[idx];
+  if (f->mtime_ns <= 0 || f->mtime_ns != meta->mtime_ns ||
+      f->size != meta->size || f->ino != meta->ino)
+    return NULL;
+  return f;
+}
+
+static int add_file_locked(Snapshot *snap, SnapFile *f) {
+  if (snap->file_count >= snap->file_capacity) {
+    size_t new_capacity = snap->file_capacity * 2;
+    SnapFile *grown = realloc(snap->files, new_capacity * sizeof(SnapFile));
+    if (!grown)
+      return -1;
+    snap->files = grown;
+    snap->file_capacity = new_capacity;
+  }
+  if (hm_put(snap->file_index, f->path, snap->file_count) == -1)
+    return -1;
+  snap->files[snap->file_count++] = *f;
+  return 0;
+}
+
+static int add_file(Snapshot *snap, const char *rel, const TargetFile *meta,
+                    char *findings, size_t findings_len, size_t count,
+                    unsigned status) {
+  SnapFile f;
+  f.path = copy_bytes(rel, strlen(rel));
+  f.size = meta->size;
+  f.mtime_ns = trusted_mtime(snap, meta->mtime_ns);
+  f.ino = meta->ino;
+  f.findings = findings;
+  f.findings_len = findings_len;
+  f.finding_count = count;
+  f.status = status;
+  if (!f.path) {
+    free(findings);
+    return -1;
+  }
+
+  pthread_mutex_lock(&snap->lock);
+  int added = add_file_locked(snap, &f);
+  pthread_mutex_unlock(&snap->lock);
+  if (added == -1) {
+    free(f.path);
+    free(findings);
+  }
+  return added;
+}
+
+int snapshot_add_file(Snapshot *snap, const char *rel,
+                      const TargetFile *meta, const char *findings,
+                      size_t findings_len, size_t count, unsigned status) {
+  char *packed = copy_bytes(findings, findings_len);
+  if (!packed)
+    return -1;
+  return add_file(snap, rel, meta, packed, findings_len, count, status);
+}
+
+int snapshot_copy_file(Snapshot *snap, const SnapFile *old,
+                       const TargetFile *meta) {
+  char *packed = copy_bytes(old->findings, old->findings_len);
+  if (!packed)
+    return -1;
+  return add_file(snap, old->path, meta, packed, old->findings_len,
+                  old->finding_count, old->status);
+}
+
+/* =====================================================================
+   ON-DISK FORMAT
+   "NOINTLSN" u32 format u32 config_hash u64 dirs u64 files, then
+   dir:  u32 path_len path i64 mtime u64 entries u64 names_len names types
+   file: u32 path_len path i64 size i64 mtime u64 ino u32 status
+         u64 count u64 findings_len findings
+   Integers are in host byte order - the snapshot is a local cache.
+   ===================================================================== */
+
+static int write_string(FILE *out, const char *str) {
+  size_t len = strlen(str);
+  return bin_write_u32(out, (uint32_t)len) | bin_write_bytes(out, str, len);
+}
+
+int snapshot_save(const Snapshot *snap, const char *file) {
+  if (!snap || !file)
+    return -1;
+
+  /* Step 1: Write to a temporary file next to the target */
+  size_t tmp_len = strlen(file) + 5;
+  char *tmp = malloc(tmp_len);
+  if (!tmp)
+    return -1;
+  snprintf(tmp, tmp_len, "%s.tmp", file);
+  FILE *out = fopen(tmp, "wb");
+  if (!out) {
+    perror("fopen");
+    free(tmp);
+    return -1;
+  }
+
+  int err = bin_write_bytes(out, SNAPSHOT_MAGIC, 8);
+  err |= bin_write_u32(out, SNAPSHOT_FORMAT);
+  err |= bin_write_u32(out, snap->config_hash);
+  err |= bin_write_u64(out, snap->dir_count);
+  err |= bin_write_u64(out, snap->file_count);
+
+  for (size_t i = 0; i < snap->dir_count && !err; i++) {
+    const SnapDir *d = &snap->dirs[i];
+    err |= write_string(out, d->path);
+    err |= bin_write_u64(out, (uint64_t)d->mtime_ns);
+    err |= bin_write_u64(out, d->entry_count);
+    err |= bin_write_u64(out, d->names_len);
+    err |= bin_write_bytes(out, d->names, d->names_len);
+    err |= bin_write_bytes(out, d->types, d->entry_count);
+  }
+  for (size_t i = 0; i < snap->file_count && !err; i++) {
+    const SnapFile *f = &snap->files[i];
+    err |= write_string(out, f->path);
+    err |= bin_write_u64(out, (uint64_t)f->size);
+    err |= bin_write_u64(out, (uint64_t)f->mtime_ns);
+    err |= bin_write_u64(out, f->ino);
+    err |= bin_write_u32(out, f->status);
+    err |= bin_write_u64(out, f->finding_count);
+    err |= bin_write_u64(out, f->findings_len);
+    err |= bin_write_bytes(out, f->findings, f->findings_len);
+  }
+
+  if (fclose(out) != 0)
+    err = -1;
+
+  /* Step 2: Atomically replace the old snapshot */
+  if (!err) {
+#ifdef _WIN32
+    remove(file); /* rename() does not replace on Windows */
+#endif
+    err = rename(tmp, file);
+  }
+  if (err) {
+    fprintf(stderr, "Error: Failed to write snapshot %s\n", file);
+    remove(tmp);
+  }
+  free(tmp);
+  return err ? -1 : 0;
+}
+
+/* Returns a NUL-terminated heap copy of the next len bytes */
+static char *read_bytes(BinReader *r, uint64_t len) {
+  const char *span = bin_read_span(r, len, 0);
+  char *copy = span ? copy_bytes(span, (size_t)len) : NULL;
+  if (!copy)
+    r->failed = 1;
+  return copy;
+}
+
+Snapshot *snapshot_load(const char *file, uint32_t config_hash) {
+  /* Step 1: Map the whole snapshot (nothing on the first run) */
+  struct stat st;
+  if (stat(file, &st) != 0)
+    return NULL;
+  FileBuffer *buf = fb_create(INITIAL_BUFFER_SIZE);
+  if (!buf || fb_map_whole(file, buf) == -1) {
+    fb_free(buf);
+    return NULL;
+  }
+
+  /* Step 2: Check the header */
+  const unsigned char *data = (const unsigned char *)buf->content;
+  BinReader r = {.p = data, .end = data + buf->size, .failed = 0};
+  if (buf->size < 8 || memcmp(data, SNAPSHOT_MAGIC, 8) != 0) {
+    fb_free(buf);
+    return NULL;
+  }
+  r.p += 8;
+  uint32_t format = bin_read_u32(&r);
+  uint32_t hash = bin_read_u32(&r);
+  uint64_t dir_count = bin_read_u64(&r);
+  uint64_t file_count = bin_read_u64(&r);
+  if (r.failed || format != SNAPSHOT_FORMAT || hash != config_hash) {
+    fb_free(buf);
+    return NULL; /* Other options or parser version - rescan all */
+  }
+
+  Snapshot *snap = snapshot_create(config_hash);
+  if (!snap) {
+    fb_free(buf);
+    return NULL;
+  }
+
+  /* Step 3: Directory records */
+  for (uint64_t i = 0; i < dir_count && !r.failed; i++) {
+    SnapDir d;
+    d.path = read_bytes(&r, bin_read_u32(&r));
+    d.mtime_ns = (long long)bin_read_u64(&r);
+    d.entry_count = (size_t)bin_read_u64(&r);
+    d.names_len = (size_t)bin_read_u64(&r);
+    d.names = read_bytes(&r, d.names_len);
+    d.types = (unsigned char *)read_bytes(&r, d.entry_count);
+    if (r.failed || add_dir_locked(snap, &d) == -1) {
+      free(d.path);
+      free(d.names);
+      free(d.types);
+      r.failed = 1;
+    }
+  }
+
+  /* Step 4: File records */
+  for (uint64_t i = 0; i < file_count && !r.failed; i++) {
+    SnapFile f;
+    f.path = read_bytes(&r, bin_read_u32(&r));
+    f.size = (long long)bin_read_u64(&r);
+    f.mtime_ns = (long long)bin_read_u64(&r);
+    f.ino = bin_read_u64(&r);
+    f.status = bin_read_u32(&r);
+    f.finding_count = (size_t)bin_read_u64(&r);
+    f.findings_len = (size_t)bin_read_u64(&r);
+    f.findings = read_bytes(&r, f.findings_len);
+    if (r.failed || add_file_locked(snap, &f) == -1) {
+      free(f.path);
+      free(f.findings);
+      r.failed = 1;
+    }
+  }
+
+  fb_free(buf);
+  if (r.failed) {
+    fprintf(stderr, "Warning: Ignoring corrupt snapshot %s\n", file);
+    snapshot_free(snap);
+    return NULL;
+  }
+  return snap;
+}
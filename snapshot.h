@@ -0,0 +1,81 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "data_structs.h"
+#include <pthread.h>
+
+/* One directory as seen by the last run: its mtime and every entry */
+typedef struct {
+  char *path;            /* Relative to the scan root ("" = root) */
+  long long mtime_ns;    /* -1 if it changed while that run was going */
+  char *names;           /* NUL-separated entry names */
+  size_t names_len;      /* Bytes used in names */
+  unsigned char *types;  /* d_type of each entry (0 = unknown) */
+  size_t entry_count;
+} SnapDir;
+
+/* One scanned file: the stat data it was scanned with and its findings */
+typedef struct {
+  char *path;             /* Relative to the scan root */
+  long long size;
+  long long mtime_ns;     /* -1 if it changed while that run was going */
+  unsigned long long ino;
+  char *findings;         /* Packed Findings (see findings_pack) */
+  size_t findings_len;
+  size_t finding_count;
+  unsigned status;        /* scan_session_file() result: 0 or the
+                             ContentKind it was skipped as */
+} SnapFile;
+
+/* Everything one run learned, keyed by relative path.  A snapshot is
+   filled by the walker threads (snapshot_add_dir locks) and by the
+   scan loop, then written out for the next run.                     */
+typedef struct {
+  SnapDir *dirs;
+  size_t dir_count;
+  size_t dir_capacity;
+  SnapFile *files;
+  size_t file_count;
+  size_t file_capacity;
+  HashMap *dir_index;  /* path -> index in dirs */
+  HashMap *file_index; /* path -> index in files */
+  uint32_t config_hash; /* Base directory + parser version the run used
+                           (the other options never change findings) */
+  long long started_ns; /* Wall clock at the start of the run */
+  pthread_mutex_t lock;
+} Snapshot;
+
+/* ── Lifecycle ──────────────────────────────────────────────────────── */
+Snapshot *snapshot_create(uint32_t config_hash);
+void      snapshot_free(Snapshot *snap);
+
+/* Returns NULL if the file is missing, corrupt, or was written with a
+   different config_hash (then everything must be rescanned)          */
+Snapshot *snapshot_load(const char *file, uint32_t config_hash);
+int       snapshot_save(const Snapshot *snap, const char *file);
+
+/* ── Directories ────────────────────────────────────────────────────── */
+
+/* Returns the stored entry list if the directory's mtime is unchanged */
+const SnapDir *snapshot_find_dir(const Snapshot *snap, const char *rel,
+                                 long long mtime_ns);
+int snapshot_add_dir(Snapshot *snap, const char *rel, long long mtime_ns,
+                     const char *names, size_t names_len,
+                     const unsigned char *types, size_t entry_count);
+
+/* ── Files ──────────────────────────────────────────────────────────── */
+
+/* Returns the stored record if size, mtime and inode all match */
+const SnapFile *snapshot_find_file(const Snapshot *snap, const char *rel,
+                                   const TargetFile *meta);
+
+/* Records a file with a copy of its count packed findings */
+int snapshot_add_file(Snapshot *snap, const char *rel,
+                      const TargetFile *meta, const char *findings,
+                      size_t findings_len, size_t count, unsigned status);
+
+/* Same, copying the findings of a record from another snapshot */
+int snapshot_copy_file(Snapshot *snap, const SnapFile *old,
+                       const TargetFile *meta);
+
+#endif /* SNAPSHOT_H */
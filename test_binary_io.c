@@ -0,0 +1,79 @@
+#include "binary_io.h"
+#include "data_structs.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void expect(const char *what, int ok) {
+  printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+/* Published XXH64 test vectors */
+static void expect_hash(const char *input, uint64_t seed, uint64_t expected) {
+  uint64_t got = hash_content(input, strlen(input), seed);
+  char what[96];
+  snprintf(what, sizeof(what), "XXH64(\"%.40s\", %llu) = %016llx", input,
+           (unsigned long long)seed, (unsigned long long)got);
+  expect(what, got == expected);
+}
+
+int main() {
+  printf("=== Testing Binary I/O ===\n");
+
+  printf("hash_content:\n");
+  expect_hash("", 0, 0xef46db3751d8e999ULL);
+  expect_hash("abc", 0, 0x44bc2cf5ad770999ULL);
+  expect_hash("xxhash", 0, 0x32dd38952c4bc720ULL);
+  expect_hash("xxhash", 20141025, 0xb559b98d844e0635ULL);
+  expect_hash("Nobody inspects the spammish repetition", 0,
+              0xfbcea83c8a378bf1ULL); /* Over 32 bytes: the stripe loop */
+
+  /* Step 1: Write a record the way the file formats do */
+  printf("Writing:\n");
+  FILE *out = tmpfile();
+  if (!out) {
+    printf("Failed to create a temporary file\n");
+    return 1;
+  }
+  int err = bin_write_u32(out, 0xdeadbeefu);
+  err |= bin_write_u64(out, 0x0123456789abcdefULL);
+  err |= bin_write_bytes(out, "path", 5); /* With its NUL */
+  err |= bin_write_bytes(out, "raw", 3);
+  err |= bin_write_bytes(out, NULL, 0);
+  expect("writes succeed", err == 0);
+
+  unsigned char data[64];
+  rewind(out);
+  size_t len = fread(data, 1, sizeof(data), out);
+  fclose(out);
+  expect("20 bytes written", len == 20);
+
+  /* Step 2: Read it back */
+  printf("Round trip:\n");
+  BinReader r = {.p = data, .end = data + len, .failed = 0};
+  expect("u32", bin_read_u32(&r) == 0xdeadbeefu);
+  expect("u64", bin_read_u64(&r) == 0x0123456789abcdefULL);
+  const char *path = bin_read_span(&r, 4, 1);
+  expect("span with NUL", path && strcmp(path, "path") == 0);
+  const char *raw = bin_read_span(&r, 3, 0);
+  expect("span without NUL", raw && memcmp(raw, "raw", 3) == 0);
+  expect("nothing failed", !r.failed && r.p == r.end);
+
+  /* Step 3: Reads past the end fail, and stay failed */
+  printf("Bounds:\n");
+  expect("u32 at the end is 0", bin_read_u32(&r) == 0 && r.failed);
+  r = (BinReader){.p = data, .end = data + 3, .failed = 0};
+  expect("short u32 fails", bin_read_u32(&r) == 0 && r.failed);
+  r = (BinReader){.p = data + 12, .end = data + len, .failed = 0};
+  expect("span without its NUL fails", !bin_read_span(&r, 5, 1) && r.failed);
+  r = (BinReader){.p = data + 12, .end = data + len, .failed = 0};
+  expect("span past the end fails", !bin_read_span(&r, 9, 0) && r.failed);
+  r = (BinReader){.p = data + 12, .end = data + len, .failed = 0};
+  expect("huge span fails", !bin_read_span(&r, UINT64_MAX, 1) && r.failed);
+
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
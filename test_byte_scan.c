@@ -0,0 +1,83 @@
+#include "byte_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char CLASS_BYTES[BS_CLASS_COUNT] = {'\n', '"', '\'', '`',
+                                                 '<',  '>', '{',  '}'};
+
+static int failures = 0;
+
+/* Byte-at-a-time reference for one block */
+static uint64_t reference_mask(const char *p, size_t len, char byte) {
+  uint64_t m = 0;
+  for (size_t i = 0; i < len && i < 64; i++) {
+    if (p[i] == byte)
+      m |= 1ULL << i;
+  }
+  return m;
+}
+
+int main() {
+  printf("=== Testing Byte Scan (%s kernel) ===\n", byte_scan_kernel());
+
+  /* Source-like text with every class, plus bytes that only differ
+     from them in the high bit                                       */
+  const char alphabet[] = "ab <>{}\"'`\n=;()\xbc\xbe\xfb\x8a";
+  size_t size = 64 * 40 + 17;
+  char *text = malloc(size);
+  if (!text)
+    return 1;
+  srand(42);
+  for (size_t i = 0; i < size; i++)
+    text[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+
+  /* Every block length from 0 to 64, at every alignment */
+  int bad_blocks = 0;
+  for (size_t off = 0; off < 64; off++) {
+    for (size_t len = 0; len <= 64; len++) {
+      uint64_t masks[BS_CLASS_COUNT];
+      byte_scan_block(text + off, len, masks);
+      for (int c = 0; c < BS_CLASS_COUNT; c++) {
+        if (masks[c] != reference_mask(text + off, len, CLASS_BYTES[c]))
+          bad_blocks++;
+      }
+    }
+  }
+  printf("  %-4s block masks match the reference\n",
+         bad_blocks ? "FAIL" : "ok");
+  if (bad_blocks)
+    failures++;
+
+  /* byte_index_next() must agree with memchr() from every offset */
+  ByteIndex index = {0};
+  if (byte_index_build(&index, text, size, 1u << BS_NEWLINE | 1u << BS_GT) ==
+      -1) {
+    printf("Failed to build index\n");
+    free(text);
+    return 1;
+  }
+  int bad_next = 0;
+  for (size_t from = 0; from <= size; from++) {
+    size_t to = from + (from * 7) % 300;
+    if (to > size)
+      to = size;
+    const char *nl = memchr(text + from, '\n', to - from);
+    size_t want = nl ? (size_t)(nl - text) : to;
+    if (byte_index_next(&index, BS_NEWLINE, from, to) != want)
+      bad_next++;
+    const char *gt = memchr(text + from, '>', size - from);
+    want = gt ? (size_t)(gt - text) : size;
+    if (byte_index_next(&index, BS_GT, from, size) != want)
+      bad_next++;
+  }
+  printf("  %-4s index searches match memchr()\n", bad_next ? "FAIL" : "ok");
+  if (bad_next)
+    failures++;
+
+  byte_index_free(&index);
+  free(text);
+
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+#include "content_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+static void expect(const char *what, int ok) {
+  printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+/* A FileBuffer over a string literal, the way the reader hands one over */
+static FileBuffer buffer_of(const char *text) {
+  FileBuffer buf = {.content = (char *)text,
+                    .size = strlen(text),
+                    .capacity = strlen(text) + 1,
+                    .mapped = 0,
+                    .spare = NULL};
+  return buf;
+}
+
+/* Scans text as path through cache; returns the number of findings */
+static size_t scan(ContentCache *cache, ScanSession *session,
+                   const char *path, const char *text, int *status) {
+  FileBuffer buf = buffer_of(text);
+  FindingList *results = findings_create();
+  *status = cache_scan_file(cache, session, path, &buf, results);
+  size_t count = results ? results->size : 0;
+  findings_free(results);
+  return count;
+}
+
+int main() {
+  printf("=== Testing Content Cache ===\n");
+  char dir[] = "/tmp/nointl_cache_XXXXXX";
+  if (!mkdtemp(dir)) {
+    printf("Failed to create a temporary directory\n");
+    return 1;
+  }
+  char file[sizeof(dir) + 16];
+  snprintf(file, sizeof(file), "%s/results.bin", dir);
+
+  const char *page = "export default function Page() {\n"
+                     "  return <h1>Welcome back</h1>;\n"
+                     "}\n";
+  const char *clean = "export const x = 1;\n";
+  ScanSession *session = scan_session_create();
+  if (!session) {
+    printf("Failed to create a session\n");
+    return 1;
+  }
+
+  /* Step 1: A first run fills the cache */
+  printf("First run:\n");
+  int status;
+  ContentCache *cache = cache_open(dir, 42, CACHE_DEFAULT_SIZE);
+  expect("opens an empty directory", cache != NULL);
+  expect("page scanned: 1 finding",
+         scan(cache, session, "app/page.tsx", page, &status) == 1 &&
+             status == 0);
+  expect("clean file scanned: none",
+         scan(cache, session, "lib/x.ts", clean, &status) == 0);
+  expect("closes", cache_close(cache) == 0);
+  expect("results.bin written", access(file, F_OK) == 0);
+
+  /* Step 2: The next run replays them.  With strings this short
+     skipped, a real scan finds nothing - so a finding is a hit.    */
+  printf("Second run:\n");
+  size_t max_len = session->config.max_string_len;
+  session->config.max_string_len = 1;
+  cache = cache_open(dir, 42, CACHE_DEFAULT_SIZE);
+  expect("page replayed under another path",
+         scan(cache, session, "moved/page.tsx", page, &status) == 1 &&
+             status == 0);
+  expect("same bytes as .ts are another entry",
+         scan(cache, session, "moved/page.ts", page, &status) == 0);
+  expect("closes", cache_close(cache) == 0);
+
+  /* Step 3: Another stamp (parser version, options) starts over */
+  printf("Other stamp:\n");
+  cache = cache_open(dir, 43, CACHE_DEFAULT_SIZE);
+  expect("page scanned again",
+         scan(cache, session, "app/page.tsx", page, &status) == 0);
+  expect("closes", cache_close(cache) == 0);
+
+  /* Step 4: A torn tail is dropped, the records before it kept */
+  printf("Torn file:\n");
+  session->config.max_string_len = max_len;
+  cache = cache_open(dir, 44, CACHE_DEFAULT_SIZE);
+  scan(cache, session, "app/page.tsx", page, &status);
+  cache_close(cache);
+  FILE *out = fopen(file, "ab");
+  expect("tail appended", out && fwrite("torn", 1, 4, out) == 4);
+  if (out)
+    fclose(out);
+  session->config.max_string_len = 1;
+  cache = cache_open(dir, 44, CACHE_DEFAULT_SIZE);
+  expect("opens despite the tail", cache != NULL);
+  expect("earlier record still replayed",
+         scan(cache, session, "app/page.tsx", page, &status) == 1);
+  expect("closes", cache_close(cache) == 0);
+
+  /* Step 5: A record whose bytes changed is not trusted */
+  printf("Corrupt record:\n");
+  out = fopen(file, "r+b");
+  expect("last byte flipped",
+         out && fseek(out, -1, SEEK_END) == 0 && fputc('~', out) != EOF);
+  if (out)
+    fclose(out);
+  cache = cache_open(dir, 44, CACHE_DEFAULT_SIZE);
+  expect("page scanned again",
+         scan(cache, session, "app/page.tsx", page, &status) == 0);
+
+  /* Step 6: While this run holds the directory, another goes without */
+  printf("Held by another run:\n");
+  pid_t child = fork();
+  if (child == 0)
+    _exit(cache_open(dir, 44, CACHE_DEFAULT_SIZE) == NULL ? 0 : 1);
+  int child_status = -1;
+  expect("second run skips the cache",
+         child > 0 && waitpid(child, &child_status, 0) == child &&
+             WIFEXITED(child_status) && WEXITSTATUS(child_status) == 0);
+  expect("closes", cache_close(cache) == 0);
+
+  char lock[sizeof(dir) + 16];
+  snprintf(lock, sizeof(lock), "%s/lock", dir);
+  remove(lock);
+  remove(file);
+  rmdir(dir);
+  scan_session_free(session);
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
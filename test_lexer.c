@@ -0,0 +1,113 @@
+#include "lexer.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+/* Lexes text fed in buffers cut after each '\f', and lists its strings
+   and JSX text as "S<line>:<col>[text]" / "T<line>:<col>[text]"       */
+static void lex_text(const char *text, int allow_jsx, char *out,
+                     size_t out_size) {
+  Lexer lx;
+  ByteIndex index = {0};
+  size_t line = 1;
+  out[0] = '\0';
+  lexer_start(&lx, allow_jsx);
+  while (*text) {
+    const char *cut = strchr(text, '\f');
+    size_t size = cut ? (size_t)(cut - text) : strlen(text);
+    if (byte_index_build(&index, text, size, lexer_index_classes()) == -1)
+      break;
+    lexer_feed(&lx, text, size, line, &index);
+    Token tok;
+    while (lexer_next(&lx, &tok)) {
+      if (tok.kind != TOK_STRING && tok.kind != TOK_JSX_TEXT)
+        continue;
+      size_t used = strlen(out);
+      snprintf(out + used, out_size - used, "%s%c%zu:%zu[%.*s]",
+               used ? " " : "", tok.kind == TOK_STRING ? 'S' : 'T', tok.line,
+               tok.col, (int)tok.len, tok.ptr);
+    }
+    for (size_t i = 0; i < size; i++)
+      line += text[i] == '\n';
+    text += cut ? size + 1 : size;
+  }
+  byte_index_free(&index);
+}
+
+static void expect(const char *name, const char *text, int allow_jsx,
+                   const char *expected) {
+  char got[512];
+  lex_text(text, allow_jsx, got, sizeof(got));
+  int ok = strcmp(got, expected) == 0;
+  printf("  %-4s %s\n", ok ? "ok" : "FAIL", name);
+  if (!ok) {
+    printf("       want: %s\n       got:  %s\n", expected, got);
+    failures++;
+  }
+}
+
+/* Lexes text in one buffer and checks whether the lexer ends at the
+   top level right after last (a place a big file may be cut)        */
+static void expect_top_level(const char *name, const char *text, char last,
+                             int expected) {
+  Lexer lx;
+  ByteIndex index = {0};
+  lexer_start(&lx, 1);
+  if (byte_index_build(&index, text, strlen(text), lexer_index_classes()) ==
+      0) {
+    lexer_feed(&lx, text, strlen(text), 1, &index);
+    Token tok;
+    while (lexer_next(&lx, &tok))
+      ;
+  }
+  byte_index_free(&index);
+  int ok = lexer_at_top_level(&lx, last) == expected;
+  printf("  %-4s %s\n", ok ? "ok" : "FAIL", name);
+  if (!ok)
+    failures++;
+}
+
+int main() {
+  printf("=== Testing Lexer ===\n");
+
+  expect("strings and escapes", "a = \"x\\\"y\" + 'z';\n", 1,
+         "S1:6[x\\\"y] S1:15[z]");
+  expect("comments hide strings",
+         "// \"no\"\n/* 'no'\n   \"no\" */ b = \"yes\";\n", 1, "S3:17[yes]");
+  expect("templates", "a = `plain`; b = `x ${\"in\"} y`;\n", 1,
+         "S1:6[plain] S1:24[in]");
+  expect("regex is no string", "r = /\"[<]'/g; s = 'ok';\n", 1, "S1:20[ok]");
+  expect("comparison is no tag", "if (a < b) c = \"s\";\n", 1, "S1:17[s]");
+  expect("multi-line JSX", "x = <p\n  title=\"a\nb\">\n  Hi\n  there\n</p>;\n",
+         1, "S2:10[a\nb] T4:3[Hi\n  there]");
+  expect("nested expressions",
+         "<div>{ok ? <b>Yes</b> : \"No\"} after</div>\n", 1,
+         "T1:15[Yes] S1:26[No] T1:31[after]");
+  expect(".ts has no JSX", "x = <T>(y); z = \"s\";\n", 0, "S1:18[s]");
+  expect("generic arrow is no tag",
+         "const id = <T,>(v: T) => v;\nf(\"top\");\n", 1, "S2:4[top]");
+  expect("constrained generic is no tag",
+         "const g = <T extends object>(v: T) => v;\nf(\"top\");\n", 1,
+         "S2:4[top]");
+  expect("generic function type is no tag",
+         "type Fn = <T>(x: T) => T;\nf(\"top\");\n", 1, "S2:4[top]");
+  expect("call signature is no tag",
+         "type C = { <T>(x: T): T };\nf(\"top\");\n", 1, "S2:4[top]");
+  expect("parenthesised JSX text is",
+         "x = <span>(note)</span>;\ny = <B>(a) b</B>;\n", 1,
+         "T1:11[(note)] T2:8[(a) b]");
+  expect("state carries across buffers",
+         "/* open\n\f*/ a = \"s\";\n\f<p>\n\fText</p>\n", 1,
+         "S2:9[s] T4:1[Text]");
+
+  expect_top_level("cut after a statement", "f(\"a\");\n", ';', 1);
+  expect_top_level("cut after a function",
+                   "function f() {\n  return <p>Hi</p>;\n}\n", '}', 1);
+  expect_top_level("no cut inside a block", "if (a) {\n  b();\n", ';', 0);
+  expect_top_level("no cut inside JSX", "x = <p>\n  a;\n", ';', 0);
+  expect_top_level("no cut inside a comment", "/* a;\n", ';', 0);
+
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#include "path_filter.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void expect(const PathFilter *filter, const char *path, int is_dir,
+                   int expected) {
+  int got = path_filter_match_path(filter, path, is_dir);
+  printf("  %-4s %-40s %-5s %s\n", got == expected ? "ok" : "FAIL", path,
+         is_dir ? "(dir)" : "", got ? "kept" : "skipped");
+  if (got != expected)
+    failures++;
+}
+
+int main() {
+  printf("=== Testing Path Filter ===\n");
+
+  /* Defaults + includes, like main.c sets them up */
+  PathFilter *filter = path_filter_create();
+  if (!filter) {
+    printf("Failed to create filter\n");
+    return 1;
+  }
+  path_filter_add_defaults(filter);
+  path_filter_add_default_includes(filter);
+  path_filter_add(filter, RULE_EXCLUDE, "generated/");
+  path_filter_add(filter, RULE_EXCLUDE, "/legacy/**/old*.tsx");
+  path_filter_add(filter, RULE_EXCLUDE, "*.gen.[jt]s");
+  path_filter_compile(filter);
+
+  printf("Built-in and command line rules:\n");
+  expect(filter, "src/app/page.tsx", 0, 1);
+  expect(filter, "src/app/styles.css", 0, 0);
+  expect(filter, "node_modules", 1, 0);
+  expect(filter, "packages/ui/node_modules", 1, 0);
+  expect(filter, "packages/ui/my_node_modules", 1, 1);
+  expect(filter, "packages/ui/node_modules/x/index.js", 0, 0);
+  expect(filter, "next.config.js", 0, 0);
+  expect(filter, "src/Button.test.tsx", 0, 0);
+  expect(filter, "src/my.test.utils", 1, 1); /* file-only default */
+  expect(filter, "src/dist", 0, 0);          /* not a .tsx anyway */
+  expect(filter, "src/generated", 1, 0);
+  expect(filter, "legacy/oldForm.tsx", 0, 0);
+  expect(filter, "legacy/a/b/oldForm.tsx", 0, 0);
+  expect(filter, "legacy/a/newForm.tsx", 0, 1);
+  expect(filter, "legacy/xoldForm.tsx", 0, 1);
+  expect(filter, "src/legacy/oldForm.tsx", 0, 1); /* anchored */
+  expect(filter, "api/client.gen.ts", 0, 0);
+  expect(filter, "api/client.gen.tsx", 0, 1);
+
+  /* An ignore file found in "apps/web" */
+  const char *ignore = "# comment\n"
+                       "\n"
+                       "storybook-static/\n"
+                       "*.stories.tsx\n"
+                       "/public\n"
+                       "!keep.stories.tsx\n";
+  PathFilter *nested =
+      path_filter_extend(filter, "apps/web", ignore, strlen(ignore));
+  if (!nested) {
+    printf("Failed to extend filter\n");
+    path_filter_free(filter);
+    return 1;
+  }
+
+  printf("Rules from apps/web/.gitignore:\n");
+  expect(nested, "apps/web/storybook-static", 1, 0);
+  expect(nested, "apps/web/src/Card.stories.tsx", 0, 0);
+  expect(nested, "apps/web/src/keep.stories.tsx", 0, 1);
+  expect(nested, "apps/web/public", 1, 0);
+  expect(nested, "apps/web/src/public", 1, 1);
+  expect(nested, "apps/admin/Card.stories.tsx", 0, 1);
+  expect(nested, "apps/web/src/page.tsx", 0, 1);
+  expect(nested, "apps/web/node_modules", 1, 0);
+
+  /* One in a dynamic route, whose name is full of glob characters */
+  const char *route_ignore = "gen/\n*.draft.tsx\n";
+  PathFilter *route = path_filter_extend(filter, "app/[locale]/*", route_ignore,
+                                         strlen(route_ignore));
+  if (!route) {
+    printf("Failed to extend filter\n");
+    path_filter_free(nested);
+    path_filter_free(filter);
+    return 1;
+  }
+
+  printf("Rules from app/[locale]/*/.gitignore:\n");
+  expect(route, "app/[locale]/*/gen", 1, 0);
+  expect(route, "app/[locale]/*/a/x.draft.tsx", 0, 0);
+  expect(route, "app/[locale]/*/page.tsx", 0, 1);
+  expect(route, "app/l/x/gen", 1, 1); /* Not the same directory */
+
+  path_filter_free(route);
+  path_filter_free(nested);
+  path_filter_free(filter);
+
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+static void expect(const char *what, int ok) {
+  printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+/* Adds one finding to path, registering the path on first use */
+static void add(FindingList *list, const char *path, size_t line,
+                const char *text) {
+  long file = findings_add_path(list, path);
+  if (file >= 0)
+    findings_add(list, (uint32_t)file, line, 1, FINDING_JSX_TEXT, "p", 1,
+                 text, strlen(text));
+}
+
+static const char *path_of(const FindingList *list, size_t i) {
+  return list->paths->strings[list->items[i].file];
+}
+
+int main() {
+  printf("=== Testing Partial Reports ===\n");
+  char first[] = "/tmp/nointl_partial_1_XXXXXX";
+  char second[] = "/tmp/nointl_partial_2_XXXXXX";
+  FILE *f1 = fdopen(mkstemp(first), "wb");
+  FILE *f2 = fdopen(mkstemp(second), "wb");
+  if (!f1 || !f2) {
+    printf("Failed to create temporary files\n");
+    return 1;
+  }
+  fclose(f1);
+  fclose(f2);
+
+  /* Step 1: Two shards, scanned from different checkouts */
+  FindingList *a = findings_create();
+  FindingList *b = findings_create();
+  DynamicArray *skipped_a = da_create();
+  DynamicArray *skipped_b = da_create();
+  add(a, "/ci/job1/src/a.tsx", 3, "Hello");
+  add(a, "/ci/job1/src/a.tsx", 7, "World");
+  add(a, "/ci/job1/src/c.tsx", 1, "Third");
+  da_append(skipped_a, "/ci/job1/src/gen.ts (generated)");
+  add(b, "/home/dev/repo/src/b.tsx", 2, "Second");
+  printf("Saving:\n");
+  expect("shard 1/2 saved",
+         report_save(first, strlen("/ci/job1"), 1, 2, 4, a, skipped_a) == 0);
+  expect("shard 2/2 saved", report_save(second, strlen("/home/dev/repo"), 2,
+                                        2, 3, b, skipped_b) == 0);
+
+  /* Step 2: Merge them back, in path order and relative to the root */
+  printf("Merging:\n");
+  FindingList *merged = findings_create();
+  DynamicArray *skipped = da_create();
+  size_t scanned = 0;
+  const char *files[] = {second, first};
+  expect("merge succeeds",
+         report_merge(files, 2, merged, skipped, &scanned) == 0);
+  expect("7 files scanned", scanned == 7);
+  expect("4 findings", merged->size == 4);
+  if (merged->size == 4) {
+    expect("src/a.tsx first",
+           strcmp(path_of(merged, 0), "src/a.tsx") == 0 &&
+               merged->items[0].line == 3 &&
+               strcmp(merged->items[0].text, "Hello") == 0);
+    expect("...then its line 7",
+           merged->items[1].line == 7 &&
+               strcmp(merged->items[1].text, "World") == 0);
+    expect("src/b.tsx from the other checkout",
+           strcmp(path_of(merged, 2), "src/b.tsx") == 0);
+    expect("src/c.tsx last", strcmp(path_of(merged, 3), "src/c.tsx") == 0);
+    expect("label kept", strcmp(merged->items[0].label, "p") == 0);
+  }
+  expect("skipped entry relative",
+         skipped->size == 1 &&
+             strcmp(skipped->strings[0], "src/gen.ts (generated)") == 0);
+
+  /* Step 3: What must be refused */
+  printf("Refusing:\n");
+  FindingList *again = findings_create();
+  DynamicArray *again_skipped = da_create();
+  const char *twice[] = {first, first};
+  scanned = 0;
+  expect("a shard given twice",
+         report_merge(twice, 2, again, again_skipped, &scanned) == -1);
+  struct stat st;
+  expect("cut short",
+         stat(second, &st) == 0 && truncate(second, st.st_size - 3) == 0);
+  const char *with_torn[] = {first, second};
+  expect("a torn partial",
+         report_merge(with_torn, 2, again, again_skipped, &scanned) == -1);
+
+  remove(first);
+  remove(second);
+  findings_free(a);
+  findings_free(b);
+  findings_free(merged);
+  findings_free(again);
+  da_free(skipped_a);
+  da_free(skipped_b);
+  da_free(skipped);
+  da_free(again_skipped);
+
+  printf("%s\n", failures ? "Some checks FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
@@ -1,11 +1,20 @@
 #include "text_parser.h"
+#include "word_tables.h"
 #include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MAX_STRING_LENGTH 300
-#define MAX_LINE_LENGTH 4096
+#define TNAMES_BLOCK 1024 /* Arena block for one file's translator names */
+#define CLASSIFY_SAMPLE 4096 /* Bytes from the start the classifier reads */
+#define CLASSIFY_HEADER 1024 /* ...of which the leading comments may hold
+                                a @generated banner */
+#define CLASSIFY_TAIL 512    /* Bytes from the end searched for a map URL */
+#define MINIFIED_LINE_AVG 500 /* Average line length of minified output */
+#define SPLIT_MIN_PIECE (128 * 1024) /* Smallest piece worth a thread   */
+#define SPLIT_SEARCH (64 * 1024)     /* How far a cut looks for its line */
 
 /* =====================================================================
    PARSER CONFIGURATION
@@ -18,6 +27,8 @@ ParserConfig *parser_config_create(void) {
     return NULL;
   }
   pc->max_string_len = MAX_STRING_LENGTH;
+  pc->split_threads = 1;
+  pc->split_idle = NULL;
   return pc;
 }
 
@@ -26,6 +37,39 @@ void parser_config_free(ParserConfig *config) {
     free(config);
 }
 
+/* =====================================================================
+   SCAN SESSIONS
+   ===================================================================== */
+
+ScanSession *scan_session_create(void) {
+  ScanSession *session = calloc(1, sizeof(ScanSession));
+  if (!session) {
+    fprintf(stderr, "Error: malloc failed for ScanSession\n");
+    return NULL;
+  }
+  session->config.max_string_len = MAX_STRING_LENGTH;
+  session->config.split_threads = 1;
+  session->buffer = fb_create(INITIAL_BUFFER_SIZE);
+  session->tnames = sv_create(TNAMES_BLOCK);
+  session->tname_index = hm_create(16);
+  if (!session->buffer || !session->tnames || !session->tname_index) {
+    fprintf(stderr, "Error: malloc failed for ScanSession\n");
+    scan_session_free(session);
+    return NULL;
+  }
+  return session;
+}
+
+void scan_session_free(ScanSession *session) {
+  if (!session)
+    return;
+  fb_free(session->buffer);
+  sv_free(session->tnames);
+  hm_free(session->tname_index);
+  byte_index_free(&session->index);
+  free(session);
+}
+
 /* =====================================================================
    HELPERS
    ===================================================================== */
@@ -40,39 +84,21 @@ int is_empty_or_whitespace(const char *text) {
   return 1;
 }
 
-/* Returns 1 if str is a known TypeScript / JavaScript built-in type or
-   keyword that should never be flagged as untranslated human text.     */
-static int is_ts_type_keyword(const char *str, size_t len) {
-  static const char *const TS_KEYWORDS[] = {
-    /* TypeScript primitive & utility types */
-    "Promise", "void", "string", "number", "boolean", "object", "symbol",
-    "bigint", "never", "unknown", "any", "undefined", "null",
-    /* Generic utility types */
-    "Array", "Record", "Partial", "Required", "Readonly", "ReadonlyArray",
-    "Pick", "Omit", "Exclude", "Extract", "NonNullable", "ReturnType",
-    "InstanceType", "Parameters", "ConstructorParameters", "Awaited",
-    "Uppercase", "Lowercase", "Capitalize", "Uncapitalize",
-    /* React types */
-    "ReactNode", "ReactElement", "ReactChild", "ReactFragment",
-    "ReactPortal", "ReactDOM", "RefObject", "MutableRefObject",
-    "CSSProperties", "MouseEvent", "KeyboardEvent", "ChangeEvent",
-    "FormEvent", "FocusEvent", "SubmitEvent", "SyntheticEvent",
-    /* Common utility */
-    "UseFormReturn", "FieldValues", "Resolver", "DefaultValues",
-    "HTMLElement", "HTMLDivElement", "HTMLInputElement", "HTMLButtonElement",
-    "EventTarget", "NodeList", "Element", "Document", "Window",
-    NULL
-  };
-  char buf[128];
-  if (len == 0 || len >= sizeof(buf))
-    return 0;
-  strncpy(buf, str, len);
-  buf[len] = '\0';
-  for (int i = 0; TS_KEYWORDS[i] != NULL; i++) {
-    if (strcmp(buf, TS_KEYWORDS[i]) == 0)
-      return 1;
+/* Bounded strstr(): finds needle in [pos, end).  Lines are spans into
+   the file buffer, which may be a read-only mapping without a NUL
+   terminator.                                                         */
+static const char *find_bytes(const char *pos, const char *end,
+                              const char *needle) {
+  size_t len = strlen(needle);
+  while ((size_t)(end - pos) >= len) {
+    const char *hit = memchr(pos, needle[0], (size_t)(end - pos) - len + 1);
+    if (!hit)
+      return NULL;
+    if (memcmp(hit, needle, len) == 0)
+      return hit;
+    pos = hit + 1;
   }
-  return 0;
+  return NULL;
 }
 
 /* Returns 1 if str looks like human-readable text:
@@ -85,7 +111,7 @@ int looks_like_human_text(const char *str, size_t len) {
     return 0;
   if (!isalpha((unsigned char)str[0]))
     return 0;
-  if (is_ts_type_keyword(str, len))
+  if (ts_keyword_index(str, len) >= 0)
     return 0;
   int has_space = 0, has_upper = 0;
   for (size_t i = 0; i < len; i++) {
@@ -99,709 +125,846 @@ int looks_like_human_text(const char *str, size_t len) {
   return has_space || has_upper;
 }
 
-/* Returns 1 if this line should be skipped entirely:
-   comments, next-intl imports, directives, translator init lines      */
-int is_safe_line(const char *line) {
-  const char *p = line;
-  while (*p && isspace((unsigned char)*p))
-    p++;
-  if (*p == '\0')
-    return 1;
+/* Calls whose result is a translator */
+static const char *const TRANSLATOR_FACTORIES[] = {
+    "useTranslations(", "getTranslations(", "useFormatter(", NULL};
+#define FACTORY_COUNT 3
+#define DESTRUCTURE_MAX 256 /* Longest { ... } = pattern looked into */
 
-  /* Single-line comments */
-  if (p[0] == '/' && p[1] == '/')
-    return 1;
-
-  /* Block-comment continuation lines */
-  if (p[0] == '*')
-    return 1;
-
-  /* Import from next-intl */
-  if (strncmp(p, "import", 6) == 0 &&
-      (strstr(line, "next-intl") || strstr(line, "next/intl")))
-    return 1;
-
-  /* "use client" / "use server" directives */
-  if (strstr(p, "\"use client\"") || strstr(p, "'use client'") ||
-      strstr(p, "\"use server\"") || strstr(p, "'use server'"))
-    return 1;
+static int is_name_byte(char c) {
+  return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
 
-  /* Translator initialisation: const t = useTranslations(...) */
-  if ((strstr(p, "useTranslations(") || strstr(p, "getTranslations(")) &&
-      strstr(p, "const ") && strchr(p, '='))
-    return 1;
+/* Records the name at [start, start + len) once: seen (if not NULL)
+   indexes the names already in names                                */
+static void add_translator_name(const char *start, size_t len,
+                                StringVec *names, HashMap *seen) {
+  size_t unused;
+  if (len < 1 || len >= 64)
+    return;
+  if (seen && hm_get_span(seen, start, len, &unused))
+    return;
+  /* Skip JS keywords that could appear before '=' */
+  if ((len == 5 && memcmp(start, "const", 5) == 0) ||
+      (len == 3 && (memcmp(start, "let", 3) == 0 ||
+                    memcmp(start, "var", 3) == 0)))
+    return;
+  if (sv_append_n(names, start, len) == 0 && seen)
+    hm_put(seen, names->strings[names->size - 1], 0);
+}
 
-  return 0;
+/* Records every binding of a { a, b: c, ...d } or [a, b] pattern
+   spanning (open, close) - here a, c, d and a, b                   */
+static void add_destructured_names(const char *open, const char *close,
+                                   StringVec *names, HashMap *seen) {
+  const char *p = open + 1;
+  while (p < close) {
+    const char *part_end = memchr(p, ',', (size_t)(close - p));
+    if (!part_end)
+      part_end = close;
+
+    /* key: binding = default  →  binding */
+    const char *colon = memchr(p, ':', (size_t)(part_end - p));
+    const char *q = colon ? colon + 1 : p;
+    while (q < part_end && (isspace((unsigned char)*q) || *q == '.'))
+      q++;
+    const char *name = q;
+    while (q < part_end && is_name_byte(*q))
+      q++;
+    add_translator_name(name, (size_t)(q - name), names, seen);
+    p = part_end + 1;
+  }
 }
 
-/* Returns 1 if the string whose opening quote is at str_start in *line
-   is the direct first argument of a known translator call.
-   e.g. t("key")  →  safe; setError("msg")  →  not safe.             */
-int is_inside_translator_call(const char *line, size_t str_start,
-                              const DynamicArray *tnames) {
-  if (!tnames || tnames->size == 0 || str_start == 0)
-    return 0;
+/* Records the variable(s) a translator call at found is assigned to:
+   const t = useTranslations(...), const t = await getTranslations(...),
+   const { t } = ...  The walk back may reach down to floor.          */
+static void add_binding_at(const char *floor, const char *found,
+                           StringVec *names, HashMap *seen) {
+  const char *back = found - 1;
+  while (back > floor && isspace((unsigned char)*back))
+    back--;
 
-  /* Walk backwards past the opening quote to find the preceding '(' */
-  int pos = (int)str_start - 1;
-  while (pos >= 0 && isspace((unsigned char)line[pos]))
-    pos--;
-  if (pos < 0 || line[pos] != '(')
-    return 0;
-  pos--;
-  while (pos >= 0 && isspace((unsigned char)line[pos]))
-    pos--;
-  if (pos < 0)
-    return 0;
+  /* await getTranslations(...) */
+  if (back - floor >= 5 && memcmp(back - 4, "await", 5) == 0 &&
+      !is_name_byte(back[-5])) {
+    back -= 5;
+    while (back > floor && isspace((unsigned char)*back))
+      back--;
+  }
 
-  /* Extract the function / method name before '(' */
-  int name_end = pos;
-  while (pos >= 0 && (isalnum((unsigned char)line[pos]) || line[pos] == '_'))
-    pos--;
-  int name_start = pos + 1;
-  int name_len = name_end - name_start + 1;
-  if (name_len <= 0 || name_len >= 64)
-    return 0;
+  /* Expect:  <binding> = useTranslations(  - not == or => */
+  if (back <= floor || *back != '=')
+    return;
+  back--;
+  if (*back == '=' || *back == '!' || *back == '<' || *back == '>')
+    return;
+  while (back > floor && isspace((unsigned char)*back))
+    back--;
 
-  char name[64];
-  strncpy(name, &line[name_start], (size_t)name_len);
-  name[name_len] = '\0';
+  if (*back == '}' || *back == ']') {
+    char close = *back;
+    char open = close == '}' ? '{' : '[';
+    const char *lowest =
+        back - floor > DESTRUCTURE_MAX ? back - DESTRUCTURE_MAX : floor;
+    int depth = 0;
+    for (const char *p = back; p >= lowest; p--) {
+      if (*p == close)
+        depth++;
+      else if (*p == open && --depth == 0) {
+        add_destructured_names(p, back, names, seen);
+        break;
+      }
+      if (p == lowest)
+        break;
+    }
+    return;
+  }
 
-  for (size_t i = 0; i < tnames->size; i++) {
-    if (strcmp(tnames->strings[i], name) == 0)
-      return 1;
+  const char *name_end = back + 1;
+  while (back > floor && is_name_byte(*back))
+    back--;
+  const char *name_start = is_name_byte(*back) ? back : back + 1;
+  add_translator_name(name_start, (size_t)(name_end - name_start), names,
+                      seen);
+}
+
+/* Collects the translator names whose call starts in [pos, end) in one
+   forward pass: each factory's next occurrence is only searched for
+   again once the scan has passed it.  The walk back to the binding may
+   reach down to floor, which lets a streamed window look into the
+   bytes kept before it.                                             */
+static void collect_names_in(const char *floor, const char *pos,
+                             const char *end, StringVec *names,
+                             HashMap *seen) {
+  const char *next[FACTORY_COUNT];
+  for (int i = 0; i < FACTORY_COUNT; i++)
+    next[i] = find_bytes(pos, end, TRANSLATOR_FACTORIES[i]);
+
+  for (;;) {
+    int first = -1;
+    for (int i = 0; i < FACTORY_COUNT; i++) {
+      if (next[i] && (first == -1 || next[i] < next[first]))
+        first = i;
+    }
+    if (first == -1)
+      break;
+    const char *found = next[first];
+    add_binding_at(floor, found, names, seen);
+    next[first] = find_bytes(found + 1, end, TRANSLATOR_FACTORIES[first]);
   }
-  return 0;
 }
 
 /* Fills *names with every variable assigned via
    useTranslations() / getTranslations() / useFormatter()              */
 int collect_translator_names(const char *content, size_t size,
-                             DynamicArray *names) {
+                             StringVec *names) {
   if (!content || !names)
     return -1;
-  const char *end = content + size;
-  const char *pos = content;
-
-  while (pos < end) {
-    const char *use_t = strstr(pos, "useTranslations(");
-    const char *get_t = strstr(pos, "getTranslations(");
-    const char *use_f = strstr(pos, "useFormatter(");
-
-    const char *found = NULL;
-    if (use_t)
-      found = use_t;
-    if (get_t && (!found || get_t < found))
-      found = get_t;
-    if (use_f && (!found || use_f < found))
-      found = use_f;
-    if (!found)
-      break;
-
-    /* Expect:  const <NAME> = useTranslations(  */
-    const char *back = found - 1;
-    while (back > content && isspace((unsigned char)*back))
-      back--;
-    if (back <= content || *back != '=') {
-      pos = found + 1;
-      continue;
-    }
-    back--;
-    while (back > content && isspace((unsigned char)*back))
-      back--;
-
-    const char *name_end = back + 1;
-    while (back > content && (isalnum((unsigned char)*back) || *back == '_'))
-      back--;
-    const char *name_start = back + 1;
-    size_t name_len = (size_t)(name_end - name_start);
-
-    if (name_len >= 1 && name_len < 64) {
-      char buf[64];
-      strncpy(buf, name_start, name_len);
-      buf[name_len] = '\0';
-      /* Skip JS keywords that could appear before '=' */
-      if (strcmp(buf, "const") != 0 && strcmp(buf, "let") != 0 &&
-          strcmp(buf, "var") != 0) {
-        da_append(names, buf);
-      }
-    }
-    pos = found + 1;
-  }
+  collect_names_in(content, content, content + size, names, NULL);
   return 0;
 }
 
 /* =====================================================================
-   INTERNAL UTILITY
+   CONTENT CLASSIFIER
    ===================================================================== */
 
-/* Appends one result entry.
-   Format: "filepath:line:col: <TAG> text"                            */
-static void add_result(DynamicArray *results, const char *file_path,
-                       size_t line_num, size_t col, const char *tag,
-                       const char *text) {
-  char result[1024];
-  snprintf(result, sizeof(result), "%s:%zu:%zu: <%s> %s", file_path, line_num,
-           col, tag, text);
-  da_append(results, result);
-}
-
-/* Reads a "..." or '...' string starting at *pp (which must point at
-   the opening quote).  Fills val/val_len, advances *pp past the
-   closing quote.  Returns 1 on success, 0 on failure.               */
-static int read_quoted_string(const char **pp, char *val, size_t val_max,
-                              size_t *val_len_out) {
-  const char *p = *pp;
-  if (*p != '"' && *p != '\'')
-    return 0;
-  char q = *p++;
-  const char *start = p;
-  while (*p && *p != q) {
-    if (*p == '\\')
-      p++; /* skip escape character */
-    if (*p)
+/* Markers tools write at the top of the files they produce */
+static const char *GENERATED_MARKERS[] = {"@generated", "DO NOT EDIT",
+                                          "auto-generated", "autogenerated",
+                                          NULL};
+
+/* Length of the comments (and blank space) content starts with, up to
+   limit bytes - after a BOM or a #! line.  Only a banner in there
+   counts: "DO NOT EDIT" further down is a note to the next person.   */
+static size_t leading_comments(const char *content, size_t limit) {
+  const char *end = content + limit;
+  const char *p = content;
+  if (limit >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0)
+    p += 3;
+  if (end - p >= 2 && p[0] == '#' && p[1] == '!') {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    p = nl ? nl + 1 : end;
+  }
+  for (;;) {
+    while (p < end && isspace((unsigned char)*p))
       p++;
+    if (end - p < 2 || p[0] != '/' || (p[1] != '/' && p[1] != '*'))
+      break;
+    const char *close = p[1] == '/' ? memchr(p, '\n', (size_t)(end - p))
+                                    : find_bytes(p + 2, end, "*/");
+    p = close ? close + (p[1] == '/' ? 1 : 2) : end;
+  }
+  return (size_t)(p - content);
+}
+
+ContentKind classify_content(const char *content, size_t size) {
+  if (!content || size == 0)
+    return CONTENT_SOURCE;
+  size_t sample = size < CLASSIFY_SAMPLE ? size : CLASSIFY_SAMPLE;
+
+  /* Step 1: Text never holds a NUL byte */
+  if (memchr(content, '\0', sample))
+    return CONTENT_BINARY;
+
+  /* Step 2: Generator banners sit in the comments the file opens with */
+  size_t header =
+      leading_comments(content, sample < CLASSIFY_HEADER ? sample
+                                                         : CLASSIFY_HEADER);
+  for (int i = 0; GENERATED_MARKERS[i]; i++) {
+    if (find_bytes(content, content + header, GENERATED_MARKERS[i]))
+      return CONTENT_GENERATED;
+  }
+
+  /* Step 3: Bundlers and compilers end their output with a source map */
+  size_t tail = size < CLASSIFY_TAIL ? size : CLASSIFY_TAIL;
+  if (find_bytes(content + size - tail, content + size, "sourceMappingURL="))
+    return CONTENT_GENERATED;
+
+  /* Step 4: Minified code packs everything into a few huge lines.  Only
+     a full sample says anything - short files are never minified.    */
+  if (sample == CLASSIFY_SAMPLE) {
+    size_t lines = 1;
+    for (const char *nl = memchr(content, '\n', sample); nl;
+         nl = memchr(nl + 1, '\n', sample - (size_t)(nl + 1 - content)))
+      lines++;
+    if (sample / lines > MINIFIED_LINE_AVG)
+      return CONTENT_MINIFIED;
+  }
+  return CONTENT_SOURCE;
+}
+
+const char *content_kind_name(ContentKind kind) {
+  switch (kind) {
+  case CONTENT_BINARY:
+    return "binary";
+  case CONTENT_GENERATED:
+    return "generated";
+  case CONTENT_MINIFIED:
+    return "minified";
+  default:
+    return "source";
   }
-  if (!*p)
-    return 0; /* unclosed string */
-  size_t vlen = (size_t)(p - start);
-  if (vlen >= val_max)
-    return 0;
-  strncpy(val, start, vlen);
-  val[vlen] = '\0';
-  if (val_len_out)
-    *val_len_out = vlen;
-  *pp = p + 1; /* skip closing quote */
-  return 1;
 }
 
 /* =====================================================================
-   PATTERN 1 — JSX text nodes:  >plain text<
+   INTERNAL UTILITY
    ===================================================================== */
-int detect_jsx_text_nodes(const char *line, size_t line_num,
-                          const char *file_path, const DynamicArray *tnames,
-                          DynamicArray *results) {
-  (void)tnames; /* JSX text nodes need no translator-call check */
-  if (!line)
-    return 0;
-  size_t len = strlen(line);
-  int count = 0;
 
-  for (size_t i = 0; i < len; i++) {
-    if (line[i] != '>')
-      continue;
+/* Records a finding at tok, copying text[0..text_len).  The file is
+   registered with the first finding it has.                         */
+static void add_result(DetectState *d, const Token *tok, FindingKind kind,
+                       const char *label, size_t label_len, const char *text,
+                       size_t text_len) {
+  if (d->file < 0 && (d->file = findings_add_path(d->results,
+                                                  d->file_path)) < 0)
+    return;
+  findings_add(d->results, (uint32_t)d->file, tok->line, tok->col, kind,
+               label, label_len, text, text_len);
+}
 
-    /* Collect raw text until the next '<' */
-    size_t ts = i + 1, te = ts;
-    while (te < len && line[te] != '<')
-      te++;
-    if (te >= len)
-      continue;
+/* Returns 1 if tok is the word (or JSX name) w */
+static int word_is(const Token *tok, const char *w) {
+  return (tok->kind == TOK_WORD || tok->kind == TOK_JSX_NAME) &&
+         strlen(w) == tok->len && memcmp(tok->ptr, w, tok->len) == 0;
+}
 
-    /* Trim surrounding whitespace */
-    size_t a = ts, b = te;
-    while (a < b && isspace((unsigned char)line[a]))
-      a++;
-    while (b > a && isspace((unsigned char)line[b - 1]))
-      b--;
-    size_t tlen = b - a;
-    if (tlen < 3 || tlen >= 256)
-      continue;
+/* A lookup generated into word_tables.c */
+typedef int (*WordTable)(const char *s, size_t len);
 
-    char text[256];
-    strncpy(text, &line[a], tlen);
-    text[tlen] = '\0';
+/* Returns 1 if tok is a word (or JSX name) in table */
+static int word_in(const Token *tok, WordTable table) {
+  return (tok->kind == TOK_WORD || tok->kind == TOK_JSX_NAME) &&
+         table(tok->ptr, tok->len) >= 0;
+}
 
-    /* Skip if it contains code characters */
-    if (strchr(text, '{') || strchr(text, '}') || strchr(text, '=') ||
-        strchr(text, ';') || strchr(text, '(') || strchr(text, ')'))
-      continue;
+/* The n-th token before the current one, or NULL */
+static const Token *back(const DetectState *d, size_t n) {
+  return n < d->recent_count && n < DETECT_LOOKBEHIND ? &d->recent[n] : NULL;
+}
 
-    if (!looks_like_human_text(text, tlen))
-      continue;
+static int back_punct(const DetectState *d, size_t n, char c) {
+  const Token *t = back(d, n);
+  return t && t->kind == TOK_PUNCT && t->len == 1 && t->ptr[0] == c;
+}
 
-    /* Extract the opening tag name by scanning backwards */
-    char tag[64] = "jsx";
-    int j = (int)i - 1;
-    while (j >= 0 && line[j] != '<')
-      j--;
-    if (j >= 0) {
-      int tn_s = j + 1, tn_e = tn_s;
-      while (tn_e < (int)i && !isspace((unsigned char)line[tn_e]) &&
-             line[tn_e] != '>' && line[tn_e] != '/')
-        tn_e++;
-      int tnl = tn_e - tn_s;
-      if (tnl > 0 && tnl < 64) {
-        strncpy(tag, &line[tn_s], (size_t)tnl);
-        tag[tnl] = '\0';
-      }
-    }
-    /* Skip closing tags and HTML comment markers */
-    if (tag[0] == '/' || tag[0] == '!' || tag[0] == '\0')
-      continue;
+static int back_word(const DetectState *d, size_t n, const char *w) {
+  const Token *t = back(d, n);
+  return t && word_is(t, w);
+}
 
-    add_result(results, file_path, line_num, a + 1, tag, text);
-    count++;
-    i = te; /* jump past this text segment */
-  }
-  return count;
+static int back_word_in(const DetectState *d, size_t n, WordTable table) {
+  const Token *t = back(d, n);
+  return t && word_in(t, table);
 }
 
-/* =====================================================================
-   PATTERN 2 — String props:
-   placeholder / aria-label / title / alt / label / description / ...
-   ===================================================================== */
-static const char *FLAGGED_PROPS[] = {
-    "placeholder",  "aria-label",       "title", "alt",          "label",
-    "description",  "tooltip",          "hint",  "errorMessage", "helperText",
-    "emptyMessage", "noResultsMessage", NULL};
-
-int detect_string_props(const char *line, size_t line_num,
-                        const char *file_path, const DynamicArray *tnames,
-                        DynamicArray *results) {
-  if (!line)
+/* Returns 1 if the current string is the direct first argument of a
+   known translator call.  e.g. t("key") → safe; setError("msg") → not */
+static int in_translator_call(const ScanSession *session) {
+  const DetectState *d = &session->detect;
+  const Token *name = back(d, 1);
+  if (!back_punct(d, 0, '(') || !name || name->kind != TOK_WORD)
     return 0;
-  int count = 0;
-
-  for (int pi = 0; FLAGGED_PROPS[pi]; pi++) {
-    const char *prop = FLAGGED_PROPS[pi];
-    size_t prop_len = strlen(prop);
-    const char *p = line;
-
-    while ((p = strstr(p, prop)) != NULL) {
-      size_t prop_pos = (size_t)(p - line);
-      p += prop_len;
-
-      /* Word-boundary before prop: must not be alnum, '_', or '-'
-         (handles aria-label vs label, data-title vs title, etc.) */
-      if (prop_pos > 0) {
-        char before = line[prop_pos - 1];
-        if (isalnum((unsigned char)before) || before == '_' || before == '-')
-          continue;
-      }
-      /* Word-boundary after prop */
-      if (*p && isalnum((unsigned char)*p))
-        continue;
-
-      /* Skip whitespace then expect '=' */
-      const char *q = p;
-      while (*q && isspace((unsigned char)*q))
-        q++;
-      if (*q != '=')
-        continue;
-      q++;
-      while (*q && isspace((unsigned char)*q))
-        q++;
-
-      /* Value must be a raw string literal, not a JSX expression {} */
-      if (*q != '"' && *q != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(q - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&q, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      char tag[80];
-      snprintf(tag, sizeof(tag), "prop:%s", prop);
-      add_result(results, file_path, line_num, val_start_pos + 2, tag, val);
-      count++;
-    }
-  }
-  return count;
+  size_t unused;
+  return hm_get_span(session->tname_index, name->ptr, name->len, &unused);
 }
 
-/* =====================================================================
-   PATTERN 3 — toast.success/error/warning/info/message("literal")
-   ===================================================================== */
-static const char *TOAST_METHODS[] = {"success", "error",   "warning",
-                                      "info",    "message", NULL};
-
-int detect_toast_literals(const char *line, size_t line_num,
-                          const char *file_path, const DynamicArray *tnames,
-                          DynamicArray *results) {
-  if (!line)
-    return 0;
-  int count = 0;
-
-  for (int mi = 0; TOAST_METHODS[mi]; mi++) {
-    char pattern[32];
-    const char *p = line;
-    snprintf(pattern, sizeof(pattern), "toast.%s", TOAST_METHODS[mi]);
-
-    while ((p = strstr(p, pattern)) != NULL) {
-      p += strlen(pattern);
-      while (*p && isspace((unsigned char)*p))
-        p++;
-      if (*p != '(')
-        continue;
-      p++;
-      while (*p && isspace((unsigned char)*p))
-        p++;
-
-      /* First argument must be a raw string literal */
-      if (*p != '"' && *p != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(p - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      add_result(results, file_path, line_num, val_start_pos + 2, "toast", val);
-      count++;
-    }
+/* Reports text as a finding of kind (and label) if it looks like
+   human text.  Text wrapped over several lines reads as one line.   */
+static void report_text(ScanSession *session, const Token *tok,
+                        FindingKind kind, const char *label, size_t label_len,
+                        const char *text, size_t len) {
+  if (!memchr(text, '\n', len)) {
+    if (looks_like_human_text(text, len))
+      add_result(&session->detect, tok, kind, label, label_len, text, len);
+    return;
   }
-
-  /* toast({ message: "literal" }) */
-  const char *p = strstr(line, "toast(");
-  if (p) {
-    const char *msg = strstr(p, "message:");
-    if (msg) {
-      msg += strlen("message:");
-      while (*msg && isspace((unsigned char)*msg))
-        msg++;
-      if (*msg == '"' || *msg == '\'') {
-        size_t val_start_pos = (size_t)(msg - line);
-        char val[256];
-        size_t vlen;
-        if (read_quoted_string(&msg, val, sizeof(val), &vlen) &&
-            looks_like_human_text(val, vlen) &&
-            !is_inside_translator_call(line, val_start_pos + 1, tnames)) {
-          add_result(results, file_path, line_num, val_start_pos + 2, "toast",
-                     val);
-          count++;
-        }
-      }
+  char *flat = malloc(len);
+  if (!flat) {
+    fprintf(stderr, "Error: malloc failed for wrapped text\n");
+    return;
+  }
+  size_t n = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (text[i] == '\n') {
+      while (n > 0 && isspace((unsigned char)flat[n - 1]))
+        n--;
+      flat[n++] = ' ';
+      while (i + 1 < len && isspace((unsigned char)text[i + 1]))
+        i++;
+    } else {
+      flat[n++] = text[i];
     }
   }
-  return count;
+  if (looks_like_human_text(flat, n))
+    add_result(&session->detect, tok, kind, label, label_len, flat, n);
+  free(flat);
 }
 
+/* Reports the string tok unless it is too long, no human text, or
+   (with check_call) already translated                             */
+static void report_literal(ScanSession *session, const Token *tok,
+                           FindingKind kind, int check_call) {
+  if (tok->len > session->config.max_string_len)
+    return;
+  if (check_call && in_translator_call(session))
+    return;
+  report_text(session, tok, kind, NULL, 0, tok->ptr, tok->len);
+}
+
+/* DetectState.calls */
+enum { CALL_OTHER, CALL_TOAST, CALL_ZOD_TWO };
+
 /* =====================================================================
-   PATTERN 4 — setError / setWarning / setMessage / setState("literal")
+   PATTERN 1 — JSX text nodes:  >plain text<
    ===================================================================== */
-static const char *SET_FUNCS[] = {"setError",       "setWarning", "setMessage",
-                                  "setSuccess",     "setInfo",    "setTitle",
-                                  "setDescription", NULL};
-
-int detect_set_state_literals(const char *line, size_t line_num,
-                              const char *file_path, const DynamicArray *tnames,
-                              DynamicArray *results) {
-  if (!line)
-    return 0;
-  int count = 0;
-
-  for (int fi = 0; SET_FUNCS[fi]; fi++) {
-    const char *func = SET_FUNCS[fi];
-    size_t func_len = strlen(func);
-    const char *p = line;
-
-    while ((p = strstr(p, func)) != NULL) {
-      size_t func_pos = (size_t)(p - line);
-      p += func_len;
-
-      /* Word-boundary before name */
-      if (func_pos > 0 && (isalnum((unsigned char)line[func_pos - 1]) ||
-                           line[func_pos - 1] == '_'))
-        continue;
-
-      /* Must be followed by '(' */
-      const char *q = p;
-      while (*q && isspace((unsigned char)*q))
-        q++;
-      if (*q != '(')
-        continue;
-      q++;
-      while (*q && isspace((unsigned char)*q))
-        q++;
-
-      if (*q != '"' && *q != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(q - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&q, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      add_result(results, file_path, line_num, val_start_pos + 2, "set-state",
-                 val);
-      count++;
-    }
-  }
-  return count;
+static void detect_jsx_text(ScanSession *session, const Token *tok) {
+  const char *text = tok->ptr;
+  size_t tlen = tok->len;
+  if (tlen < 3 || tlen > session->config.max_string_len)
+    return;
+
+  /* Skip if it contains code characters */
+  if (memchr(text, '}', tlen) || memchr(text, '=', tlen) ||
+      memchr(text, ';', tlen) || memchr(text, '(', tlen) ||
+      memchr(text, ')', tlen))
+    return;
+
+  report_text(session, tok, FINDING_JSX_TEXT, tok->tag, strlen(tok->tag), text,
+              tlen);
 }
 
 /* =====================================================================
-   PATTERN 5 — Zod schema messages
-   message:"literal", required_error:"literal", .min(n,"literal"), ...
+   PATTERNS 2-7 — string literals, judged by the tokens before them
    ===================================================================== */
-static const char *ZOD_KEYS[] = {
-    "message:", "required_error:", "invalid_type_error:", NULL};
-/* Two-arg validators: first arg is a value (number/regex), second is message */
-static const char *ZOD_TWO_ARG_METHODS[] = {".min(", ".max(", ".length(",
-                                            ".refine(", NULL};
-/* Single-arg validators: first (and only) arg is the message */
-static const char *ZOD_ONE_ARG_METHODS[] = {
-    ".email(", ".url(", ".uuid(", ".cuid(", ".datetime(", ".ip(", NULL};
-
-int detect_zod_messages(const char *line, size_t line_num,
-                        const char *file_path, const DynamicArray *tnames,
-                        DynamicArray *results) {
-  if (!line)
-    return 0;
-  int count = 0;
-
-  /* message: "literal", required_error: "literal" */
-  for (int ki = 0; ZOD_KEYS[ki]; ki++) {
-    const char *p = line;
-    while ((p = strstr(p, ZOD_KEYS[ki])) != NULL) {
-      p += strlen(ZOD_KEYS[ki]);
-      while (*p && isspace((unsigned char)*p))
-        p++;
-      if (*p != '"' && *p != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(p - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      add_result(results, file_path, line_num, val_start_pos + 2, "zod", val);
-      count++;
-    }
+static void detect_string(ScanSession *session, const Token *tok) {
+  DetectState *d = &session->detect;
+
+  /* Pattern 2 — prop="literal" (a whole name: aria-label is not label) */
+  const Token *prop = back(d, 1);
+  if (back_punct(d, 0, '=') && prop && word_in(prop, flagged_prop_index) &&
+      tok->len <= session->config.max_string_len &&
+      !in_translator_call(session))
+    report_text(session, tok, FINDING_PROP, prop->ptr, prop->len, tok->ptr,
+                tok->len);
+
+  /* Pattern 3 — toast.success("literal"), toast({ message: "literal" }) */
+  if (back_punct(d, 0, '(') && back_word_in(d, 1, toast_method_index) &&
+      back_punct(d, 2, '.') && back_word(d, 3, "toast"))
+    report_literal(session, tok, FINDING_TOAST, 1);
+  if (d->toast_calls > 0 && back_punct(d, 0, ':') &&
+      back_word(d, 1, "message"))
+    report_literal(session, tok, FINDING_TOAST, 1);
+
+  /* Pattern 4 — setError("literal") */
+  if (back_punct(d, 0, '(') && back_word_in(d, 1, set_func_index))
+    report_literal(session, tok, FINDING_SET_STATE, 1);
+
+  /* Pattern 5 — message: "literal", .min(n, "literal"), .email("literal") */
+  if (back_punct(d, 0, ':') && back_word_in(d, 1, zod_key_index))
+    report_literal(session, tok, FINDING_ZOD, 1);
+  if (back_punct(d, 0, ',') && d->depth > 0 &&
+      d->depth <= DETECT_MAX_NESTING &&
+      d->calls[d->depth - 1] == CALL_ZOD_TWO && d->args[d->depth - 1] == 1)
+    report_literal(session, tok, FINDING_ZOD, 1);
+  if (back_punct(d, 0, '(') && back_word_in(d, 1, zod_one_arg_index) &&
+      back_punct(d, 2, '.'))
+    report_literal(session, tok, FINDING_ZOD, 1);
+
+  /* Pattern 6 — {"literal"}: only a closing '}' next decides */
+  if (back_punct(d, 0, '{')) {
+    d->literal = *tok;
+    d->has_literal = 1;
   }
 
-  /* .min(n, "literal")  /  .max(n, "literal")  etc. — message is 2nd arg */
-  for (int mi = 0; ZOD_TWO_ARG_METHODS[mi]; mi++) {
-    const char *p = line;
-    while ((p = strstr(p, ZOD_TWO_ARG_METHODS[mi])) != NULL) {
-      p += strlen(ZOD_TWO_ARG_METHODS[mi]);
-
-      /* Skip the first argument; stop at the comma */
-      int depth = 1;
-      int found_comma = 0;
-      while (*p && depth > 0) {
-        if (*p == '(')
-          depth++;
-        else if (*p == ')') {
-          depth--;
-          if (depth == 0)
-            break;
-        } else if (*p == ',' && depth == 1) {
-          found_comma = 1;
-          p++;
-          break;
-        }
-        p++;
-      }
-      if (!found_comma)
-        continue;
-
-      while (*p && isspace((unsigned char)*p))
-        p++;
-      if (*p != '"' && *p != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(p - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      add_result(results, file_path, line_num, val_start_pos + 2, "zod", val);
-      count++;
+  /* Pattern 7 — throw new Error("literal") */
+  if (back_punct(d, 0, '(') && back_word_in(d, 1, throw_class_index) &&
+      back_word(d, 2, "new") && back_word(d, 3, "throw"))
+    report_literal(session, tok, FINDING_THROW, 0);
+}
+
+/* Keeps track of the open ( [ { and of which call each one is */
+static void track_nesting(DetectState *d, const Token *tok) {
+  if (tok->kind != TOK_PUNCT || tok->len != 1)
+    return;
+  switch (tok->ptr[0]) {
+  case '(':
+  case '[':
+  case '{': {
+    int call = CALL_OTHER;
+    if (tok->ptr[0] == '(' && back_word(d, 0, "toast"))
+      call = CALL_TOAST;
+    else if (tok->ptr[0] == '(' && back_word_in(d, 0, zod_two_arg_index) &&
+             back_punct(d, 1, '.'))
+      call = CALL_ZOD_TWO;
+    if (d->depth < DETECT_MAX_NESTING) {
+      d->calls[d->depth] = (unsigned char)call;
+      d->args[d->depth] = 0;
+      if (call == CALL_TOAST)
+        d->toast_calls++;
     }
+    d->depth++;
+    break;
   }
+  case ')':
+  case ']':
+  case '}':
+    if (d->depth == 0)
+      break;
+    d->depth--;
+    if (d->depth < DETECT_MAX_NESTING && d->calls[d->depth] == CALL_TOAST)
+      d->toast_calls--;
+    break;
+  case ',':
+    if (d->depth > 0 && d->depth <= DETECT_MAX_NESTING &&
+        d->args[d->depth - 1] < 255)
+      d->args[d->depth - 1]++;
+    break;
+  }
+}
 
-  /* .email("literal")  /  .url("literal")  etc. — message is 1st arg */
-  for (int mi = 0; ZOD_ONE_ARG_METHODS[mi]; mi++) {
-    const char *p = line;
-    while ((p = strstr(p, ZOD_ONE_ARG_METHODS[mi])) != NULL) {
-      p += strlen(ZOD_ONE_ARG_METHODS[mi]);
-      while (*p && isspace((unsigned char)*p))
-        p++;
-      if (*p != '"' && *p != '\'')
-        continue;
-
-      size_t val_start_pos = (size_t)(p - line);
-      char val[256];
-      size_t vlen;
-      if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-        continue;
-      if (!looks_like_human_text(val, vlen))
-        continue;
-      if (is_inside_translator_call(line, val_start_pos + 1, tnames))
-        continue;
-
-      add_result(results, file_path, line_num, val_start_pos + 2, "zod", val);
-      count++;
-    }
+void detect_start(ScanSession *session, const char *file_path,
+                  FindingList *results) {
+  DetectState *d = &session->detect;
+  memset(d, 0, sizeof(DetectState));
+  d->file_path = file_path;
+  d->file = -1;
+  d->results = results;
+}
+
+void detect_token(ScanSession *session, const Token *tok) {
+  DetectState *d = &session->detect;
+
+  /* Step 1: A {"literal" from the token before is reported if closed */
+  if (d->has_literal) {
+    if (tok->kind == TOK_PUNCT && tok->len == 1 && tok->ptr[0] == '}')
+      report_literal(session, &d->literal, FINDING_JSX_EXPR, 0);
+    d->has_literal = 0;
   }
-  return count;
+
+  /* Step 2: The patterns */
+  if (tok->kind == TOK_STRING)
+    detect_string(session, tok);
+  else if (tok->kind == TOK_JSX_TEXT)
+    detect_jsx_text(session, tok);
+
+  /* Step 3: Remember the token for the ones after it */
+  track_nesting(d, tok);
+  memmove(&d->recent[1], &d->recent[0],
+          (DETECT_LOOKBEHIND - 1) * sizeof(Token));
+  d->recent[0] = *tok;
+  d->recent_count++;
 }
 
 /* =====================================================================
-   PATTERN 6 — {"literal"}  string literal in JSX expression block
+   MAIN SCANNER — lexes a file and hands every token to the detectors
    ===================================================================== */
-int detect_jsx_expr_strings(const char *line, size_t line_num,
-                            const char *file_path, const DynamicArray *tnames,
-                            DynamicArray *results) {
-  if (!line)
-    return 0;
-  size_t len = strlen(line);
-  int count = 0;
 
-  for (size_t i = 0; i < len; i++) {
-    if (line[i] != '{')
-      continue;
+/* .ts files hold no JSX, so a '<' there is always a comparison or a
+   type argument                                                     */
+static int allows_jsx(const char *file_path) {
+  size_t len = strlen(file_path);
+  return !(len >= 3 && strcmp(file_path + len - 3, ".ts") == 0);
+}
 
-    /* Skip whitespace inside the brace */
-    size_t j = i + 1;
-    while (j < len && isspace((unsigned char)line[j]))
-      j++;
-    if (j >= len || (line[j] != '"' && line[j] != '\''))
-      continue;
+/* Lexes [content, content + size), whose first line is first_line,
+   carrying on from the lexer state the previous buffer left.  The
+   buffer is never read past size (it may be an unterminated mapping
+   or a streamed window).                                           */
+static int scan_tokens(ScanSession *session, const char *content, size_t size,
+                       size_t first_line) {
+  if (byte_index_build(&session->index, content, size,
+                       lexer_index_classes()) == -1)
+    return -1;
+  lexer_feed(&session->lexer, content, size, first_line, &session->index);
 
-    size_t val_start_pos = j;
-    const char *p = &line[j];
-    char val[256];
-    size_t vlen;
-    if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-      continue;
+  /* Tokens of the last buffer point into memory that is gone */
+  session->detect.recent_count = 0;
+  session->detect.has_literal = 0;
 
-    /* A closing '}' must follow (with optional whitespace) */
-    while (*p && isspace((unsigned char)*p))
-      p++;
-    if (*p != '}')
+  Token tok;
+  while (lexer_next(&session->lexer, &tok))
+    detect_token(session, &tok);
+  return 0;
+}
+
+/* =====================================================================
+   SPLIT SCANNING — one big buffer lexed on several threads
+   A piece may only start after a line that ends a top-level statement
+   with ';' or '}'.  Each piece is lexed as if the file began there;
+   once all are done, the state the piece before really ended in is
+   checked against that guess.  Where the guess was wrong, everything
+   from the last good piece on is lexed again in one go, so the
+   findings are always those of a single pass.
+   ===================================================================== */
+
+typedef struct {
+  ScanSession part;     /* Own lexer, index and detectors */
+  const char *start;
+  size_t size;
+  char after;           /* Punctuation the cut follows, '\0' = none */
+  FindingList *results; /* Lines counted from the piece's first line */
+  size_t lines;         /* Newlines in the piece */
+  int status;
+  pthread_t thread;
+  int threaded;
+} ScanPiece;
+
+/* Returns 1 if the detectors carry nothing over from before a cut
+   made right after the punctuation last                           */
+static int detect_at_top_level(const DetectState *d, char last) {
+  return d->depth == 0 && d->toast_calls == 0 && !d->has_literal &&
+         d->recent_count > 0 && d->recent[0].kind == TOK_PUNCT &&
+         d->recent[0].len == 1 && d->recent[0].ptr[0] == last;
+}
+
+/* Finds the first line in [from, to) that starts unindented right
+   after a line ending in ';' or '}'.  Returns its offset and sets
+   *after, or returns 0 if there is none.                           */
+static size_t find_cut(const char *content, size_t from, size_t to,
+                       char *after) {
+  for (const char *nl = memchr(content + from, '\n', to - from); nl;
+       nl = memchr(nl + 1, '\n', (size_t)(content + to - nl - 1))) {
+    size_t next = (size_t)(nl + 1 - content);
+    if (next >= to || isspace((unsigned char)content[next]) ||
+        content[next] == '}' || content[next] == ')')
       continue;
+    const char *p = nl;
+    while (p > content + from && (p[-1] == '\r' || p[-1] == ' ' ||
+                                  p[-1] == '\t'))
+      p--;
+    if (p > content + from && (p[-1] == ';' || p[-1] == '}')) {
+      *after = p[-1];
+      return next;
+    }
+  }
+  return 0;
+}
 
-    if (!looks_like_human_text(val, vlen))
+static void *scan_piece_main(void *arg) {
+  ScanPiece *piece = arg;
+  piece->status = scan_tokens(&piece->part, piece->start, piece->size, 1);
+  if (piece->status == 0)
+    piece->lines = byte_index_count(&piece->part.index, BS_NEWLINE);
+  return NULL;
+}
+
+/* Cuts [content, content + size) into up to max pieces.  Returns the
+   number of pieces, each with start, size and after filled in.      */
+static int cut_pieces(const char *content, size_t size, int max,
+                      ScanPiece *pieces) {
+  int count = 1;
+  pieces[0].start = content;
+  pieces[0].after = '\0';
+  for (int k = 1; k < max; k++) {
+    size_t target = size / (size_t)max * (size_t)k;
+    size_t prev = (size_t)(pieces[count - 1].start - content);
+    if (target <= prev)
       continue;
-    if (is_inside_translator_call(line, val_start_pos + 1, tnames))
+    size_t limit = size - target > SPLIT_SEARCH ? target + SPLIT_SEARCH : size;
+    char after;
+    size_t cut = find_cut(content, target, limit, &after);
+    if (cut == 0)
       continue;
-
-    add_result(results, file_path, line_num, val_start_pos + 2, "jsx-expr",
-               val);
+    pieces[count].start = content + cut;
+    pieces[count].after = after;
     count++;
-    i = (size_t)(p - line);
+  }
+  for (int k = 0; k < count; k++) {
+    const char *end = k + 1 < count ? pieces[k + 1].start : content + size;
+    pieces[k].size = (size_t)(end - pieces[k].start);
   }
   return count;
 }
 
-/* =====================================================================
-   PATTERN 7 — throw new Error("literal")
-   ===================================================================== */
-static const char *THROW_PATTERNS[] = {
-    "throw new Error(", "throw new TypeError(", "throw new RangeError(", NULL};
-
-int detect_throw_errors(const char *line, size_t line_num,
-                        const char *file_path, DynamicArray *results) {
-  if (!line)
+/* Adds the findings of piece to the file's, moved down by line_base */
+static int merge_piece(ScanSession *session, ScanPiece *piece,
+                       size_t line_base) {
+  DetectState *d = &session->detect;
+  FindingList *found = piece->results;
+  if (found->size == 0)
     return 0;
-  int count = 0;
+  if (d->file < 0 &&
+      (d->file = findings_add_path(d->results, d->file_path)) < 0)
+    return -1;
+  for (size_t i = 0; i < found->size; i++)
+    found->items[i].line += (uint32_t)line_base;
+  return findings_copy(d->results, (uint32_t)d->file, found, 0, found->size);
+}
 
-  for (int pi = 0; THROW_PATTERNS[pi]; pi++) {
-    const char *p = strstr(line, THROW_PATTERNS[pi]);
-    if (!p)
-      continue;
-    p += strlen(THROW_PATTERNS[pi]);
-    while (*p && isspace((unsigned char)*p))
-      p++;
-    if (*p != '"' && *p != '\'')
-      continue;
+/* Takes up to want threads from the shared idle count; returns how
+   many it got                                                       */
+static int borrow_idle(int *idle, int want) {
+  int have = __atomic_load_n(idle, __ATOMIC_RELAXED);
+  while (have > 0) {
+    int take = have < want ? have : want;
+    if (__atomic_compare_exchange_n(idle, &have, have - take, 1,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return take;
+  }
+  return 0;
+}
 
-    size_t val_start_pos = (size_t)(p - line);
-    char val[256];
-    size_t vlen;
-    if (!read_quoted_string(&p, val, sizeof(val), &vlen))
-      continue;
-    if (!looks_like_human_text(val, vlen))
-      continue;
+/* scan_tokens() over several threads, carrying on from (and leaving)
+   the session's lexer and detector state like one call would        */
+static int scan_tokens_split(ScanSession *session, const char *content,
+                             size_t size, size_t first_line) {
+  /* Step 1: Borrow idle threads, then cut the buffer at top-level
+     lines, one piece for this thread and one per borrowed thread   */
+  int max = session->config.split_threads;
+  if ((size_t)max > size / SPLIT_MIN_PIECE)
+    max = (int)(size / SPLIT_MIN_PIECE);
+  int *idle = session->config.split_idle;
+  int borrowed = idle && max > 1 ? borrow_idle(idle, max - 1) : 0;
+  if (idle)
+    max = borrowed + 1;
+  ScanPiece *pieces = max > 1 ? calloc((size_t)max, sizeof(ScanPiece)) : NULL;
+  int count = pieces ? cut_pieces(content, size, max, pieces) : 1;
+  if (count < 2) {
+    free(pieces);
+    if (borrowed > 0)
+      __atomic_add_fetch(idle, borrowed, __ATOMIC_RELEASE);
+    return scan_tokens(session, content, size, first_line);
+  }
 
-    add_result(results, file_path, line_num, val_start_pos + 2, "throw", val);
-    count++;
+  /* Step 2: Lex every piece on its own; the first one carries on from
+     the session's state, the others guess they start a file         */
+  int status = 0;
+  for (int k = 0; k < count; k++) {
+    ScanPiece *piece = &pieces[k];
+    piece->part.config = session->config;
+    piece->part.tname_index = session->tname_index;
+    piece->results = findings_create();
+    if (!piece->results) {
+      status = -1;
+      break;
+    }
+    if (k == 0) {
+      piece->part.lexer = session->lexer;
+      piece->part.detect = session->detect;
+    } else {
+      lexer_start_after(&piece->part.lexer, session->lexer.allow_jsx,
+                        piece->after);
+      detect_start(&piece->part, session->detect.file_path, NULL);
+    }
+    piece->part.detect.file = -1;
+    piece->part.detect.results = piece->results;
+    piece->threaded = k > 0 && pthread_create(&piece->thread, NULL,
+                                              scan_piece_main, piece) == 0;
   }
-  return count;
+  for (int k = 0; status == 0 && k < count; k++) {
+    if (!pieces[k].threaded)
+      scan_piece_main(&pieces[k]);
+  }
+  for (int k = 0; k < count; k++) {
+    if (pieces[k].threaded)
+      pthread_join(pieces[k].thread, NULL);
+    if (pieces[k].status == -1)
+      status = -1;
+  }
+  if (borrowed > 0)
+    __atomic_add_fetch(idle, borrowed, __ATOMIC_RELEASE);
+
+  /* Step 3: Keep the pieces whose guess held, in order, with their
+     lines moved down by the newlines before them                    */
+  int good = 1;
+  while (status == 0 && good < count &&
+         lexer_at_top_level(&pieces[good - 1].part.lexer,
+                            pieces[good].after) &&
+         detect_at_top_level(&pieces[good - 1].part.detect,
+                             pieces[good].after))
+    good++;
+  int kept = good < count ? good - 1 : count;
+  size_t line_base = first_line - 1;
+  for (int k = 0; status == 0 && k < kept; k++) {
+    if (merge_piece(session, &pieces[k], line_base) == -1)
+      status = -1;
+    line_base += pieces[k].lines;
+  }
+
+  /* Step 4: Take over the state the last kept piece ended in, or lex
+     the rest again from where the piece after it started            */
+  if (status == 0 && kept == count) {
+    session->lexer = pieces[count - 1].part.lexer;
+    DetectState d = session->detect;
+    session->detect = pieces[count - 1].part.detect;
+    session->detect.file_path = d.file_path;
+    session->detect.file = d.file;
+    session->detect.results = d.results;
+  } else if (status == 0) {
+    ScanPiece *redo = &pieces[kept];
+    if (kept > 0) {
+      lexer_start_after(&session->lexer, session->lexer.allow_jsx,
+                        redo->after);
+      DetectState d = session->detect;
+      detect_start(session, d.file_path, d.results);
+      session->detect.file = d.file;
+    }
+    status = scan_tokens(session, redo->start,
+                         (size_t)(content + size - redo->start),
+                         line_base + 1);
+  }
+
+  for (int k = 0; k < count; k++) {
+    byte_index_free(&pieces[k].part.index);
+    findings_free(pieces[k].results);
+  }
+  free(pieces);
+  return status;
+}
+
+/* Lexes one buffer, split over threads when it is big enough */
+static int scan_buffer(ScanSession *session, const char *content, size_t size,
+                       size_t first_line) {
+  if (session->config.split_threads > 1 && size >= 2 * SPLIT_MIN_PIECE)
+    return scan_tokens_split(session, content, size, first_line);
+  return scan_tokens(session, content, size, first_line);
+}
+
+/* Runs every detector over buffer; session->tnames must arrive empty */
+static int scan_content(ScanSession *session, const char *file_path,
+                        const FileBuffer *buffer, FindingList *results) {
+  /* Phase 0: leave generated, minified and binary files alone */
+  ContentKind kind = classify_content(buffer->content, buffer->size);
+  if (kind != CONTENT_SOURCE)
+    return (int)kind;
+
+  /* Phase 1: collect all translator variable names declared in this file */
+  collect_names_in(buffer->content, buffer->content,
+                   buffer->content + buffer->size, session->tnames,
+                   session->tname_index);
+
+  /* Phase 2: one pass of the lexer */
+  lexer_start(&session->lexer, allows_jsx(file_path));
+  detect_start(session, file_path, results);
+  return scan_buffer(session, buffer->content, buffer->size, 1);
+}
+
+/* Same two phases over a file read one window at a time: the first
+   pass only collects translator names (a name may be declared after
+   its first use), the second runs the detectors                      */
+static int scan_stream(ScanSession *session, const char *file_path,
+                       FileStream *stream, FindingList *results) {
+  FileWindow view;
+  int status;
+
+  /* Phase 0: classify the file by its first window */
+  status = fs_next(stream, &view);
+  if (status == 1) {
+    ContentKind kind = classify_content(view.content, view.size);
+    if (kind != CONTENT_SOURCE)
+      return (int)kind;
+  }
+  if (status == -1 || fs_rewind(stream) == -1)
+    return -1;
+
+  /* Phase 1: translator names, looking back into the kept context so a
+     declaration split across two windows is still found              */
+  while ((status = fs_next(stream, &view)) == 1)
+    collect_names_in(view.content - view.context, view.content,
+                     view.content + view.size, session->tnames,
+                     session->tname_index);
+  if (status == -1 || fs_rewind(stream) == -1)
+    return -1;
+
+  /* Phase 2: windows end on a newline; the lexer state carries
+     comments, attribute strings and JSX nesting across them         */
+  lexer_start(&session->lexer, allows_jsx(file_path));
+  detect_start(session, file_path, results);
+  while ((status = fs_next(stream, &view)) == 1) {
+    if (scan_buffer(session, view.content, view.size, view.first_line) == -1)
+      return -1;
+  }
+  return status;
 }
 
-/* =====================================================================
-   MAIN SCANNER — drives all detectors over a file line by line
-   ===================================================================== */
 int scan_file_for_untranslated(const char *file_path, const FileBuffer *buffer,
                                const ParserConfig *config,
-                               DynamicArray *results) {
+                               FindingList *results) {
   if (!file_path || !buffer || !buffer->content || !config || !results) {
     fprintf(stderr, "Error: Invalid inputs to scan_file_for_untranslated\n");
     return -1;
   }
 
-  /* Phase 1: collect all translator variable names declared in this file */
-  DynamicArray *tnames = da_create();
-  if (!tnames)
+  ScanSession *session = scan_session_create();
+  if (!session)
     return -1;
-  collect_translator_names(buffer->content, buffer->size, tnames);
-
-  /* Phase 2: process line by line */
-  const char *content = buffer->content;
-  size_t size = buffer->size;
-  size_t line_num = 1;
-  size_t i = 0;
-
-  while (i < size) {
-    size_t line_start = i;
-    while (i < size && content[i] != '\n')
-      i++;
-    size_t line_end = i;
-    if (i < size)
-      i++; /* skip the newline */
-
-    size_t line_len = line_end - line_start;
-    if (line_len >= MAX_LINE_LENGTH) {
-      line_num++;
-      continue;
-    }
+  session->config = *config;
+  int status = scan_content(session, file_path, buffer, results);
+  scan_session_free(session);
+  return status;
+}
 
-    char line_buf[MAX_LINE_LENGTH];
-    strncpy(line_buf, &content[line_start], line_len);
-    line_buf[line_len] = '\0';
-
-    if (!is_safe_line(line_buf)) {
-      detect_jsx_text_nodes(line_buf, line_num, file_path, tnames, results);
-      detect_string_props(line_buf, line_num, file_path, tnames, results);
-      detect_toast_literals(line_buf, line_num, file_path, tnames, results);
-      detect_set_state_literals(line_buf, line_num, file_path, tnames, results);
-      detect_zod_messages(line_buf, line_num, file_path, tnames, results);
-      detect_jsx_expr_strings(line_buf, line_num, file_path, tnames, results);
-      detect_throw_errors(line_buf, line_num, file_path, results);
-    }
-    line_num++;
+int scan_session_file(ScanSession *session, const char *file_path,
+                      const FileBuffer *buffer, FindingList *results) {
+  if (!session || !file_path || !buffer || !buffer->content || !results) {
+    fprintf(stderr, "Error: Invalid inputs to scan_session_file\n");
+    return -1;
   }
 
-  da_free(tnames);
-  return 0;
+  sv_clear(session->tnames);
+  hm_clear(session->tname_index);
+  int status = scan_content(session, file_path, buffer, results);
+  sv_clear(session->tnames);
+  hm_clear(session->tname_index);
+  return status;
+}
+
+int scan_session_stream(ScanSession *session, const char *file_path,
+                        FindingList *results) {
+  if (!session || !file_path || !results) {
+    fprintf(stderr, "Error: Invalid inputs to scan_session_stream\n");
+    return -1;
+  }
+
+  FileStream *stream = fs_open(file_path, STREAM_WINDOW);
+  if (!stream)
+    return -1;
+  sv_clear(session->tnames);
+  hm_clear(session->tname_index);
+  int status = scan_stream(session, file_path, stream, results);
+  sv_clear(session->tnames);
+  hm_clear(session->tname_index);
+  fs_close(stream);
+  return status;
 }
@@ -1,18 +1,67 @@
 #ifndef TEXT_PARSER_H
 #define TEXT_PARSER_H
 
+#include "byte_scan.h"
 #include "data_structs.h"
 #include "file_reader.h"
+#include "findings.h"
+#include "lexer.h"
+
+/* Bump whenever a detector changes what it reports: saved snapshots of
+   findings from older versions are then discarded                    */
+#define PARSER_VERSION "7"
 
 /* Parser configuration */
 typedef struct {
-    size_t max_string_len;  /* Skip strings longer than this */
+    size_t max_string_len;  /* Skip strings and JSX text longer than this */
+    int    split_threads;   /* Threads one big buffer may be lexed on,
+                               in pieces cut at top-level lines (1 = never
+                               split)                                   */
+    int   *split_idle;      /* Threads of the run with nothing to do,
+                               shared by every session: a split borrows
+                               its extra threads from here and gives
+                               them back (NULL = split_threads alone)  */
 } ParserConfig;
 
+#define DETECT_LOOKBEHIND 4    /* Tokens the detectors look back over */
+#define DETECT_MAX_NESTING 64  /* ( [ { whose callee is remembered     */
+
+/* What the detectors remember of the token stream */
+typedef struct {
+    const char   *file_path;
+    long          file;      /* Index in results->paths, -1 until the
+                                first finding                          */
+    FindingList  *results;
+    Token         recent[DETECT_LOOKBEHIND]; /* recent[0] = last token  */
+    size_t        recent_count;              /* Since the buffer began  */
+    unsigned char calls[DETECT_MAX_NESTING]; /* Callee of each open ( [ { */
+    unsigned char args[DETECT_MAX_NESTING];  /* ...commas seen in it    */
+    int           depth;                     /* Open ( [ { */
+    int           toast_calls;               /* Open toast( calls */
+    int           has_literal;               /* {"literal" waiting for } */
+    Token         literal;
+} DetectState;
+
+/* Everything one scanning thread reuses from file to file instead of
+   allocating it again for each one                                   */
+typedef struct {
+    ParserConfig  config;
+    FileBuffer   *buffer;   /* Read buffer for callers that read files */
+    StringVec    *tnames;   /* Translator names of the current file    */
+    HashMap      *tname_index; /* ...each name (borrowed) for lookups  */
+    ByteIndex     index;    /* Bitmaps of the buffer being lexed       */
+    Lexer         lexer;
+    DetectState   detect;
+} ScanSession;
+
 /* ── Configuration ──────────────────────────────────────────────────── */
 ParserConfig *parser_config_create(void);
 void          parser_config_free(ParserConfig *config);
 
+/* ── Scan sessions (one per thread, never shared) ───────────────────── */
+ScanSession *scan_session_create(void);
+void         scan_session_free(ScanSession *session);
+
 /* ── Helpers ────────────────────────────────────────────────────────── */
 
 /* Returns 1 if text is empty or only whitespace */
@@ -22,70 +71,72 @@ int is_empty_or_whitespace(const char *text);
    at least 3 chars, starts with a letter, and has a space OR uppercase */
 int looks_like_human_text(const char *str, size_t len);
 
-/* Returns 1 if the entire line should be skipped:
-   comments, next-intl imports, "use client"/"use server", translator init */
-int is_safe_line(const char *line);
-
-/* Returns 1 if the string at str_start in *line is the direct first
-   argument of a known translator call like t("key") or errors("key") */
-int is_inside_translator_call(const char *line, size_t str_start,
-                               const DynamicArray *tnames);
-
 /* Scans file content and fills *names with every variable name that was
-   assigned via useTranslations() / getTranslations() / useFormatter() */
+   assigned via useTranslations() / getTranslations() / useFormatter(),
+   including the await and destructuring forms.  Linear in size.      */
 int collect_translator_names(const char *content, size_t size,
-                              DynamicArray *names);
+                              StringVec *names);
+
+/* ── Content classifier ─────────────────────────────────────────────── */
+
+/* What a file holds, judged from a small sample of it */
+typedef enum {
+    CONTENT_SOURCE = 0,  /* Hand-written code: run the detectors */
+    CONTENT_BINARY,      /* NUL bytes in the sample                */
+    CONTENT_GENERATED,   /* @generated / DO NOT EDIT in the leading
+                            comments, or a sourceMappingURL trailer */
+    CONTENT_MINIFIED     /* Sample lines far longer than any source */
+} ContentKind;
+
+/* Looks at the first 4KB (and the last few hundred bytes) of content
+   only, so it costs the same whatever the file size                 */
+ContentKind classify_content(const char *content, size_t size);
+
+/* "binary", "generated", "minified" (or "source") */
+const char *content_kind_name(ContentKind kind);
 
 /* ── Pattern detectors (one per category) ───────────────────────────── */
-/*  Each returns the number of findings added to *results.
-    Result format: "filepath:line:col: <TAG> matched_text"            */
-
-/* Pattern 1 — >plain text< between JSX tags */
-int detect_jsx_text_nodes(const char *line, size_t line_num,
-                           const char *file_path,
-                           const DynamicArray *tnames,
-                           DynamicArray *results);
-
-/* Pattern 2 — placeholder/title/aria-label/alt/label/description="literal" */
-int detect_string_props(const char *line, size_t line_num,
-                        const char *file_path,
-                        const DynamicArray *tnames,
-                        DynamicArray *results);
-
-/* Pattern 3 — toast.success/error/warning/info/message("literal") */
-int detect_toast_literals(const char *line, size_t line_num,
-                          const char *file_path,
-                          const DynamicArray *tnames,
-                          DynamicArray *results);
-
-/* Pattern 4 — setError/setWarning/setMessage/setState("literal") */
-int detect_set_state_literals(const char *line, size_t line_num,
-                               const char *file_path,
-                               const DynamicArray *tnames,
-                               DynamicArray *results);
-
-/* Pattern 5 — Zod: message:"literal", required_error:"literal",
-                    .min(n,"literal"), .max(n,"literal"), etc. */
-int detect_zod_messages(const char *line, size_t line_num,
-                        const char *file_path,
-                        const DynamicArray *tnames,
-                        DynamicArray *results);
-
-/* Pattern 6 — {"literal"} string literal in JSX expression block */
-int detect_jsx_expr_strings(const char *line, size_t line_num,
-                             const char *file_path,
-                             const DynamicArray *tnames,
-                             DynamicArray *results);
-
-/* Pattern 7 — throw new Error("literal") */
-int detect_throw_errors(const char *line, size_t line_num,
-                        const char *file_path,
-                        DynamicArray *results);
+
+/*  The detectors consume the lexer's tokens - each byte of a file is
+    classified once, and a pattern split across lines is still seen.
+    Each finding is appended to a FindingList as a typed record.
+
+    Pattern 1 — >plain text< between JSX tags
+    Pattern 2 — placeholder/title/aria-label/alt/label/description="literal"
+    Pattern 3 — toast.success/error/warning/info/message("literal"),
+                toast({ message: "literal" })
+    Pattern 4 — setError/setWarning/setMessage/setState("literal")
+    Pattern 5 — Zod: message:"literal", required_error:"literal",
+                     .min(n,"literal"), .max(n,"literal"), etc.
+    Pattern 6 — {"literal"} string literal in JSX expression block
+    Pattern 7 — throw new Error("literal") (never checks translator calls)
+
+    Strings passed straight to a translator, as in t("key"), are never
+    reported (except by pattern 7).                                    */
+
+/* Gets session->detect ready for a file; findings go to results */
+void detect_start(ScanSession *session, const char *file_path,
+                  FindingList *results);
+
+/* Runs every pattern over the next token of the file */
+void detect_token(ScanSession *session, const Token *tok);
 
 /* ── Main entry point ───────────────────────────────────────────────── */
+/* Each returns 0 once the file was scanned, -1 on error, or the
+   ContentKind of a file skipped as not being hand-written source    */
 int scan_file_for_untranslated(const char *file_path,
                                const FileBuffer *buffer,
                                const ParserConfig *config,
-                               DynamicArray *results);
+                               FindingList *results);
+
+/* Same as above, reusing the tables of session */
+int scan_session_file(ScanSession *session, const char *file_path,
+                      const FileBuffer *buffer, FindingList *results);
+
+/* Scans a file too big to hold at once (over STREAM_THRESHOLD), reading
+   it STREAM_WINDOW bytes at a time (more for a longer line, up to
+   STREAM_MAX_LINE; lines longer still are skipped)                   */
+int scan_session_stream(ScanSession *session, const char *file_path,
+                        FindingList *results);
 
 #endif /* TEXT_PARSER_H */
\ No newline at end of file
@@ -0,0 +1,285 @@
+/* Generates word_tables.c and word_tables.h from word_tables.txt: one
+   perfect-hash lookup per word list, so checking a word costs one hash
+   and one memcmp() however long the list grows.
+
+   Build and run from the repository root:
+     gcc -Wall -Wextra -std=c99 -o gen_word_tables tools/gen_word_tables.c
+     ./gen_word_tables tools/word_tables.txt .                           */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TABLES 32
+#define MAX_WORDS 1024
+#define MAX_LINE 512
+#define SEED_TRIES 1000000
+
+typedef struct {
+  char name[64];
+  char description[MAX_LINE];
+  char *words[MAX_WORDS];
+  size_t count;
+  uint32_t seed;
+  size_t size;  /* Slots, a power of two */
+  short *slots; /* Word index of each slot, or -1 */
+} Table;
+
+static Table tables[MAX_TABLES];
+static size_t table_count = 0;
+
+/* Must stay the same as WORD_HASH below, which word_tables.c runs */
+static uint32_t word_hash(const char *s, size_t len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+static const char *WORD_HASH =
+    "static uint32_t word_hash(const char *s, size_t len, uint32_t seed) {\n"
+    "  uint32_t h = 2166136261u ^ seed;\n"
+    "  for (size_t i = 0; i < len; i++) {\n"
+    "    h ^= (unsigned char)s[i];\n"
+    "    h *= 16777619u;\n"
+    "  }\n"
+    "  return h ^ (h >> 15);\n"
+    "}\n";
+
+/* =====================================================================
+   INPUT
+   ===================================================================== */
+
+static char *trim(char *s) {
+  while (isspace((unsigned char)*s))
+    s++;
+  size_t len = strlen(s);
+  while (len > 0 && isspace((unsigned char)s[len - 1]))
+    s[--len] = '\0';
+  return s;
+}
+
+static int read_tables(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Error: cannot open %s\n", path);
+    return -1;
+  }
+  char line[MAX_LINE];
+  int line_num = 0;
+  Table *table = NULL;
+  while (fgets(line, sizeof(line), f)) {
+    line_num++;
+    char *s = trim(line);
+    if (*s == '\0' || *s == '#')
+      continue;
+
+    /* [name] description */
+    if (*s == '[') {
+      char *close = strchr(s, ']');
+      if (!close || close - s - 1 <= 0 || close - s - 1 >= 64 ||
+          table_count == MAX_TABLES) {
+        fprintf(stderr, "Error: %s:%d: bad table header\n", path, line_num);
+        fclose(f);
+        return -1;
+      }
+      table = &tables[table_count++];
+      memcpy(table->name, s + 1, (size_t)(close - s - 1));
+      table->name[close - s - 1] = '\0';
+      snprintf(table->description, sizeof(table->description), "%s",
+               trim(close + 1));
+      continue;
+    }
+
+    if (!table || table->count == MAX_WORDS || strlen(s) > 255) {
+      fprintf(stderr, "Error: %s:%d: word outside a table or too long\n",
+              path, line_num);
+      fclose(f);
+      return -1;
+    }
+    for (size_t i = 0; i < table->count; i++) {
+      if (strcmp(table->words[i], s) == 0) {
+        fprintf(stderr, "Error: %s:%d: '%s' listed twice in [%s]\n", path,
+                line_num, s, table->name);
+        fclose(f);
+        return -1;
+      }
+    }
+    table->words[table->count] = malloc(strlen(s) + 1);
+    if (!table->words[table->count]) {
+      fclose(f);
+      return -1;
+    }
+    strcpy(table->words[table->count++], s);
+  }
+  fclose(f);
+  return 0;
+}
+
+/* =====================================================================
+   PERFECT HASHING
+   ===================================================================== */
+
+/* Finds a seed that sends every word to its own slot, doubling the
+   table (from twice the word count) until one is found             */
+static int place_words(Table *table) {
+  size_t size = 4;
+  while (size < table->count * 2)
+    size *= 2;
+  for (;; size *= 2) {
+    table->slots = realloc(table->slots, size * sizeof(short));
+    if (!table->slots)
+      return -1;
+    for (uint32_t seed = 1; seed < SEED_TRIES; seed++) {
+      int clash = 0;
+      for (size_t i = 0; i < size; i++)
+        table->slots[i] = -1;
+      for (size_t w = 0; w < table->count && !clash; w++) {
+        size_t slot = word_hash(table->words[w], strlen(table->words[w]),
+                                seed) & (size - 1);
+        if (table->slots[slot] >= 0)
+          clash = 1;
+        else
+          table->slots[slot] = (short)w;
+      }
+      if (!clash) {
+        table->seed = seed;
+        table->size = size;
+        return 0;
+      }
+    }
+  }
+}
+
+/* =====================================================================
+   OUTPUT
+   ===================================================================== */
+
+static const char *BANNER =
+    "/* Generated by tools/gen_word_tables.c from tools/word_tables.txt.\n"
+    "   Change the list there and regenerate rather than editing this.  */\n";
+
+static void upper(const char *name, char *out) {
+  for (; *name; name++)
+    *out++ = (char)toupper((unsigned char)*name);
+  *out = '\0';
+}
+
+static int write_header(const char *dir) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/word_tables.h", dir);
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Error: cannot write %s\n", path);
+    return -1;
+  }
+  fprintf(f, "#ifndef WORD_TABLES_H\n#define WORD_TABLES_H\n\n");
+  fprintf(f, "%s\n#include <stddef.h>\n\n", BANNER);
+  fprintf(f, "/* Each <table>_index() returns the position of the len "
+             "bytes at s in\n   its list, or -1.  s needs no NUL "
+             "terminator. */\n");
+  for (size_t t = 0; t < table_count; t++) {
+    if (tables[t].description[0])
+      fprintf(f, "\n/* %s */\n", tables[t].description);
+    else
+      fprintf(f, "\n");
+    fprintf(f, "int %s_index(const char *s, size_t len);\n", tables[t].name);
+  }
+  fprintf(f, "\n#endif /* WORD_TABLES_H */\n");
+  fclose(f);
+  return 0;
+}
+
+static int write_source(const char *dir) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/word_tables.c", dir);
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Error: cannot write %s\n", path);
+    return -1;
+  }
+  fprintf(f, "%s\n#include \"word_tables.h\"\n#include <stdint.h>\n"
+             "#include <string.h>\n\n%s",
+          BANNER, WORD_HASH);
+
+  for (size_t t = 0; t < table_count; t++) {
+    Table *table = &tables[t];
+    char name[64];
+    upper(table->name, name);
+
+    /* Words, their lengths, and the slot each one hashes to */
+    fprintf(f, "\nstatic const char *const %s_WORDS[%zu] = {", name,
+            table->count);
+    size_t col = 80;
+    for (size_t w = 0; w < table->count; w++) {
+      size_t width = strlen(table->words[w]) + 4;
+      if (col + width > 78) {
+        fprintf(f, "\n   ");
+        col = 3;
+      }
+      fprintf(f, " \"%s\",", table->words[w]);
+      col += width;
+    }
+    fprintf(f, "\n};\n");
+
+    fprintf(f, "static const unsigned char %s_LENS[%zu] = {", name,
+            table->count);
+    col = 80;
+    for (size_t w = 0; w < table->count; w++) {
+      if (col + 5 > 78) {
+        fprintf(f, "\n   ");
+        col = 3;
+      }
+      fprintf(f, " %zu,", strlen(table->words[w]));
+      col += 5;
+    }
+    fprintf(f, "\n};\n");
+
+    fprintf(f, "static const short %s_SLOTS[%zu] = {", name, table->size);
+    col = 80;
+    for (size_t i = 0; i < table->size; i++) {
+      if (col + 5 > 78) {
+        fprintf(f, "\n   ");
+        col = 3;
+      }
+      fprintf(f, " %d,", table->slots[i]);
+      col += 5;
+    }
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f,
+            "int %s_index(const char *s, size_t len) {\n"
+            "  int i = %s_SLOTS[word_hash(s, len, %uu) & %zu];\n"
+            "  if (i < 0 || %s_LENS[i] != len ||\n"
+            "      memcmp(%s_WORDS[i], s, len) != 0)\n"
+            "    return -1;\n"
+            "  return i;\n"
+            "}\n",
+            table->name, name, table->seed, table->size - 1, name, name);
+  }
+  fclose(f);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <word_tables.txt> <output dir>\n", argv[0]);
+    return 1;
+  }
+  if (read_tables(argv[1]) == -1)
+    return 1;
+  for (size_t t = 0; t < table_count; t++) {
+    if (place_words(&tables[t]) == -1) {
+      fprintf(stderr, "Error: malloc failed for [%s]\n", tables[t].name);
+      return 1;
+    }
+  }
+  if (write_header(argv[2]) == -1 || write_source(argv[2]) == -1)
+    return 1;
+  printf("Wrote %zu tables to %s/word_tables.[ch]\n", table_count, argv[2]);
+  return 0;
+}
@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+#include "watch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_SETTLE_MS 50 /* Quiet time that ends a burst of events */
+#define WATCH_EVENT_BUFFER (64 * 1024)
+#define INITIAL_WATCH_CAPACITY 64
+
+#define WATCH_MASK                                                           \
+  (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |    \
+   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+struct Watcher {
+  int fd;          /* inotify instance */
+  char **paths;    /* Directory path of each watch descriptor, or NULL */
+  size_t capacity; /* Slots in paths (indexed by wd) */
+  size_t count;    /* Directories currently watched */
+};
+
+Watcher *watcher_create(void) {
+  Watcher *w = calloc(1, sizeof(Watcher));
+  if (!w)
+    return NULL;
+
+  w->fd = inotify_init1(IN_CLOEXEC);
+  w->paths = calloc(INITIAL_WATCH_CAPACITY, sizeof(char *));
+  if (w->fd == -1 || !w->paths) {
+    perror("inotify_init1");
+    if (w->fd != -1)
+      close(w->fd);
+    free(w->paths);
+    free(w);
+    return NULL;
+  }
+  w->capacity = INITIAL_WATCH_CAPACITY;
+  return w;
+}
+
+void watcher_free(Watcher *watcher) {
+  if (!watcher)
+    return;
+  for (size_t i = 0; i < watcher->capacity; i++)
+    free(watcher->paths[i]);
+  free(watcher->paths);
+  close(watcher->fd); /* Drops every watch */
+  free(watcher);
+}
+
+int watcher_add_dir(Watcher *watcher, const char *path) {
+  int wd = inotify_add_watch(watcher->fd, path, WATCH_MASK);
+  if (wd < 0) {
+    if (errno == ENOSPC)
+      fprintf(stderr, "Error: Out of inotify watches "
+                      "(raise fs.inotify.max_user_watches)\n");
+    return -1;
+  }
+
+  /* Step 1: Grow the wd -> path table */
+  if ((size_t)wd >= watcher->capacity) {
+    size_t new_capacity = watcher->capacity * 2;
+    while (new_capacity <= (size_t)wd)
+      new_capacity *= 2;
+    char **grown = realloc(watcher->paths, new_capacity * sizeof(char *));
+    if (!grown)
+      return -1;
+    memset(grown + watcher->capacity, 0,
+           (new_capacity - watcher->capacity) * sizeof(char *));
+    watcher->paths = grown;
+    watcher->capacity = new_capacity;
+  }
+
+  /* Step 2: Same inode again (or renamed) - refresh the path */
+  char *copy = malloc(strlen(path) + 1);
+  if (!copy)
+    return -1;
+  strcpy(copy, path);
+  if (!watcher->paths[wd])
+    watcher->count++;
+  free(watcher->paths[wd]);
+  watcher->paths[wd] = copy;
+  return 0;
+}
+
+size_t watcher_count(const Watcher *watcher) {
+  return watcher ? watcher->count : 0;
+}
+
+/* Handles one event; returns 1 if the tree structure changed */
+static int watcher_handle(Watcher *watcher, const struct inotify_event *ev,
+                          DynamicArray *changed) {
+  if (ev->mask & IN_Q_OVERFLOW)
+    return 1; /* Events were lost - walk everything again */
+
+  if (ev->wd < 0 || (size_t)ev->wd >= watcher->capacity)
+    return 0;
+
+  /* The kernel dropped the watch (directory deleted or unmounted) */
+  if (ev->mask & IN_IGNORED) {
+    if (watcher->paths[ev->wd]) {
+      free(watcher->paths[ev->wd]);
+      watcher->paths[ev->wd] = NULL;
+      watcher->count--;
+    }
+    return 1;
+  }
+
+  if (ev->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                  IN_DELETE_SELF | IN_MOVE_SELF))
+    return 1;
+
+  /* A file was written in place: only it needs scanning again */
+  const char *dir = watcher->paths[ev->wd];
+  if ((ev->mask & IN_CLOSE_WRITE) && dir && ev->len > 0) {
+    size_t dir_len = strlen(dir), name_len = strlen(ev->name);
+    char *full = malloc(dir_len + 1 + name_len + 1);
+    if (full) {
+      memcpy(full, dir, dir_len);
+      full[dir_len] = '/';
+      memcpy(full + dir_len + 1, ev->name, name_len + 1);
+      da_append(changed, full);
+      free(full);
+    }
+  }
+  return 0;
+}
+
+int watcher_wait(Watcher *watcher, DynamicArray *changed) {
+  /* Aligned for struct inotify_event */
+  static long long buffer[WATCH_EVENT_BUFFER / sizeof(long long)];
+  int structural = 0;
+  int timeout = -1; /* Block until the first event */
+
+  for (;;) {
+    struct pollfd pfd = {.fd = watcher->fd, .events = POLLIN, .revents = 0};
+    int ready = poll(&pfd, 1, timeout);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("poll");
+      return -1;
+    }
+    if (ready == 0)
+      return structural; /* Quiet again - the burst is over */
+
+    ssize_t len = read(watcher->fd, buffer, sizeof(buffer));
+    if (len < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      perror("read");
+      return -1;
+    }
+
+    const char *p = (const char *)buffer;
+    const char *end = p + len;
+    while (p < end) {
+      const struct inotify_event *ev = (const struct inotify_event *)p;
+      structural |= watcher_handle(watcher, ev, changed);
+      p += sizeof(struct inotify_event) + ev->len;
+    }
+    timeout = WATCH_SETTLE_MS;
+  }
+}
+
+#else /* !__linux__ */
+
+Watcher *watcher_create(void) {
+  fprintf(stderr, "Error: --watch is only supported on Linux\n");
+  return NULL;
+}
+
+void watcher_free(Watcher *watcher) { (void)watcher; }
+
+int watcher_add_dir(Watcher *watcher, const char *path) {
+  (void)watcher;
+  (void)path;
+  return -1;
+}
+
+size_t watcher_count(const Watcher *watcher) {
+  (void)watcher;
+  return 0;
+}
+
+int watcher_wait(Watcher *watcher, DynamicArray *changed) {
+  (void)watcher;
+  (void)changed;
+  return -1;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "data_structs.h"
+
+/* Directory change notifications (inotify).  Only available on Linux;
+   elsewhere watcher_create() reports an error and returns NULL.     */
+typedef struct Watcher Watcher;
+
+Watcher *watcher_create(void);
+void watcher_free(Watcher *watcher);
+
+/* Starts watching one directory (not its subdirectories).  Adding a
+   directory that is already watched just refreshes its path.        */
+int watcher_add_dir(Watcher *watcher, const char *path);
+
+/* Number of directories currently watched */
+size_t watcher_count(const Watcher *watcher);
+
+/* Blocks until something changes, then keeps collecting events until
+   the tree has been quiet for a moment (editors save in bursts).
+   Paths of files rewritten in place are appended to changed.
+   Returns 1 if entries were created, removed or renamed (the tree must
+   be walked again), 0 if only file contents changed, -1 on error.    */
+int watcher_wait(Watcher *watcher, DynamicArray *changed);
+
+#endif /* WATCH_H */
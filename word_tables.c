@@ -0,0 +1,220 @@
+/* Generated by tools/gen_word_tables.c from tools/word_tables.txt.
+   Change the list there and regenerate rather than editing this.  */
+
+#include "word_tables.h"
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t word_hash(const char *s, size_t len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+static const char *const TS_KEYWORD_WORDS[62] = {
+    "Promise", "void", "string", "number", "boolean", "object", "symbol",
+    "bigint", "never", "unknown", "any", "undefined", "null", "Array",
+    "Record", "Partial", "Required", "Readonly", "ReadonlyArray", "Pick",
+    "Omit", "Exclude", "Extract", "NonNullable", "ReturnType", "InstanceType",
+    "Parameters", "ConstructorParameters", "Awaited", "Uppercase",
+    "Lowercase", "Capitalize", "Uncapitalize", "ReactNode", "ReactElement",
+    "ReactChild", "ReactFragment", "ReactPortal", "ReactDOM", "RefObject",
+    "MutableRefObject", "CSSProperties", "MouseEvent", "KeyboardEvent",
+    "ChangeEvent", "FormEvent", "FocusEvent", "SubmitEvent", "SyntheticEvent",
+    "UseFormReturn", "FieldValues", "Resolver", "DefaultValues",
+    "HTMLElement", "HTMLDivElement", "HTMLInputElement", "HTMLButtonElement",
+    "EventTarget", "NodeList", "Element", "Document", "Window",
+};
+static const unsigned char TS_KEYWORD_LENS[62] = {
+    7, 4, 6, 6, 7, 6, 6, 6, 5, 7, 3, 9, 4, 5, 6,
+    7, 8, 8, 13, 4, 4, 7, 7, 11, 10, 12, 10, 21, 7, 9,
+    9, 10, 12, 9, 12, 10, 13, 11, 8, 9, 16, 13, 10, 13, 11,
+    9, 10, 11, 14, 13, 11, 8, 13, 11, 14, 16, 17, 11, 8, 7,
+    8, 6,
+};
+static const short TS_KEYWORD_SLOTS[256] = {
+    -1, 46, -1, -1, -1, -1, -1, -1, -1, -1, -1, 32, 57, -1, -1,
+    42, -1, -1, -1, 6, -1, 33, -1, 28, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, -1, -1, -1, 54,
+    -1, -1, -1, -1, 61, 12, -1, -1, -1, 45, -1, -1, -1, 30, 47,
+    -1, 59, 7, -1, -1, -1, -1, -1, -1, -1, -1, 49, 1, 44, -1,
+    -1, -1, 25, 18, -1, 14, -1, -1, -1, -1, 60, -1, 10, 36, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 22, -1, -1, -1,
+    -1, -1, -1, 3, -1, -1, 8, -1, -1, -1, 37, -1, -1, 23, 56,
+    -1, -1, -1, 50, 51, -1, 16, 38, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, 31, 21, 13, -1, 15, -1, -1, -1, -1, -1, -1, 58, 41,
+    -1, -1, -1, 39, -1, 53, -1, -1, -1, -1, -1, -1, 2, 11, 40,
+    -1, -1, -1, -1, -1, -1, 27, -1, -1, -1, -1, -1, 55, -1, 24,
+    -1, -1, -1, -1, 0, -1, -1, -1, -1, -1, -1, 17, -1, -1, 29,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 20, -1, -1, -1, 52,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, 34, -1, -1, -1, -1, -1,
+    -1, -1, 43, -1, -1, -1, -1, -1, -1, -1, 26, -1, 5, -1, 48,
+    -1, -1, -1, -1, -1, -1, 35, -1, -1, 9, -1, 19, -1, -1, -1,
+    -1,
+};
+
+int ts_keyword_index(const char *s, size_t len) {
+  int i = TS_KEYWORD_SLOTS[word_hash(s, len, 7325u) & 255];
+  if (i < 0 || TS_KEYWORD_LENS[i] != len ||
+      memcmp(TS_KEYWORD_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const FLAGGED_PROP_WORDS[12] = {
+    "placeholder", "aria-label", "title", "alt", "label", "description",
+    "tooltip", "hint", "errorMessage", "helperText", "emptyMessage",
+    "noResultsMessage",
+};
+static const unsigned char FLAGGED_PROP_LENS[12] = {
+    11, 10, 5, 3, 5, 11, 7, 4, 12, 10, 12, 16,
+};
+static const short FLAGGED_PROP_SLOTS[32] = {
+    -1, -1, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 4, -1,
+    11, -1, -1, -1, 1, 6, 7, 2, -1, 5, 8, -1, -1, -1, -1,
+    9, 0,
+};
+
+int flagged_prop_index(const char *s, size_t len) {
+  int i = FLAGGED_PROP_SLOTS[word_hash(s, len, 8u) & 31];
+  if (i < 0 || FLAGGED_PROP_LENS[i] != len ||
+      memcmp(FLAGGED_PROP_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const TOAST_METHOD_WORDS[5] = {
+    "success", "error", "warning", "info", "message",
+};
+static const unsigned char TOAST_METHOD_LENS[5] = {
+    7, 5, 7, 4, 7,
+};
+static const short TOAST_METHOD_SLOTS[16] = {
+    2, 3, 4, -1, -1, -1, -1, 1, -1, 0, -1, -1, -1, -1, -1,
+    -1,
+};
+
+int toast_method_index(const char *s, size_t len) {
+  int i = TOAST_METHOD_SLOTS[word_hash(s, len, 3u) & 15];
+  if (i < 0 || TOAST_METHOD_LENS[i] != len ||
+      memcmp(TOAST_METHOD_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const SET_FUNC_WORDS[7] = {
+    "setError", "setWarning", "setMessage", "setSuccess", "setInfo",
+    "setTitle", "setDescription",
+};
+static const unsigned char SET_FUNC_LENS[7] = {
+    8, 10, 10, 10, 7, 8, 14,
+};
+static const short SET_FUNC_SLOTS[16] = {
+    -1, 0, 2, 3, 5, -1, -1, -1, -1, 4, -1, -1, 1, 6, -1,
+    -1,
+};
+
+int set_func_index(const char *s, size_t len) {
+  int i = SET_FUNC_SLOTS[word_hash(s, len, 1u) & 15];
+  if (i < 0 || SET_FUNC_LENS[i] != len ||
+      memcmp(SET_FUNC_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const ZOD_KEY_WORDS[3] = {
+    "message", "required_error", "invalid_type_error",
+};
+static const unsigned char ZOD_KEY_LENS[3] = {
+    7, 14, 18,
+};
+static const short ZOD_KEY_SLOTS[8] = {
+    -1, -1, 1, -1, 2, -1, -1, 0,
+};
+
+int zod_key_index(const char *s, size_t len) {
+  int i = ZOD_KEY_SLOTS[word_hash(s, len, 1u) & 7];
+  if (i < 0 || ZOD_KEY_LENS[i] != len ||
+      memcmp(ZOD_KEY_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const ZOD_TWO_ARG_WORDS[4] = {
+    "min", "max", "length", "refine",
+};
+static const unsigned char ZOD_TWO_ARG_LENS[4] = {
+    3, 3, 6, 6,
+};
+static const short ZOD_TWO_ARG_SLOTS[8] = {
+    3, 0, 1, -1, -1, -1, -1, 2,
+};
+
+int zod_two_arg_index(const char *s, size_t len) {
+  int i = ZOD_TWO_ARG_SLOTS[word_hash(s, len, 1u) & 7];
+  if (i < 0 || ZOD_TWO_ARG_LENS[i] != len ||
+      memcmp(ZOD_TWO_ARG_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const ZOD_ONE_ARG_WORDS[6] = {
+    "email", "url", "uuid", "cuid", "datetime", "ip",
+};
+static const unsigned char ZOD_ONE_ARG_LENS[6] = {
+    5, 3, 4, 4, 8, 2,
+};
+static const short ZOD_ONE_ARG_SLOTS[16] = {
+    -1, -1, -1, 0, 5, 4, -1, -1, -1, 1, 3, -1, 2, -1, -1,
+    -1,
+};
+
+int zod_one_arg_index(const char *s, size_t len) {
+  int i = ZOD_ONE_ARG_SLOTS[word_hash(s, len, 2u) & 15];
+  if (i < 0 || ZOD_ONE_ARG_LENS[i] != len ||
+      memcmp(ZOD_ONE_ARG_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const THROW_CLASS_WORDS[3] = {
+    "Error", "TypeError", "RangeError",
+};
+static const unsigned char THROW_CLASS_LENS[3] = {
+    5, 9, 10,
+};
+static const short THROW_CLASS_SLOTS[8] = {
+    0, -1, -1, -1, 2, 1, -1, -1,
+};
+
+int throw_class_index(const char *s, size_t len) {
+  int i = THROW_CLASS_SLOTS[word_hash(s, len, 1u) & 7];
+  if (i < 0 || THROW_CLASS_LENS[i] != len ||
+      memcmp(THROW_CLASS_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
+
+static const char *const EXPR_KEYWORD_WORDS[14] = {
+    "return", "typeof", "instanceof", "in", "of", "new", "delete", "void",
+    "throw", "case", "do", "else", "yield", "await",
+};
+static const unsigned char EXPR_KEYWORD_LENS[14] = {
+    6, 6, 10, 2, 2, 3, 6, 4, 5, 4, 2, 4, 5, 5,
+};
+static const short EXPR_KEYWORD_SLOTS[32] = {
+    0, 10, 11, -1, -1, -1, 12, 4, -1, 8, -1, -1, 2, 7, -1,
+    -1, 13, -1, 9, -1, -1, -1, -1, 3, -1, -1, 5, 1, -1, -1,
+    -1, 6,
+};
+
+int expr_keyword_index(const char *s, size_t len) {
+  int i = EXPR_KEYWORD_SLOTS[word_hash(s, len, 18u) & 31];
+  if (i < 0 || EXPR_KEYWORD_LENS[i] != len ||
+      memcmp(EXPR_KEYWORD_WORDS[i], s, len) != 0)
+    return -1;
+  return i;
+}
@@ -0,0 +1,39 @@
+#ifndef WORD_TABLES_H
+#define WORD_TABLES_H
+
+/* Generated by tools/gen_word_tables.c from tools/word_tables.txt.
+   Change the list there and regenerate rather than editing this.  */
+
+#include <stddef.h>
+
+/* Each <table>_index() returns the position of the len bytes at s in
+   its list, or -1.  s needs no NUL terminator. */
+
+/* TypeScript / JS types and keywords never taken for human text */
+int ts_keyword_index(const char *s, size_t len);
+
+/* Pattern 2 - props whose string value is shown to the user */
+int flagged_prop_index(const char *s, size_t len);
+
+/* Pattern 3 - toast.<method>("literal") */
+int toast_method_index(const char *s, size_t len);
+
+/* Pattern 4 - state setters holding user-facing text */
+int set_func_index(const char *s, size_t len);
+
+/* Pattern 5 - Zod option keys holding a message */
+int zod_key_index(const char *s, size_t len);
+
+/* Pattern 5 - Zod validators whose 2nd argument is the message */
+int zod_two_arg_index(const char *s, size_t len);
+
+/* Pattern 5 - Zod validators whose only argument is the message */
+int zod_one_arg_index(const char *s, size_t len);
+
+/* Pattern 7 - throw new <class>("literal") */
+int throw_class_index(const char *s, size_t len);
+
+/* Words after which an expression (so a regex or a JSX tag) may start */
+int expr_keyword_index(const char *s, size_t len);
+
+#endif /* WORD_TABLES_H */